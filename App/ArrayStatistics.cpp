@@ -0,0 +1,153 @@
+#include "ArrayStatistics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "ArrayValues.hpp"
+#include "Parallel.hpp"
+
+namespace {
+
+struct Partial {
+    double min = std::numeric_limits<double>::max();
+    double max = std::numeric_limits<double>::lowest();
+    double sum = 0.0;
+    uint64_t count = 0;
+};
+
+// Magnitudes are recomputed in the second pass instead of being stored,
+// so the statistics never need a copy of the array
+template<typename T>
+ArraySummary summarize(const T* data, size_t tuples, int numComp, int comp)
+{
+    ArraySummary result;
+    const int chunks = std::max(1, std::min(Parallel::maxThreads(), static_cast<int>(tuples / 65536) + 1));
+
+    // Pass 1: per-chunk min, max, sum and count
+    std::vector<Partial> partials(chunks);
+    #pragma omp parallel for schedule(static, 1) num_threads(chunks)
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        Partial p;
+        size_t begin, end;
+        Parallel::chunkRange(tuples, chunks, chunk, begin, end);
+        for (size_t t = begin; t < end; ++t) {
+            const double v = ArrayValues::tupleValue(data, t, numComp, comp);
+            if (!std::isfinite(v)) continue;
+            p.min = std::min(p.min, v);
+            p.max = std::max(p.max, v);
+            p.sum += v;
+            ++p.count;
+        }
+        partials[chunk] = p;
+    }
+
+    Partial total;
+    for (const Partial& p : partials) {
+        total.min = std::min(total.min, p.min);
+        total.max = std::max(total.max, p.max);
+        total.sum += p.sum;
+        total.count += p.count;
+    }
+    if (total.count == 0) return result;
+
+    result.min = total.min;
+    result.max = total.max;
+    result.mean = total.sum / static_cast<double>(total.count);
+    result.count = total.count;
+
+    // Pass 2: per-chunk histograms over [min, max], summed afterwards
+    const int bins = ArraySummary::kBins;
+    const double width = total.max - total.min;
+    const double scale = (width > 0.0) ? bins / width : 0.0;
+    std::vector<uint64_t> histograms(static_cast<size_t>(chunks) * bins, 0);
+    #pragma omp parallel for schedule(static, 1) num_threads(chunks)
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        uint64_t* hist = &histograms[static_cast<size_t>(chunk) * bins];
+        size_t begin, end;
+        Parallel::chunkRange(tuples, chunks, chunk, begin, end);
+        for (size_t t = begin; t < end; ++t) {
+            const double v = ArrayValues::tupleValue(data, t, numComp, comp);
+            if (!std::isfinite(v)) continue;
+            const int bin = static_cast<int>((v - total.min) * scale);
+            ++hist[std::min(bin, bins - 1)];
+        }
+    }
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        for (int b = 0; b < bins; ++b) {
+            result.histogram[b] += histograms[static_cast<size_t>(chunk) * bins + b];
+        }
+    }
+
+    // Quantiles from a strided sample; sorting at most kMaxSamples values is cheap
+    const size_t stride = std::max<size_t>(1, (tuples + ArraySummary::kMaxSamples - 1) / ArraySummary::kMaxSamples);
+    const int64_t sampleCount = static_cast<int64_t>((tuples + stride - 1) / stride);
+    std::vector<double> samples(static_cast<size_t>(sampleCount));
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < sampleCount; ++i) {
+        samples[i] = ArrayValues::tupleValue(data, static_cast<size_t>(i) * stride, numComp, comp);
+    }
+    samples.erase(std::remove_if(samples.begin(), samples.end(), [](double v) { return !std::isfinite(v); }),
+                  samples.end());
+    std::sort(samples.begin(), samples.end());
+    if (!samples.empty()) {
+        result.quantiles.resize(ArraySummary::kQuantileSteps + 1);
+        const double last = static_cast<double>(samples.size() - 1);
+        for (int q = 0; q <= ArraySummary::kQuantileSteps; ++q) {
+            const double pos = last * q / ArraySummary::kQuantileSteps;
+            const size_t lo = static_cast<size_t>(pos);
+            const size_t hi = std::min(lo + 1, samples.size() - 1);
+            result.quantiles[q] = samples[lo] + (samples[hi] - samples[lo]) * (pos - static_cast<double>(lo));
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+double ArraySummary::percentile(double p) const
+{
+    if (quantiles.empty()) return 0.0;
+
+    const double pos = std::max(0.0, std::min(1.0, p)) * kQuantileSteps;
+    const int lo = std::min(static_cast<int>(pos), kQuantileSteps - 1);
+    return quantiles[lo] + (quantiles[lo + 1] - quantiles[lo]) * (pos - lo);
+}
+
+ArrayStatistics& ArrayStatistics::of(UnstructuredGrid& grid)
+{
+    if (!grid.statistics) {
+        grid.statistics = std::make_shared<ArrayStatistics>();
+    }
+    return *grid.statistics;
+}
+
+const ArraySummary& ArrayStatistics::summary(const DataArray& array, int component)
+{
+    const int numComp = std::max(1, static_cast<int>(array.num_components));
+    const auto key = std::make_pair(&array, ArrayValues::effectiveComponent(numComp, component));
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_cache.find(key);
+        if (it != m_cache.end()) return it->second;
+    }
+
+    // Computed outside the lock; if two threads race, the first result is kept
+    ArraySummary computed = compute(array, key.second);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_cache.emplace(key, computed).first->second;
+}
+
+ArraySummary ArrayStatistics::compute(const DataArray& array, int component)
+{
+    const int numComp = std::max(1, static_cast<int>(array.num_components));
+    const int comp = ArrayValues::effectiveComponent(numComp, component);
+    const size_t tuples = static_cast<size_t>(std::max<int64_t>(array.num_tuples, 0));
+
+    ArraySummary result;
+    ArrayValues::withData(array, [&](const auto* data, size_t size) {
+        result = summarize(data, std::min(tuples, size / numComp), numComp, comp);
+    });
+    return result;
+}
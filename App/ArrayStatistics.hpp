@@ -0,0 +1,53 @@
+#ifndef ARRAYSTATISTICS_HPP
+#define ARRAYSTATISTICS_HPP
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "Loader.hpp"
+
+// Summary of one component of an array, or of its magnitude.
+// Non-finite values are ignored.
+struct ArraySummary {
+    static constexpr int kBins = 256;
+    static constexpr int kQuantileSteps = 1000;  // Quantiles stored every 0.1%
+    static constexpr size_t kMaxSamples = 1 << 18;
+
+    double min = 0.0;
+    double max = 0.0;
+    double mean = 0.0;
+    uint64_t count = 0;                       // Number of finite values
+    std::array<uint64_t, kBins> histogram{};  // Equal-width bins over [min, max]
+
+    // Quantiles of an evenly strided sample of at most kMaxSamples values.
+    // Unlike the histogram they are not skewed by a few extreme outliers.
+    std::vector<double> quantiles;
+
+    // Approximate p-quantile (p in [0, 1])
+    double percentile(double p) const;
+};
+
+// Statistics of the arrays of one grid, computed in parallel on first request and cached.
+// Thread-safe. Entries are keyed by array, so they stay valid while the grid owns the array.
+class ArrayStatistics
+{
+public:
+    // The grid's cache, created on first use
+    static ArrayStatistics& of(UnstructuredGrid& grid);
+
+    // component < 0 selects the magnitude of vector arrays; scalar arrays ignore it
+    const ArraySummary& summary(const DataArray& array, int component);
+
+    // Uncached computation: a min/max/sum pass, then a histogram pass
+    static ArraySummary compute(const DataArray& array, int component);
+
+private:
+    std::mutex m_mutex;
+    std::map<std::pair<const DataArray*, int>, ArraySummary> m_cache;
+};
+
+#endif //ARRAYSTATISTICS_HPP
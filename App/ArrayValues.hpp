@@ -0,0 +1,49 @@
+#ifndef ARRAYVALUES_HPP
+#define ARRAYVALUES_HPP
+
+#include <cmath>
+#include <cstddef>
+#include "Loader.hpp"
+
+// Typed reads of a DataArray's tuples, shared by the color mapping and the statistics
+// so both see the same component, or the same magnitude, of every tuple.
+namespace ArrayValues {
+
+// Calls fn(data, size) with the array's typed storage
+template<typename Fn>
+void withData(const DataArray& array, Fn fn)
+{
+    if (array.data_type == "float") {
+        fn(array.data_float.data(), array.data_float.size());
+    } else if (array.data_type == "double") {
+        fn(array.data_double.data(), array.data_double.size());
+    } else if (array.data_type == "int") {
+        fn(array.data_int32.data(), array.data_int32.size());
+    } else if (array.data_type == "vtktypeint64") {
+        fn(array.data_int64.data(), array.data_int64.size());
+    }
+}
+
+// Component actually read: 0 for scalar arrays, -1 (magnitude) when out of range
+inline int effectiveComponent(int numComp, int component)
+{
+    if (numComp == 1) return 0;
+    return (component >= 0 && component < numComp) ? component : -1;
+}
+
+// Value of tuple t: one component, or the magnitude when comp < 0 (summed in double)
+template<typename T>
+inline double tupleValue(const T* data, size_t t, int numComp, int comp)
+{
+    if (comp >= 0) return static_cast<double>(data[t * numComp + comp]);
+    double sumSq = 0.0;
+    for (int c = 0; c < numComp; ++c) {
+        const double v = static_cast<double>(data[t * numComp + c]);
+        sumSq += v * v;
+    }
+    return std::sqrt(sumSq);
+}
+
+} // namespace ArrayValues
+
+#endif // ARRAYVALUES_HPP
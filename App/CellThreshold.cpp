@@ -0,0 +1,41 @@
+#include "CellThreshold.hpp"
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(cellThresholdLog, "VTKViewer.CellThreshold")
+
+void CellThreshold::reset()
+{
+    m_order.setKeys(std::vector<float>());
+    m_hasValues = false;
+    m_changedCount = 0;
+}
+
+void CellThreshold::setValues(const std::vector<float>& values)
+{
+    QElapsedTimer timer;
+    timer.start();
+    m_subset.clearFilter(SubsetSurface::ThresholdFilter);
+    m_order.setKeys(values);
+    m_hasValues = true;
+    qInfo(cellThresholdLog) << "Threshold order" << m_order.size() << "cells in" << timer.elapsed() << "ms";
+}
+
+void CellThreshold::valueRange(float& min, float& max) const
+{
+    min = m_order.lowest();
+    max = m_order.highest();
+}
+
+bool CellThreshold::apply(float low, float high)
+{
+    if (!m_hasValues || !m_subset.prepare()) return false;
+    m_changedCount = m_order.select(low, high, m_subset, SubsetSurface::ThresholdFilter);
+    return true;
+}
+
+void CellThreshold::release()
+{
+    m_changedCount = m_subset.clearFilter(SubsetSurface::ThresholdFilter);
+    m_order.reset();
+}
@@ -0,0 +1,40 @@
+#ifndef CELLTHRESHOLD_HPP
+#define CELLTHRESHOLD_HPP
+
+#include <cstddef>
+#include <vector>
+#include "SubsetSurface.hpp"
+
+// Keeps the cells whose value lies in [low, high], through the ThresholdFilter bit of a
+// SubsetSurface. Cells are sorted by value once per array, so changing the range only
+// drops or restores the cells between the old and the new bounds.
+class CellThreshold
+{
+public:
+    explicit CellThreshold(SubsetSurface& subset) : m_subset(subset) {}
+
+    void reset();  // After the subset's grid changed; drops the values
+
+    // One value per cell (NaN is never kept); the previous values stop rejecting cells
+    void setValues(const std::vector<float>& values);
+    bool hasValues() const { return m_hasValues; }
+
+    // Range of the values (min > max without any)
+    void valueRange(float& min, float& max) const;
+
+    // Moves the range; false if the grid's cells can't be used
+    bool apply(float low, float high);
+
+    // Stops rejecting cells
+    void release();
+
+    size_t changedCount() const { return m_changedCount; }  // Cells flipped by the last apply()
+
+private:
+    SubsetSurface& m_subset;
+    SortedCellRange m_order;
+    bool m_hasValues = false;
+    size_t m_changedCount = 0;
+};
+
+#endif // CELLTHRESHOLD_HPP
@@ -0,0 +1,217 @@
+#include "CellToPoint.hpp"
+#include "CellTopology.hpp"
+#include "MeshProcessor.hpp"
+#include "PointCells.hpp"
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+Q_LOGGING_CATEGORY(cellToPointLog, "VTKViewer.CellToPoint")
+
+namespace {
+
+inline const float* at(const std::vector<float>& positions, uint32_t p)
+{
+    return &positions[static_cast<size_t>(p) * 3];
+}
+
+inline float distance(const float* a, const float* b)
+{
+    const float d[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    return std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+}
+
+inline float triangleArea(const float* a, const float* b, const float* c)
+{
+    const float e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    const float e2[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+    const float n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+    return 0.5f * std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+}
+
+// Sums the area of the faces of a 2D cell; quads split like the boundary surface
+struct AreaSink {
+    const std::vector<float>& positions;
+    float area;
+    void tri(uint32_t a, uint32_t b, uint32_t c) {
+        area += triangleArea(at(positions, a), at(positions, b), at(positions, c));
+    }
+    void quad(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+        tri(a, b, c);
+        tri(a, c, d);
+    }
+};
+
+// Signed volume enclosed by the faces of a polyhedron (divergence theorem)
+struct VolumeSink {
+    const std::vector<float>& positions;
+    float volume;
+    void tri(uint32_t a, uint32_t b, uint32_t c) {
+        const float* p = at(positions, a);
+        const float* q = at(positions, b);
+        const float* r = at(positions, c);
+        volume += (p[0] * (q[1] * r[2] - q[2] * r[1])
+                 - p[1] * (q[0] * r[2] - q[2] * r[0])
+                 + p[2] * (q[0] * r[1] - q[1] * r[0])) / 6.0f;
+    }
+    void quad(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+        tri(a, b, c);
+        tri(a, c, d);
+    }
+};
+
+} // namespace
+
+namespace CellToPoint {
+
+void cellMeasures(const UnstructuredGrid& grid, const std::vector<size_t>& cellOffsets,
+                  const std::vector<float>& positions,
+                  std::vector<float>& measures, std::vector<uint8_t>& dimensions)
+{
+    using namespace CellTopology;
+    const int64_t numCells = static_cast<int64_t>(std::min(cellOffsets.size(), grid.cell_types.size()));
+    const uint32_t numPoints = static_cast<uint32_t>(positions.size() / 3);
+    measures.assign(cellOffsets.size(), 0.0f);
+    dimensions.assign(cellOffsets.size(), 0);
+
+    #pragma omp parallel for schedule(static)
+    for (int64_t c = 0; c < numCells; ++c) {
+        const int32_t* record = &grid.cells[cellOffsets[c]];
+        const int32_t n = record[0];
+        const uint8_t type = grid.cell_types[c];
+        bool valid = true;
+        visitPointSlots(type, record, [&](int32_t k) {
+            valid = valid && record[k] >= 0 && static_cast<uint32_t>(record[k]) < numPoints;
+        });
+        if (!valid) continue;
+        const int dimension = cellDimension(type);
+
+        const uint8_t* corners = nullptr;
+        const int tets = tetrahedra(type, n, corners);
+        if (tets > 0) {
+            float volume = 0.0f;
+            for (int t = 0; t < tets; ++t) {
+                const float* p0 = at(positions, static_cast<uint32_t>(record[1 + corners[t * 4]]));
+                float e[3][3];
+                for (int k = 0; k < 3; ++k) {
+                    const float* p = at(positions, static_cast<uint32_t>(record[1 + corners[t * 4 + k + 1]]));
+                    for (int a = 0; a < 3; ++a) e[k][a] = p[a] - p0[a];
+                }
+                const float det = e[0][0] * (e[1][1] * e[2][2] - e[1][2] * e[2][1])
+                                - e[0][1] * (e[1][0] * e[2][2] - e[1][2] * e[2][0])
+                                + e[0][2] * (e[1][0] * e[2][1] - e[1][1] * e[2][0]);
+                volume += std::fabs(det) / 6.0f;
+            }
+            measures[c] = volume;
+            dimensions[c] = 3;
+        } else if (dimension == 3 && cellFaceCount(type, n, record + 1) > 0) {
+            // Polyhedra; faces wound inconsistently only make the volume rougher
+            VolumeSink sink{positions, 0.0f};
+            visitCellFaces(type, n, record + 1, sink);
+            measures[c] = std::fabs(sink.volume);
+            dimensions[c] = 3;
+        } else if (dimension == 2 && cellFaceCount(type, n, record + 1) > 0) {
+            AreaSink sink{positions, 0.0f};
+            visitCellFaces(type, n, record + 1, sink);
+            measures[c] = sink.area;
+            dimensions[c] = 2;
+        } else if (dimension == 1) {
+            // Along the interior nodes of quadratic and cubic lines
+            float length = 0.0f;
+            const float* previous = nullptr;
+            int points = 0;
+            visitCellPath(type, n, record + 1, true, [&](uint32_t p) {
+                if (previous) length += distance(previous, at(positions, p));
+                previous = at(positions, p);
+                ++points;
+            });
+            if (points < 2) continue;
+            measures[c] = length;
+            dimensions[c] = 1;
+        } else if (dimension == 0 && n >= 1) {
+            measures[c] = 1.0f;
+        }
+    }
+}
+
+DataArray interpolate(UnstructuredGrid& grid, const DataArray& cellArray)
+{
+    DataArray result;
+    result.name = pointArrayName(cellArray.name);
+    result.data_type = "float";
+    result.num_components = std::max<int64_t>(cellArray.num_components, 1);
+    result.num_tuples = 0;
+    if (!grid.points) return result;
+
+    QElapsedTimer timer;
+    timer.start();
+    const size_t numPoints = static_cast<size_t>(std::max<int64_t>(grid.num_points, 0));
+    const std::vector<float> positions = CellTopology::pointPositions(*grid.points, numPoints);
+    if (positions.empty()) return result;
+    const std::vector<size_t> cellOffsets = CellTopology::cellOffsets(grid);
+    std::vector<float> measures;
+    std::vector<uint8_t> dimensions;
+    cellMeasures(grid, cellOffsets, positions, measures, dimensions);
+    const PointCells& adjacency = PointCells::of(grid);
+    const size_t numCells = measures.size();
+
+    // Highest dimension among each point's cells; lower ones don't take part
+    const int64_t count = static_cast<int64_t>(std::min(numPoints, adjacency.pointCount()));
+    std::vector<uint8_t> pointDimensions(static_cast<size_t>(count), 0);
+    #pragma omp parallel for schedule(static)
+    for (int64_t p = 0; p < count; ++p) {
+        uint8_t dimension = 0;
+        for (const uint32_t* c = adjacency.cellsBegin(p); c != adjacency.cellsEnd(p); ++c) {
+            if (*c < numCells) dimension = std::max(dimension, dimensions[*c]);
+        }
+        pointDimensions[p] = dimension;
+    }
+
+    // One gather per component; each point is written by one thread only
+    const int numComp = static_cast<int>(result.num_components);
+    result.num_tuples = static_cast<int64_t>(numPoints);
+    result.data_float.assign(numPoints * numComp, 0.0f);
+    for (int comp = 0; comp < numComp; ++comp) {
+        const std::vector<float> values = MeshProcessor::tupleValues(cellArray, comp);
+        const size_t numValues = std::min(values.size(), numCells);
+        #pragma omp parallel for schedule(static)
+        for (int64_t p = 0; p < count; ++p) {
+            double weighted = 0.0, weights = 0.0, sum = 0.0;
+            size_t used = 0;
+            for (const uint32_t* c = adjacency.cellsBegin(p); c != adjacency.cellsEnd(p); ++c) {
+                if (*c >= numValues || dimensions[*c] != pointDimensions[p] || !std::isfinite(values[*c])) continue;
+                weighted += static_cast<double>(measures[*c]) * values[*c];
+                weights += measures[*c];
+                sum += values[*c];
+                ++used;
+            }
+            const double value = weights > 0.0 ? weighted / weights : used > 0 ? sum / used : 0.0;
+            result.data_float[static_cast<size_t>(p) * numComp + comp] = static_cast<float>(value);
+        }
+    }
+    qInfo(cellToPointLog) << "Interpolated" << QString::fromStdString(cellArray.name) << "onto" << numPoints
+                          << "points in" << timer.elapsed() << "ms";
+    return result;
+}
+
+std::string pointArrayName(const std::string& cellArrayName)
+{
+    return cellArrayName + " (插值)";
+}
+
+bool addPointArray(UnstructuredGrid& grid, const std::string& cellArrayName)
+{
+    const std::string name = pointArrayName(cellArrayName);
+    if (grid.point_data.count(name)) return true;
+    auto it = grid.cell_data.find(cellArrayName);
+    if (it == grid.cell_data.end() || !it->second) return false;
+
+    auto array = std::make_shared<DataArray>(interpolate(grid, *it->second));
+    if (array->num_tuples == 0 && grid.num_points > 0) return false;
+    grid.point_data[name] = array;
+    return true;
+}
+
+} // namespace CellToPoint
@@ -0,0 +1,36 @@
+#ifndef CELLTOPOINT_HPP
+#define CELLTOPOINT_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Loader.hpp"
+
+// Cell data averaged onto the points, for smooth coloring of cell arrays.
+// Each point gathers the cells around it through the grid's PointCells adjacency (one
+// thread per point range, no atomics). Only the highest-dimensional cells at a point
+// count, weighted by their volume / area / length, so shells glued to solids or beams
+// along edges don't dilute the solid's values with incomparable measures.
+namespace CellToPoint {
+
+// Size of every cell: volume (3D), area (2D), length (1D) or 1 (vertices); dimension
+// 0-3 alongside. Unknown cell types get dimension 0 and size 0.
+void cellMeasures(const UnstructuredGrid& grid, const std::vector<size_t>& cellOffsets,
+                  const std::vector<float>& positions,
+                  std::vector<float>& measures, std::vector<uint8_t>& dimensions);
+
+// Float point array with the cell array's components. Non-finite cell values are
+// skipped; points whose cells are all degenerate get the plain mean, and points
+// without cells 0.
+DataArray interpolate(UnstructuredGrid& grid, const DataArray& cellArray);
+
+// Name of the derived point array of a cell array
+std::string pointArrayName(const std::string& cellArrayName);
+
+// Adds the derived point array to grid.point_data unless it is already there.
+// Returns false if the cell array doesn't exist or the points can't be read.
+bool addPointArray(UnstructuredGrid& grid, const std::string& cellArrayName);
+
+} // namespace CellToPoint
+
+#endif // CELLTOPOINT_HPP
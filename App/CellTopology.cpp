@@ -0,0 +1,44 @@
+#include "CellTopology.hpp"
+#include <algorithm>
+
+namespace CellTopology {
+
+std::vector<size_t> cellOffsets(const UnstructuredGrid& grid)
+{
+    const size_t numCells = static_cast<size_t>(std::max<int64_t>(grid.num_cells, 0));
+    std::vector<size_t> offsets;
+    offsets.reserve(numCells);
+    for (size_t offset = 0; offsets.size() < numCells && offset < grid.cells.size();
+         offset += recordSize(grid.cells, offset)) {
+        if (offset + recordSize(grid.cells, offset) > grid.cells.size()) break;
+        offsets.push_back(offset);
+    }
+    return offsets;
+}
+
+std::vector<float> pointPositions(const DataArray& points, size_t numPoints)
+{
+    const size_t numComp = static_cast<size_t>(std::max<int64_t>(points.num_components, 1));
+    std::vector<float> positions;
+    if ((points.data_type == "float" && points.data_float.size() >= numPoints * numComp) ||
+        (points.data_type == "double" && points.data_double.size() >= numPoints * numComp)) {
+        positions.resize(numPoints * 3);
+    } else {
+        return positions;
+    }
+
+    const bool isFloat = (points.data_type == "float");
+    const int64_t count = static_cast<int64_t>(numPoints);
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < count; ++i) {
+        for (size_t axis = 0; axis < 3; ++axis) {
+            const size_t src = static_cast<size_t>(i) * numComp + axis;
+            positions[i*3 + axis] = (axis >= numComp) ? 0.0f
+                                  : isFloat ? points.data_float[src]
+                                            : static_cast<float>(points.data_double[src]);
+        }
+    }
+    return positions;
+}
+
+} // namespace CellTopology
@@ -0,0 +1,672 @@
+#ifndef CELLTOPOLOGY_HPP
+#define CELLTOPOLOGY_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+#include "Loader.hpp"
+
+// Cell-level helpers shared by the boundary extraction and the filters that work on
+// the volume (slicing, contouring, clipping, reordering): addressing the flattened
+// [n, ids...] connectivity in parallel, the faces of each cell type and splitting
+// 3D cells into tetrahedra.
+namespace CellTopology {
+
+enum CellType : uint8_t {
+    VTK_VERTEX = 1,
+    VTK_POLY_VERTEX = 2,
+    VTK_LINE = 3,
+    VTK_POLY_LINE = 4,
+    VTK_TRIANGLE = 5,
+    VTK_TRIANGLE_STRIP = 6,
+    VTK_POLYGON = 7,
+    VTK_PIXEL = 8,
+    VTK_QUAD = 9,
+    VTK_TETRA = 10,
+    VTK_VOXEL = 11,
+    VTK_HEXAHEDRON = 12,
+    VTK_WEDGE = 13,
+    VTK_PYRAMID = 14,
+    VTK_QUADRATIC_EDGE = 21,
+    VTK_QUADRATIC_TRIANGLE = 22,
+    VTK_QUADRATIC_QUAD = 23,
+    VTK_QUADRATIC_TETRA = 24,
+    VTK_QUADRATIC_HEXAHEDRON = 25,
+    VTK_QUADRATIC_WEDGE = 26,
+    VTK_QUADRATIC_PYRAMID = 27,
+    VTK_BIQUADRATIC_QUAD = 28,
+    VTK_TRIQUADRATIC_HEXAHEDRON = 29,
+    VTK_QUADRATIC_LINEAR_QUAD = 30,
+    VTK_QUADRATIC_LINEAR_WEDGE = 31,
+    VTK_BIQUADRATIC_QUADRATIC_WEDGE = 32,
+    VTK_BIQUADRATIC_QUADRATIC_HEXAHEDRON = 33,
+    VTK_BIQUADRATIC_TRIANGLE = 34,
+    VTK_CUBIC_LINE = 35,
+    VTK_QUADRATIC_POLYGON = 36,
+    VTK_POLYHEDRON = 42
+};
+
+// Record length of the cell at `offset` ([n, ids...]), treating negative counts as 0
+inline size_t recordSize(const std::vector<int32_t>& cells, size_t offset)
+{
+    return static_cast<size_t>(std::max(cells[offset], 0)) + 1;
+}
+
+// Start of each complete cell record (inherently sequential); a truncated last record is dropped
+std::vector<size_t> cellOffsets(const UnstructuredGrid& grid);
+
+// Point coordinates as packed floats (z = 0 for 2D points), or empty if the points
+// are not float/double or shorter than numPoints
+std::vector<float> pointPositions(const DataArray& points, size_t numPoints);
+
+// ---- Compile-time face tables ----
+
+constexpr uint8_t kNoNode = 0xFF;
+
+// One face of a cell type in local node ids, wound as the cell reports it. Quadratic
+// cells also name the mid-edge node after each corner and the mid-face node, which
+// only subdivideFace() uses; faces are matched by their corners alone.
+struct FaceDef {
+    uint8_t n;
+    uint8_t v[4];
+    uint8_t mid[4];
+    uint8_t center;
+};
+
+constexpr FaceDef triFace(uint8_t a, uint8_t b, uint8_t c,
+                          uint8_t ab = kNoNode, uint8_t bc = kNoNode, uint8_t ca = kNoNode,
+                          uint8_t center = kNoNode)
+{
+    return FaceDef{3, {a, b, c, kNoNode}, {ab, bc, ca, kNoNode}, center};
+}
+
+constexpr FaceDef quadFace(uint8_t a, uint8_t b, uint8_t c, uint8_t d,
+                           uint8_t ab = kNoNode, uint8_t bc = kNoNode, uint8_t cd = kNoNode, uint8_t da = kNoNode,
+                           uint8_t center = kNoNode)
+{
+    return FaceDef{4, {a, b, c, d}, {ab, bc, cd, da}, center};
+}
+
+// How a type's faces are derived from its record
+enum class FaceLayout : uint8_t {
+    None,        // 0D/1D cells and unknown types
+    Table,       // Fixed faces from CellTraits::faces, records of at least minPoints ids
+    Strip,       // Triangle strip
+    Polygon,     // Fan over the first n / cornerDivisor ids
+    Polyhedron   // [nFaces, (m, ids...) ...] face stream
+};
+
+// Per-type traits; unknown types have no faces. dimension is -1 for unknown types.
+template<uint8_t Type>
+struct CellTraits {
+    static constexpr int dimension = -1;
+    static constexpr FaceLayout layout = FaceLayout::None;
+    static constexpr int32_t minPoints = 1;
+};
+
+template<> struct CellTraits<VTK_VERTEX> {
+    static constexpr int dimension = 0;
+    static constexpr FaceLayout layout = FaceLayout::None;
+    static constexpr int32_t minPoints = 1;
+};
+template<> struct CellTraits<VTK_POLY_VERTEX> : CellTraits<VTK_VERTEX> {};
+
+template<> struct CellTraits<VTK_LINE> {
+    static constexpr int dimension = 1;
+    static constexpr FaceLayout layout = FaceLayout::None;
+    static constexpr int32_t minPoints = 2;
+};
+template<> struct CellTraits<VTK_POLY_LINE> : CellTraits<VTK_LINE> {};
+template<> struct CellTraits<VTK_QUADRATIC_EDGE> : CellTraits<VTK_LINE> {
+    static constexpr int32_t minPoints = 3;
+};
+template<> struct CellTraits<VTK_CUBIC_LINE> : CellTraits<VTK_LINE> {
+    static constexpr int32_t minPoints = 4;
+};
+
+template<> struct CellTraits<VTK_TRIANGLE> {
+    static constexpr int dimension = 2;
+    static constexpr FaceLayout layout = FaceLayout::Table;
+    static constexpr int32_t minPoints = 3;
+    static constexpr FaceDef faces[] = {triFace(0, 1, 2)};
+};
+
+template<> struct CellTraits<VTK_TRIANGLE_STRIP> {
+    static constexpr int dimension = 2;
+    static constexpr FaceLayout layout = FaceLayout::Strip;
+    static constexpr int32_t minPoints = 3;
+};
+
+template<> struct CellTraits<VTK_POLYGON> {
+    static constexpr int dimension = 2;
+    static constexpr FaceLayout layout = FaceLayout::Polygon;
+    static constexpr int32_t minPoints = 3;
+    static constexpr int32_t cornerDivisor = 1;
+};
+
+// Corners first, then the mid-edge nodes
+template<> struct CellTraits<VTK_QUADRATIC_POLYGON> {
+    static constexpr int dimension = 2;
+    static constexpr FaceLayout layout = FaceLayout::Polygon;
+    static constexpr int32_t minPoints = 6;
+    static constexpr int32_t cornerDivisor = 2;
+};
+
+// Pixel corners are numbered x-fastest
+template<> struct CellTraits<VTK_PIXEL> {
+    static constexpr int dimension = 2;
+    static constexpr FaceLayout layout = FaceLayout::Table;
+    static constexpr int32_t minPoints = 4;
+    static constexpr FaceDef faces[] = {quadFace(0, 1, 3, 2)};
+};
+
+template<> struct CellTraits<VTK_QUAD> {
+    static constexpr int dimension = 2;
+    static constexpr FaceLayout layout = FaceLayout::Table;
+    static constexpr int32_t minPoints = 4;
+    static constexpr FaceDef faces[] = {quadFace(0, 1, 2, 3)};
+};
+
+template<> struct CellTraits<VTK_QUADRATIC_TRIANGLE> {
+    static constexpr int dimension = 2;
+    static constexpr FaceLayout layout = FaceLayout::Table;
+    static constexpr int32_t minPoints = 6;
+    static constexpr FaceDef faces[] = {triFace(0, 1, 2, 3, 4, 5)};
+};
+
+template<> struct CellTraits<VTK_BIQUADRATIC_TRIANGLE> {
+    static constexpr int dimension = 2;
+    static constexpr FaceLayout layout = FaceLayout::Table;
+    static constexpr int32_t minPoints = 7;
+    static constexpr FaceDef faces[] = {triFace(0, 1, 2, 3, 4, 5, 6)};
+};
+
+template<> struct CellTraits<VTK_QUADRATIC_QUAD> {
+    static constexpr int dimension = 2;
+    static constexpr FaceLayout layout = FaceLayout::Table;
+    static constexpr int32_t minPoints = 8;
+    static constexpr FaceDef faces[] = {quadFace(0, 1, 2, 3, 4, 5, 6, 7)};
+};
+
+template<> struct CellTraits<VTK_BIQUADRATIC_QUAD> {
+    static constexpr int dimension = 2;
+    static constexpr FaceLayout layout = FaceLayout::Table;
+    static constexpr int32_t minPoints = 9;
+    static constexpr FaceDef faces[] = {quadFace(0, 1, 2, 3, 4, 5, 6, 7, 8)};
+};
+
+// Quadratic along 0-1 and 2-3 only
+template<> struct CellTraits<VTK_QUADRATIC_LINEAR_QUAD> {
+    static constexpr int dimension = 2;
+    static constexpr FaceLayout layout = FaceLayout::Table;
+    static constexpr int32_t minPoints = 6;
+    static constexpr FaceDef faces[] = {quadFace(0, 1, 2, 3, 4, kNoNode, 5, kNoNode)};
+};
+
+template<> struct CellTraits<VTK_TETRA> {
+    static constexpr int dimension = 3;
+    static constexpr FaceLayout layout = FaceLayout::Table;
+    static constexpr int32_t minPoints = 4;
+    static constexpr FaceDef faces[] = {
+        triFace(0, 1, 3), triFace(1, 2, 3), triFace(2, 0, 3), triFace(0, 2, 1)
+    };
+};
+
+template<> struct CellTraits<VTK_QUADRATIC_TETRA> {
+    static constexpr int dimension = 3;
+    static constexpr FaceLayout layout = FaceLayout::Table;
+    static constexpr int32_t minPoints = 10;
+    static constexpr FaceDef faces[] = {
+        triFace(0, 1, 3, 4, 8, 7), triFace(1, 2, 3, 5, 9, 8),
+        triFace(2, 0, 3, 6, 7, 9), triFace(0, 2, 1, 6, 5, 4)
+    };
+};
+
+template<> struct CellTraits<VTK_VOXEL> {
+    static constexpr int dimension = 3;
+    static constexpr FaceLayout layout = FaceLayout::Table;
+    static constexpr int32_t minPoints = 8;
+    static constexpr FaceDef faces[] = {
+        quadFace(0, 1, 3, 2),  // -Z
+        quadFace(4, 6, 7, 5),  // +Z
+        quadFace(0, 2, 6, 4),  // -X
+        quadFace(1, 5, 7, 3),  // +X
+        quadFace(0, 4, 5, 1),  // -Y
+        quadFace(2, 3, 7, 6)   // +Y
+    };
+};
+
+template<> struct CellTraits<VTK_HEXAHEDRON> {
+    static constexpr int dimension = 3;
+    static constexpr FaceLayout layout = FaceLayout::Table;
+    static constexpr int32_t minPoints = 8;
+    static constexpr FaceDef faces[] = {
+        quadFace(0, 1, 5, 4),  // Front
+        quadFace(1, 2, 6, 5),  // Right
+        quadFace(2, 3, 7, 6),  // Back
+        quadFace(3, 0, 4, 7),  // Left
+        quadFace(0, 3, 2, 1),  // Bottom
+        quadFace(4, 5, 6, 7)   // Top
+    };
+};
+
+template<> struct CellTraits<VTK_QUADRATIC_HEXAHEDRON> {
+    static constexpr int dimension = 3;
+    static constexpr FaceLayout layout = FaceLayout::Table;
+    static constexpr int32_t minPoints = 20;
+    static constexpr FaceDef faces[] = {
+        quadFace(0, 1, 5, 4, 8, 17, 12, 16),
+        quadFace(1, 2, 6, 5, 9, 18, 13, 17),
+        quadFace(2, 3, 7, 6, 10, 19, 14, 18),
+        quadFace(3, 0, 4, 7, 11, 16, 15, 19),
+        quadFace(0, 3, 2, 1, 11, 10, 9, 8),
+        quadFace(4, 5, 6, 7, 12, 13, 14, 15)
+    };
+};
+
+// Mid-face nodes 20-25 on the -X, +X, -Y, +Y, -Z, +Z faces
+template<> struct CellTraits<VTK_TRIQUADRATIC_HEXAHEDRON> {
+    static constexpr int dimension = 3;
+    static constexpr FaceLayout layout = FaceLayout::Table;
+    static constexpr int32_t minPoints = 27;
+    static constexpr FaceDef faces[] = {
+        quadFace(0, 1, 5, 4, 8, 17, 12, 16, 22),
+        quadFace(1, 2, 6, 5, 9, 18, 13, 17, 21),
+        quadFace(2, 3, 7, 6, 10, 19, 14, 18, 23),
+        quadFace(3, 0, 4, 7, 11, 16, 15, 19, 20),
+        quadFace(0, 3, 2, 1, 11, 10, 9, 8, 24),
+        quadFace(4, 5, 6, 7, 12, 13, 14, 15, 25)
+    };
+};
+
+// Mid-face nodes 20-23 on the four side faces only
+template<> struct CellTraits<VTK_BIQUADRATIC_QUADRATIC_HEXAHEDRON> {
+    static constexpr int dimension = 3;
+    static constexpr FaceLayout layout = FaceLayout::Table;
+    static constexpr int32_t minPoints = 24;
+    static constexpr FaceDef faces[] = {
+        quadFace(0, 1, 5, 4, 8, 17, 12, 16, 20),
+        quadFace(1, 2, 6, 5, 9, 18, 13, 17, 21),
+        quadFace(2, 3, 7, 6, 10, 19, 14, 18, 22),
+        quadFace(3, 0, 4, 7, 11, 16, 15, 19, 23),
+        quadFace(0, 3, 2, 1, 11, 10, 9, 8),
+        quadFace(4, 5, 6, 7, 12, 13, 14, 15)
+    };
+};
+
+template<> struct CellTraits<VTK_WEDGE> {
+    static constexpr int dimension = 3;
+    static constexpr FaceLayout layout = FaceLayout::Table;
+    static constexpr int32_t minPoints = 6;
+    static constexpr FaceDef faces[] = {
+        triFace(0, 1, 2),  // Bottom tri
+        triFace(3, 5, 4),  // Top tri
+        quadFace(0, 1, 4, 3),
+        quadFace(1, 2, 5, 4),
+        quadFace(2, 0, 3, 5)
+    };
+};
+
+template<> struct CellTraits<VTK_QUADRATIC_WEDGE> {
+    static constexpr int dimension = 3;
+    static constexpr FaceLayout layout = FaceLayout::Table;
+    static constexpr int32_t minPoints = 15;
+    static constexpr FaceDef faces[] = {
+        triFace(0, 1, 2, 6, 7, 8),
+        triFace(3, 5, 4, 11, 10, 9),
+        quadFace(0, 1, 4, 3, 6, 13, 9, 12),
+        quadFace(1, 2, 5, 4, 7, 14, 10, 13),
+        quadFace(2, 0, 3, 5, 8, 12, 11, 14)
+    };
+};
+
+// Quadratic triangles, linear along the 0-3, 1-4, 2-5 edges
+template<> struct CellTraits<VTK_QUADRATIC_LINEAR_WEDGE> {
+    static constexpr int dimension = 3;
+    static constexpr FaceLayout layout = FaceLayout::Table;
+    static constexpr int32_t minPoints = 12;
+    static constexpr FaceDef faces[] = {
+        triFace(0, 1, 2, 6, 7, 8),
+        triFace(3, 5, 4, 11, 10, 9),
+        quadFace(0, 1, 4, 3, 6, kNoNode, 9, kNoNode),
+        quadFace(1, 2, 5, 4, 7, kNoNode, 10, kNoNode),
+        quadFace(2, 0, 3, 5, 8, kNoNode, 11, kNoNode)
+    };
+};
+
+// Mid-face nodes 15-17 on the quad faces
+template<> struct CellTraits<VTK_BIQUADRATIC_QUADRATIC_WEDGE> {
+    static constexpr int dimension = 3;
+    static constexpr FaceLayout layout = FaceLayout::Table;
+    static constexpr int32_t minPoints = 18;
+    static constexpr FaceDef faces[] = {
+        triFace(0, 1, 2, 6, 7, 8),
+        triFace(3, 5, 4, 11, 10, 9),
+        quadFace(0, 1, 4, 3, 6, 13, 9, 12, 15),
+        quadFace(1, 2, 5, 4, 7, 14, 10, 13, 16),
+        quadFace(2, 0, 3, 5, 8, 12, 11, 14, 17)
+    };
+};
+
+template<> struct CellTraits<VTK_PYRAMID> {
+    static constexpr int dimension = 3;
+    static constexpr FaceLayout layout = FaceLayout::Table;
+    static constexpr int32_t minPoints = 5;
+    static constexpr FaceDef faces[] = {
+        quadFace(0, 3, 2, 1),  // Base
+        triFace(0, 1, 4), triFace(1, 2, 4), triFace(2, 3, 4), triFace(3, 0, 4)
+    };
+};
+
+template<> struct CellTraits<VTK_QUADRATIC_PYRAMID> {
+    static constexpr int dimension = 3;
+    static constexpr FaceLayout layout = FaceLayout::Table;
+    static constexpr int32_t minPoints = 13;
+    static constexpr FaceDef faces[] = {
+        quadFace(0, 3, 2, 1, 8, 7, 6, 5),
+        triFace(0, 1, 4, 5, 10, 9), triFace(1, 2, 4, 6, 11, 10),
+        triFace(2, 3, 4, 7, 12, 11), triFace(3, 0, 4, 8, 9, 12)
+    };
+};
+
+template<> struct CellTraits<VTK_POLYHEDRON> {
+    static constexpr int dimension = 3;
+    static constexpr FaceLayout layout = FaceLayout::Polyhedron;
+    static constexpr int32_t minPoints = 1;
+};
+
+template<uint8_t Type>
+using TypeTag = std::integral_constant<uint8_t, Type>;
+
+// Calls fn(TypeTag<type>()) so the type is a compile-time constant inside fn; unknown
+// types get TypeTag<0>, which has no faces
+template<typename Fn>
+inline decltype(auto) withCellType(uint8_t type, Fn&& fn)
+{
+    switch (type) {
+        case VTK_VERTEX:                           return fn(TypeTag<VTK_VERTEX>());
+        case VTK_POLY_VERTEX:                      return fn(TypeTag<VTK_POLY_VERTEX>());
+        case VTK_LINE:                             return fn(TypeTag<VTK_LINE>());
+        case VTK_POLY_LINE:                        return fn(TypeTag<VTK_POLY_LINE>());
+        case VTK_TRIANGLE:                         return fn(TypeTag<VTK_TRIANGLE>());
+        case VTK_TRIANGLE_STRIP:                   return fn(TypeTag<VTK_TRIANGLE_STRIP>());
+        case VTK_POLYGON:                          return fn(TypeTag<VTK_POLYGON>());
+        case VTK_PIXEL:                            return fn(TypeTag<VTK_PIXEL>());
+        case VTK_QUAD:                             return fn(TypeTag<VTK_QUAD>());
+        case VTK_TETRA:                            return fn(TypeTag<VTK_TETRA>());
+        case VTK_VOXEL:                            return fn(TypeTag<VTK_VOXEL>());
+        case VTK_HEXAHEDRON:                       return fn(TypeTag<VTK_HEXAHEDRON>());
+        case VTK_WEDGE:                            return fn(TypeTag<VTK_WEDGE>());
+        case VTK_PYRAMID:                          return fn(TypeTag<VTK_PYRAMID>());
+        case VTK_QUADRATIC_EDGE:                   return fn(TypeTag<VTK_QUADRATIC_EDGE>());
+        case VTK_QUADRATIC_TRIANGLE:               return fn(TypeTag<VTK_QUADRATIC_TRIANGLE>());
+        case VTK_QUADRATIC_QUAD:                   return fn(TypeTag<VTK_QUADRATIC_QUAD>());
+        case VTK_QUADRATIC_TETRA:                  return fn(TypeTag<VTK_QUADRATIC_TETRA>());
+        case VTK_QUADRATIC_HEXAHEDRON:             return fn(TypeTag<VTK_QUADRATIC_HEXAHEDRON>());
+        case VTK_QUADRATIC_WEDGE:                  return fn(TypeTag<VTK_QUADRATIC_WEDGE>());
+        case VTK_QUADRATIC_PYRAMID:                return fn(TypeTag<VTK_QUADRATIC_PYRAMID>());
+        case VTK_BIQUADRATIC_QUAD:                 return fn(TypeTag<VTK_BIQUADRATIC_QUAD>());
+        case VTK_TRIQUADRATIC_HEXAHEDRON:          return fn(TypeTag<VTK_TRIQUADRATIC_HEXAHEDRON>());
+        case VTK_QUADRATIC_LINEAR_QUAD:            return fn(TypeTag<VTK_QUADRATIC_LINEAR_QUAD>());
+        case VTK_QUADRATIC_LINEAR_WEDGE:           return fn(TypeTag<VTK_QUADRATIC_LINEAR_WEDGE>());
+        case VTK_BIQUADRATIC_QUADRATIC_WEDGE:      return fn(TypeTag<VTK_BIQUADRATIC_QUADRATIC_WEDGE>());
+        case VTK_BIQUADRATIC_QUADRATIC_HEXAHEDRON: return fn(TypeTag<VTK_BIQUADRATIC_QUADRATIC_HEXAHEDRON>());
+        case VTK_BIQUADRATIC_TRIANGLE:             return fn(TypeTag<VTK_BIQUADRATIC_TRIANGLE>());
+        case VTK_CUBIC_LINE:                       return fn(TypeTag<VTK_CUBIC_LINE>());
+        case VTK_QUADRATIC_POLYGON:                return fn(TypeTag<VTK_QUADRATIC_POLYGON>());
+        case VTK_POLYHEDRON:                       return fn(TypeTag<VTK_POLYHEDRON>());
+        default:                                   return fn(TypeTag<0>());
+    }
+}
+
+// ---- Polyhedron face streams ----
+
+// Calls fn(pos, m) for each face of a polyhedron, its ids at c[pos + 1 .. pos + m]
+// (c without the leading n). False, before any call, if the stream does not fit n ids
+// or has a face with fewer than 3 ids.
+template<typename Fn>
+inline bool visitPolyhedronFaces(int32_t n, const int32_t* c, Fn fn)
+{
+    if (n < 1 || c[0] < 4) return false;
+    int32_t pos = 1;
+    for (int32_t f = 0; f < c[0]; ++f) {
+        if (pos >= n || c[pos] < 3 || c[pos] > n - pos - 1) return false;
+        pos += c[pos] + 1;
+    }
+    pos = 1;
+    for (int32_t f = 0; f < c[0]; ++f) {
+        fn(pos, c[pos]);
+        pos += c[pos] + 1;
+    }
+    return true;
+}
+
+// Calls fn(k) with the position (1-based, into [n, ids...]) of every point id of a record.
+// Polyhedra interleave the face count and sizes with their ids, which are skipped; a
+// polyhedron point is visited once per face using it.
+template<typename Fn>
+inline void visitPointSlots(uint8_t type, const int32_t* record, Fn fn)
+{
+    const int32_t n = record[0];
+    if (type != VTK_POLYHEDRON) {
+        for (int32_t k = 1; k <= n; ++k) fn(k);
+        return;
+    }
+    visitPolyhedronFaces(n, record + 1, [&fn](int32_t pos, int32_t m) {
+        for (int32_t j = 1; j <= m; ++j) fn(pos + j + 1);
+    });
+}
+
+// ---- Templated face kernels ----
+
+// Number of faces visitFaces<Type>() reports for a record of n ids
+template<uint8_t Type>
+inline size_t faceCount(int32_t n, const int32_t* c)
+{
+    using Traits = CellTraits<Type>;
+    if constexpr (Traits::layout == FaceLayout::Table) {
+        return (n >= Traits::minPoints) ? std::size(Traits::faces) : 0;
+    } else if constexpr (Traits::layout == FaceLayout::Strip) {
+        return (n > 2) ? static_cast<size_t>(n - 2) : 0;
+    } else if constexpr (Traits::layout == FaceLayout::Polygon) {
+        const int32_t corners = (n % Traits::cornerDivisor == 0) ? n / Traits::cornerDivisor : 0;
+        return (corners >= 3) ? static_cast<size_t>(corners - 2) : 0;
+    } else if constexpr (Traits::layout == FaceLayout::Polyhedron) {
+        size_t count = 0;
+        visitPolyhedronFaces(n, c, [&count](int32_t, int32_t m) { count += (m == 4) ? 1 : m - 2; });
+        return count;
+    } else {
+        (void)n; (void)c;
+        return 0;
+    }
+}
+
+// Calls sink.tri(a, b, c) / sink.quad(a, b, c, d) for every face of the cell, in slot
+// order. Polyhedron faces of more than 4 ids are fanned from their smallest id, so the
+// two cells sharing such a face report the same triangles.
+template<uint8_t Type, typename Sink>
+inline void visitFaces(int32_t n, const int32_t* c, Sink& sink)
+{
+    using Traits = CellTraits<Type>;
+    auto id = [c](int32_t k) { return static_cast<uint32_t>(c[k]); };
+    if constexpr (Traits::layout == FaceLayout::Table) {
+        if (n < Traits::minPoints) return;
+        for (const FaceDef& f : Traits::faces) {
+            if (f.n == 3) sink.tri(id(f.v[0]), id(f.v[1]), id(f.v[2]));
+            else sink.quad(id(f.v[0]), id(f.v[1]), id(f.v[2]), id(f.v[3]));
+        }
+    } else if constexpr (Traits::layout == FaceLayout::Strip) {
+        for (int32_t k = 0; k < n - 2; ++k) {
+            if (k % 2 == 0) sink.tri(id(k), id(k + 1), id(k + 2));
+            else sink.tri(id(k), id(k + 2), id(k + 1));
+        }
+    } else if constexpr (Traits::layout == FaceLayout::Polygon) {
+        const int32_t corners = (n % Traits::cornerDivisor == 0) ? n / Traits::cornerDivisor : 0;
+        for (int32_t k = 1; k < corners - 1; ++k) {
+            sink.tri(id(0), id(k), id(k + 1));
+        }
+    } else if constexpr (Traits::layout == FaceLayout::Polyhedron) {
+        visitPolyhedronFaces(n, c, [&](int32_t pos, int32_t m) {
+            const int32_t* v = c + pos + 1;
+            if (m == 3) {
+                sink.tri(id(pos + 1), id(pos + 2), id(pos + 3));
+            } else if (m == 4) {
+                sink.quad(id(pos + 1), id(pos + 2), id(pos + 3), id(pos + 4));
+            } else {
+                int32_t first = 0;
+                for (int32_t j = 1; j < m; ++j) {
+                    if (static_cast<uint32_t>(v[j]) < static_cast<uint32_t>(v[first])) first = j;
+                }
+                for (int32_t j = 1; j < m - 1; ++j) {
+                    sink.tri(static_cast<uint32_t>(v[first]), static_cast<uint32_t>(v[(first + j) % m]),
+                             static_cast<uint32_t>(v[(first + j + 1) % m]));
+                }
+            }
+        });
+    } else {
+        (void)n; (void)sink; (void)id;
+    }
+}
+
+// ---- Run-time dispatch ----
+
+// Number of faces visitCellFaces() reports for a cell of this type and [n, ids...] record
+// (c points past n)
+inline size_t cellFaceCount(uint8_t type, int32_t n, const int32_t* c)
+{
+    return withCellType(type, [&](auto tag) { return faceCount<decltype(tag)::value>(n, c); });
+}
+
+// Calls sink.tri(a, b, c) / sink.quad(a, b, c, d) for every face of the cell, in slot order.
+// Loops over many cells of one type should call visitFaces<Type>() directly.
+template<typename Sink>
+inline void visitCellFaces(uint8_t type, int32_t n, const int32_t* c, Sink& sink)
+{
+    withCellType(type, [&](auto tag) { visitFaces<decltype(tag)::value>(n, c, sink); });
+}
+
+// 0: vertices, 1: lines, 2: surfaces, 3: volumes, -1: unknown
+inline int cellDimension(uint8_t type)
+{
+    return withCellType(type, [](auto tag) { return CellTraits<decltype(tag)::value>::dimension; });
+}
+
+// Table entry of local face k of a fixed-face type, or nullptr
+inline const FaceDef* faceDef(uint8_t type, size_t k)
+{
+    return withCellType(type, [k](auto tag) -> const FaceDef* {
+        using Traits = CellTraits<decltype(tag)::value>;
+        if constexpr (Traits::layout == FaceLayout::Table) {
+            return (k < std::size(Traits::faces)) ? &Traits::faces[k] : nullptr;
+        } else {
+            return nullptr;
+        }
+    });
+}
+
+// Splits a face of a curved cell through its mid-edge nodes: a triangle into 4 triangles,
+// a quad into 4 corner triangles around a quad, and either with a mid-face node into one
+// quad per corner. Calls sink.tri / sink.quad with the winding of the face and returns
+// the number of pieces; 0 (without calls) if an edge has no mid-edge node.
+template<typename Sink>
+inline int subdivideFace(const FaceDef& f, const int32_t* c, Sink& sink)
+{
+    for (int k = 0; k < f.n; ++k) {
+        if (f.mid[k] == kNoNode) return 0;
+    }
+    auto corner = [&](int k) { return static_cast<uint32_t>(c[f.v[k % f.n]]); };
+    auto mid = [&](int k) { return static_cast<uint32_t>(c[f.mid[(k + f.n) % f.n]]); };
+    if (f.center != kNoNode) {
+        const uint32_t center = static_cast<uint32_t>(c[f.center]);
+        for (int k = 0; k < f.n; ++k) sink.quad(corner(k), mid(k), center, mid(k - 1));
+        return f.n;
+    }
+    for (int k = 0; k < f.n; ++k) sink.tri(corner(k), mid(k), mid(k - 1));
+    if (f.n == 3) sink.tri(mid(0), mid(1), mid(2));
+    else sink.quad(mid(0), mid(1), mid(2), mid(3));
+    return f.n + 1;
+}
+
+// Calls fn(id) for the points of a vertex cell, or in order along a line cell. Curved
+// lines pass through their interior nodes; otherwise only the end points are used.
+template<typename Fn>
+inline void visitCellPath(uint8_t type, int32_t n, const int32_t* c, bool curved, Fn fn)
+{
+    auto id = [c](int32_t k) { return static_cast<uint32_t>(c[k]); };
+    switch (type) {
+        case VTK_VERTEX:
+            if (n >= 1) fn(id(0));
+            break;
+        case VTK_LINE:
+            if (n >= 2) { fn(id(0)); fn(id(1)); }
+            break;
+        case VTK_POLY_VERTEX:
+        case VTK_POLY_LINE:
+            for (int32_t k = 0; k < n; ++k) fn(id(k));
+            break;
+        case VTK_QUADRATIC_EDGE:
+            if (n >= 3) { fn(id(0)); if (curved) fn(id(2)); fn(id(1)); }
+            break;
+        case VTK_CUBIC_LINE:
+            if (n >= 4) { fn(id(0)); if (curved) { fn(id(2)); fn(id(3)); } fn(id(1)); }
+            break;
+        default:
+            break;
+    }
+}
+
+constexpr int kMaxTetrahedra = 6;
+
+// Local corner ids of the tetrahedra a 3D cell is split into. Hexahedra are cut
+// around the 0-6 diagonal, so two hexahedra with consistently numbered corners
+// pick the same diagonal on their shared face and contours stay crack free.
+// Quadratic cells are split through their corners, as their linear counterparts.
+// Returns the number of tetrahedra (0 for other types or short records).
+inline int tetrahedra(uint8_t type, int32_t n, const uint8_t*& corners)
+{
+    static const uint8_t tet[] = {0, 1, 2, 3};
+    static const uint8_t hex[] = {0, 1, 2, 6,  0, 2, 3, 6,  0, 3, 7, 6,
+                                  0, 7, 4, 6,  0, 4, 5, 6,  0, 5, 1, 6};
+    // Voxel corners are numbered x-fastest (0,1,3,2 around the base)
+    static const uint8_t voxel[] = {0, 1, 3, 7,  0, 3, 2, 7,  0, 2, 6, 7,
+                                    0, 6, 4, 7,  0, 4, 5, 7,  0, 5, 1, 7};
+    static const uint8_t wedge[] = {0, 1, 2, 3,  1, 2, 5, 3,  1, 5, 4, 3};
+    static const uint8_t pyramid[] = {0, 1, 2, 4,  0, 2, 3, 4};
+
+    const int32_t minPoints = withCellType(type, [](auto tag) { return CellTraits<decltype(tag)::value>::minPoints; });
+    if (n < minPoints) return 0;
+    switch (type) {
+        case VTK_TETRA:
+        case VTK_QUADRATIC_TETRA:
+            corners = tet;
+            return 1;
+        case VTK_HEXAHEDRON:
+        case VTK_QUADRATIC_HEXAHEDRON:
+        case VTK_TRIQUADRATIC_HEXAHEDRON:
+        case VTK_BIQUADRATIC_QUADRATIC_HEXAHEDRON:
+            corners = hex;
+            return 6;
+        case VTK_VOXEL:
+            corners = voxel;
+            return 6;
+        case VTK_WEDGE:
+        case VTK_QUADRATIC_WEDGE:
+        case VTK_QUADRATIC_LINEAR_WEDGE:
+        case VTK_BIQUADRATIC_QUADRATIC_WEDGE:
+            corners = wedge;
+            return 3;
+        case VTK_PYRAMID:
+        case VTK_QUADRATIC_PYRAMID:
+            corners = pyramid;
+            return 2;
+        default:
+            return 0;
+    }
+}
+
+} // namespace CellTopology
+
+#endif // CELLTOPOLOGY_HPP
@@ -0,0 +1,209 @@
+#include "Contour.hpp"
+#include "CellTopology.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// Output of one chunk of cells
+struct ContourChunk {
+    std::vector<float> vertexData;
+    std::vector<float> scalars;
+    std::vector<uint32_t> triangleCells;
+};
+
+// Cuts one tetrahedron. p: point ids, f: field - isovalue (>= 0 counts as inside).
+class TetCutter
+{
+public:
+    TetCutter(const std::vector<float>& positions, const float* pointScalars, ContourChunk& out)
+        : m_positions(positions), m_pointScalars(pointScalars), m_out(out) {}
+
+    void cut(const uint32_t p[4], const float f[4], uint32_t cell, float cellScalar)
+    {
+        int inside[4], outside[4];
+        int numInside = 0, numOutside = 0;
+        for (int k = 0; k < 4; ++k) {
+            if (f[k] >= 0.0f) inside[numInside++] = k;
+            else outside[numOutside++] = k;
+        }
+        if (numInside == 0 || numOutside == 0) return;
+
+        // Gradient of the linear field over the tetrahedron, for the winding. Only its
+        // direction is used, so the division by the volume shrinks to its sign.
+        const float* p0 = &m_positions[p[0] * 3];
+        float e[3][3];
+        for (int k = 0; k < 3; ++k) {
+            for (int a = 0; a < 3; ++a) e[k][a] = m_positions[p[k + 1] * 3 + a] - p0[a];
+        }
+        float c[3][3];  // c[k] = e[k+1] x e[k+2]
+        for (int k = 0; k < 3; ++k) {
+            const float* u = e[(k + 1) % 3];
+            const float* w = e[(k + 2) % 3];
+            c[k][0] = u[1] * w[2] - u[2] * w[1];
+            c[k][1] = u[2] * w[0] - u[0] * w[2];
+            c[k][2] = u[0] * w[1] - u[1] * w[0];
+        }
+        const float volume = e[0][0] * c[0][0] + e[0][1] * c[0][1] + e[0][2] * c[0][2];
+        const float sign = volume < 0.0f ? -1.0f : 1.0f;
+        float gradient[3];
+        for (int a = 0; a < 3; ++a) {
+            gradient[a] = sign * ((f[1] - f[0]) * c[0][a] + (f[2] - f[0]) * c[1][a] + (f[3] - f[0]) * c[2][a]);
+        }
+
+        if (numInside == 1 || numOutside == 1) {
+            const int s = numInside == 1 ? inside[0] : outside[0];
+            const int* o = numInside == 1 ? outside : inside;
+            Vertex v[3];
+            for (int k = 0; k < 3; ++k) v[k] = edgeVertex(p, f, s, o[k], cellScalar);
+            emit(v[0], v[1], v[2], gradient, cell);
+        } else {
+            // Quad around the tetrahedron, in cyclic order
+            const int a = inside[0], b = inside[1], c = outside[0], d = outside[1];
+            const Vertex ac = edgeVertex(p, f, a, c, cellScalar);
+            const Vertex ad = edgeVertex(p, f, a, d, cellScalar);
+            const Vertex bd = edgeVertex(p, f, b, d, cellScalar);
+            const Vertex bc = edgeVertex(p, f, b, c, cellScalar);
+            emit(ac, ad, bd, gradient, cell);
+            emit(ac, bd, bc, gradient, cell);
+        }
+    }
+
+private:
+    struct Vertex {
+        float position[3];
+        float scalar;
+    };
+
+    Vertex edgeVertex(const uint32_t p[4], const float f[4], int a, int b, float cellScalar) const
+    {
+        const float t = f[a] / (f[a] - f[b]);
+        Vertex v;
+        for (int k = 0; k < 3; ++k) {
+            const float pa = m_positions[p[a] * 3 + k];
+            v.position[k] = pa + t * (m_positions[p[b] * 3 + k] - pa);
+        }
+        v.scalar = m_pointScalars ? m_pointScalars[p[a]] + t * (m_pointScalars[p[b]] - m_pointScalars[p[a]])
+                                  : cellScalar;
+        return v;
+    }
+
+    void emit(const Vertex& v0, Vertex v1, Vertex v2, const float gradient[3], uint32_t cell)
+    {
+        const float e1[3] = {v1.position[0] - v0.position[0], v1.position[1] - v0.position[1], v1.position[2] - v0.position[2]};
+        const float e2[3] = {v2.position[0] - v0.position[0], v2.position[1] - v0.position[1], v2.position[2] - v0.position[2]};
+        float n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+        if (n[0] * gradient[0] + n[1] * gradient[1] + n[2] * gradient[2] < 0.0f) {
+            std::swap(v1, v2);
+            for (float& c : n) c = -c;
+        }
+        // Corners on the isovalue collapse triangles to points or lines
+        const float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (!(length > 0.0f)) return;
+        for (float& c : n) c /= length;
+
+        const Vertex* corners[3] = {&v0, &v1, &v2};
+        for (const Vertex* v : corners) {
+            m_out.vertexData.insert(m_out.vertexData.end(), v->position, v->position + 3);
+            m_out.vertexData.insert(m_out.vertexData.end(), n, n + 3);
+            m_out.scalars.push_back(v->scalar);
+        }
+        m_out.triangleCells.push_back(cell);
+    }
+
+    const std::vector<float>& m_positions;
+    const float* m_pointScalars;
+    ContourChunk& m_out;
+};
+
+} // namespace
+
+namespace Contour {
+
+void cellRanges(const UnstructuredGrid& grid, const std::vector<size_t>& cellOffsets,
+                const float* field, size_t numPoints,
+                std::vector<float>& mins, std::vector<float>& maxs)
+{
+    const int64_t numCells = static_cast<int64_t>(std::min(cellOffsets.size(), grid.cell_types.size()));
+    mins.resize(static_cast<size_t>(numCells));
+    maxs.resize(static_cast<size_t>(numCells));
+    #pragma omp parallel for schedule(static)
+    for (int64_t c = 0; c < numCells; ++c) {
+        const int32_t* record = &grid.cells[cellOffsets[c]];
+        const uint8_t* corners = nullptr;
+        float lo = std::numeric_limits<float>::infinity();
+        float hi = -std::numeric_limits<float>::infinity();
+        if (CellTopology::tetrahedra(grid.cell_types[c], record[0], corners) > 0) {
+            for (int32_t k = 1; k <= record[0]; ++k) {
+                const uint32_t p = static_cast<uint32_t>(record[k]);
+                if (p >= numPoints) continue;
+                lo = std::min(lo, field[p]);
+                hi = std::max(hi, field[p]);
+            }
+        }
+        mins[c] = lo;
+        maxs[c] = hi;
+    }
+}
+
+ContourSurface contourCells(const UnstructuredGrid& grid, const std::vector<size_t>& cellOffsets,
+                            const std::vector<float>& positions, const std::vector<uint32_t>& cells,
+                            const float* field, float isovalue,
+                            const float* pointScalars, const float* cellScalars)
+{
+    ContourSurface surface;
+    const size_t count = cells.size();
+    const size_t numPoints = positions.size() / 3;
+    const int chunks = std::max(1, std::min(Parallel::maxThreads(), static_cast<int>(count / 4096) + 1));
+
+    std::vector<ContourChunk> chunkOutput(chunks);
+    #pragma omp parallel for schedule(static, 1) num_threads(chunks)
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        size_t begin, end;
+        Parallel::chunkRange(count, chunks, chunk, begin, end);
+        TetCutter cutter(positions, pointScalars, chunkOutput[chunk]);
+        for (size_t i = begin; i < end; ++i) {
+            const uint32_t cell = cells[i];
+            if (cell >= cellOffsets.size() || cell >= grid.cell_types.size()) continue;
+            const int32_t* record = &grid.cells[cellOffsets[cell]];
+            const uint8_t* corners = nullptr;
+            const int tets = CellTopology::tetrahedra(grid.cell_types[cell], record[0], corners);
+            const float cellScalar = cellScalars ? cellScalars[cell] : 0.0f;
+
+            for (int t = 0; t < tets; ++t) {
+                uint32_t p[4];
+                float f[4];
+                bool valid = true;
+                for (int k = 0; k < 4; ++k) {
+                    p[k] = static_cast<uint32_t>(record[1 + corners[t * 4 + k]]);
+                    valid = valid && p[k] < numPoints;
+                    f[k] = valid ? field[p[k]] - isovalue : 0.0f;
+                }
+                if (valid) cutter.cut(p, f, cell, cellScalar);
+            }
+        }
+    }
+
+    // Concatenate in chunk order
+    std::vector<size_t> offsets(chunks + 1, 0);
+    for (int chunk = 0; chunk < chunks; ++chunk) offsets[chunk] = chunkOutput[chunk].triangleCells.size();
+    const size_t triangles = Parallel::exclusiveScan(offsets);
+    surface.vertexData.resize(triangles * 18);
+    surface.scalars.resize((pointScalars || cellScalars) ? triangles * 3 : 0);
+    surface.triangleCells.resize(triangles);
+    #pragma omp parallel for schedule(static, 1) num_threads(chunks)
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        const ContourChunk& out = chunkOutput[chunk];
+        const size_t t = offsets[chunk];
+        std::copy(out.vertexData.begin(), out.vertexData.end(), surface.vertexData.begin() + t * 18);
+        if (!surface.scalars.empty()) {
+            std::copy(out.scalars.begin(), out.scalars.end(), surface.scalars.begin() + t * 3);
+        }
+        std::copy(out.triangleCells.begin(), out.triangleCells.end(), surface.triangleCells.begin() + t);
+    }
+    return surface;
+}
+
+} // namespace Contour
@@ -0,0 +1,41 @@
+#ifndef CONTOUR_HPP
+#define CONTOUR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Loader.hpp"
+
+// Unindexed triangles cut out of 3D cells (slices, isosurfaces)
+struct ContourSurface {
+    std::vector<float> vertexData;        // Position (3) + normal (3) per vertex, 3 vertices per triangle
+    std::vector<float> scalars;           // Raw color value per vertex; empty without a color array
+    std::vector<uint32_t> triangleCells;  // Cut cell of each triangle
+
+    size_t triangleCount() const { return triangleCells.size(); }
+    size_t vertexCount() const { return vertexData.size() / 6; }
+};
+
+// Marching tetrahedra over tetrahedra, hexahedra, voxels, wedges and pyramids
+// (split by CellTopology::tetrahedra). Triangles face the side where the field grows.
+namespace Contour {
+
+// Range [min, max] of a point field over every 3D cell, the intervals to index for
+// contourCells(). Other cells and cells without valid points get an empty interval (min > max).
+void cellRanges(const UnstructuredGrid& grid, const std::vector<size_t>& cellOffsets,
+                const float* field, size_t numPoints,
+                std::vector<float>& mins, std::vector<float>& maxs);
+
+// Contours `field` (one value per point) at `isovalue` in the listed cells.
+// positions holds 3 floats per point and cellOffsets the record start of every cell.
+// Vertex colors interpolate pointScalars if given, else copy the cell's cellScalars value.
+// Chunks of cells are cut in parallel into private buffers that are then concatenated,
+// so the output order follows `cells`.
+ContourSurface contourCells(const UnstructuredGrid& grid, const std::vector<size_t>& cellOffsets,
+                            const std::vector<float>& positions, const std::vector<uint32_t>& cells,
+                            const float* field, float isovalue,
+                            const float* pointScalars, const float* cellScalars);
+
+} // namespace Contour
+
+#endif // CONTOUR_HPP
@@ -0,0 +1,82 @@
+#include "FaceHashTable.hpp"
+#include "Parallel.hpp"
+
+template<typename Key>
+FaceHashTable<Key>::FaceHashTable(const Key* keys, size_t faceCount)
+    : m_keys(keys)
+    , m_faceCount(faceCount)
+    , m_capacity(faceCount + faceCount / 2 + 1)  // Load factor <= 2/3 even if no face is shared
+    , m_slots(new Slot[m_capacity])
+{
+    const int64_t capacity = static_cast<int64_t>(m_capacity);
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < capacity; ++i) {
+        m_slots[i].face.store(0, std::memory_order_relaxed);
+        m_slots[i].count.store(0, std::memory_order_relaxed);
+    }
+}
+
+template<typename Key>
+uint32_t FaceHashTable<Key>::hashKey(uint64_t key)
+{
+    // splitmix64 finalizer
+    key ^= key >> 30;
+    key *= 0xBF58476D1CE4E5B9ULL;
+    key ^= key >> 27;
+    key *= 0x94D049BB133111EBULL;
+    key ^= key >> 31;
+    return static_cast<uint32_t>(key);
+}
+
+template<typename Key>
+uint32_t FaceHashTable<Key>::hashKey(const FaceKey& key)
+{
+    return hashKey(key.lo ^ (key.hi * 0x9E3779B97F4A7C15ULL));
+}
+
+template<typename Key>
+void FaceHashTable<Key>::insert(uint32_t faceIdx)
+{
+    const Key& key = m_keys[faceIdx];
+    // Map the 32-bit hash onto [0, capacity) without a modulo
+    size_t slot = static_cast<size_t>((static_cast<uint64_t>(hashKey(key)) * m_capacity) >> 32);
+    const uint32_t tag = faceIdx + 1;
+
+    while (true) {
+        Slot& s = m_slots[slot];
+        uint32_t current = s.face.load(std::memory_order_acquire);
+        if (current == 0) {
+            if (s.face.compare_exchange_strong(current, tag, std::memory_order_acq_rel)) {
+                s.count.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            // Lost the race; `current` now holds the winner's tag, compare against it
+        }
+        if (m_keys[current - 1] == key) {
+            s.count.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (++slot == m_capacity) slot = 0;
+    }
+}
+
+template<typename Key>
+void FaceHashTable<Key>::insertAll()
+{
+    const int64_t faceCount = static_cast<int64_t>(m_faceCount);
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < faceCount; ++i) {
+        insert(static_cast<uint32_t>(i));
+    }
+}
+
+template<typename Key>
+std::vector<uint32_t> FaceHashTable<Key>::boundaryFaces() const
+{
+    return Parallel::collect<uint32_t>(m_capacity,
+        [this](size_t i) { return m_slots[i].count.load(std::memory_order_relaxed) == 1; },
+        [this](size_t i) { return m_slots[i].face.load(std::memory_order_relaxed) - 1; });
+}
+
+template class FaceHashTable<uint64_t>;
+template class FaceHashTable<FaceKey>;
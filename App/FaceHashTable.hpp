@@ -0,0 +1,49 @@
+#ifndef FACEHASHTABLE_HPP
+#define FACEHASHTABLE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "MeshProcessor.hpp"
+
+// Concurrent open-addressing hash table used to find boundary faces in expected O(F).
+// Slots only store a face slot index; the packed face key is read from the key array,
+// so each slot costs 8 bytes. The first insert of a face claims a slot, later inserts
+// of the same face bump its count and thereby cancel it as a boundary.
+// Instantiated for 64-bit keys and for 128-bit FaceKey.
+template<typename Key>
+class FaceHashTable
+{
+public:
+    FaceHashTable(const Key* keys, size_t faceCount);
+
+    // Thread-safe; may be called concurrently for different face indices
+    void insert(uint32_t faceIdx);
+
+    // Inserts every face in parallel
+    void insertAll();
+
+    // Indices of faces that were inserted exactly once, in table slot order. After a
+    // collision the slot a face lands in depends on the insert order of the threads, so
+    // only the set is deterministic; callers sort it.
+    std::vector<uint32_t> boundaryFaces() const;
+
+    size_t capacity() const { return m_capacity; }
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> face;   // 0 = empty, otherwise face index + 1
+        std::atomic<uint32_t> count;  // Number of inserts of this face
+    };
+
+    static uint32_t hashKey(uint64_t key);
+    static uint32_t hashKey(const FaceKey& key);
+
+    const Key* m_keys;
+    size_t m_faceCount;
+    size_t m_capacity;
+    std::unique_ptr<Slot[]> m_slots;
+};
+
+#endif // FACEHASHTABLE_HPP
@@ -1,34 +1,90 @@
 #include "GLWidget.hpp"
 #include "LoaderFactory.hpp"
+#include "ArrayStatistics.hpp"
+#include "SpatialReorder.hpp"
+#include "PointWeld.hpp"
+#include "PlaneSlicer.hpp"
+#include "PlaneClipper.hpp"
+#include "CellThreshold.hpp"
+#include "CellToPoint.hpp"
+#include "RegionVisibility.hpp"
+#include "Isosurface.hpp"
+#include <QColor>
+#include <QMetaObject>
+#include <QVector4D>
 #include <QFile>
 #include <QTextStream>
 #include <QElapsedTimer>
 #include <QLoggingCategory>
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <limits>
 
 Q_LOGGING_CATEGORY(glWidgetLog, "VTKViewer.GLWidget")
 
+namespace {
+// Surfaces smaller than this are drawn in full even while interacting
+constexpr size_t kLodMinTriangles = 1000000;
+// While the camera moves, draw the finest level with at most this many triangles
+constexpr size_t kInteractiveTriangleBudget = 4000000;
+
+// Point at fraction t of [lo, hi]; the ends are exact so that a full range keeps everything
+inline float rangeAt(float lo, float hi, float t)
+{
+    return t <= 0.0f ? lo : (t >= 1.0f ? hi : lo + t * (hi - lo));
+}
+
+// Golden-ratio hue steps keep neighbouring part numbers apart
+inline QVector3D partColor(size_t part)
+{
+    const QColor color = QColor::fromHsvF(static_cast<float>(std::fmod(0.6 + part * 0.618034, 1.0)), 0.55f, 0.9f);
+    return QVector3D(color.redF(), color.greenF(), color.blueF());
+}
+}
+
 GLWidget::GLWidget(QWidget *parent)
     : QOpenGLWidget(parent)
     , m_vertexBuffer(QOpenGLBuffer::VertexBuffer)
     , m_triangleIndexBuffer(QOpenGLBuffer::IndexBuffer)
     , m_lineIndexBuffer(QOpenGLBuffer::IndexBuffer)
     , m_pointIndexBuffer(QOpenGLBuffer::IndexBuffer)
+    , m_cellLineIndexBuffer(QOpenGLBuffer::IndexBuffer)
+    , m_cellPointIndexBuffer(QOpenGLBuffer::IndexBuffer)
     , m_axesBuffer(QOpenGLBuffer::VertexBuffer)
 {
     setFocusPolicy(Qt::StrongFocus);
     setMouseTracking(true);
+    
+    m_interactionTimer.setSingleShot(true);
+    m_interactionTimer.setInterval(250);
+    connect(&m_interactionTimer, &QTimer::timeout, this, QOverload<>::of(&GLWidget::update));
 }
 
 GLWidget::~GLWidget()
 {
+    stopMeshWorker();
     makeCurrent();
     
+    releaseLods();
+    releaseOverlay(m_sliceOverlay);
+    releaseOverlay(m_subsetOverlay);
+    releaseOverlay(m_isoOverlay);
     m_meshVAO.destroy();
     m_vertexBuffer.destroy();
+    m_scalarBuffers[0].destroy();
+    m_scalarBuffers[1].destroy();
+    m_vertexPointBuffer.destroy();
+    if (m_triangleCellBuffer != 0) {
+        glDeleteBuffers(1, &m_triangleCellBuffer);
+        glDeleteBuffers(1, &m_vertexCellBuffer);
+    }
+    releaseArrayBuffers();
     m_triangleIndexBuffer.destroy();
     m_lineIndexBuffer.destroy();
     m_pointIndexBuffer.destroy();
+    m_cellLineIndexBuffer.destroy();
+    m_cellPointIndexBuffer.destroy();
     
     m_axesVAO.destroy();
     m_axesBuffer.destroy();
@@ -155,7 +211,20 @@ void GLWidget::setupBuffers()
     m_meshVAO.bind();
     
     m_vertexBuffer.create();
-    m_vertexBuffer.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+    m_vertexBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    
+    // Scalars are double-buffered: a new array goes into the buffer not used by the last frame
+    for (QOpenGLBuffer& buffer : m_scalarBuffers) {
+        buffer.create();
+        buffer.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+    }
+    
+    m_vertexPointBuffer.create();
+    m_vertexPointBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    
+    // Storage buffers mapping triangles / vertices to cells for GPU scalar lookup
+    glGenBuffers(1, &m_triangleCellBuffer);
+    glGenBuffers(1, &m_vertexCellBuffer);
     
     m_triangleIndexBuffer.create();
     m_triangleIndexBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
@@ -166,6 +235,12 @@ void GLWidget::setupBuffers()
     m_pointIndexBuffer.create();
     m_pointIndexBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
     
+    m_cellLineIndexBuffer.create();
+    m_cellLineIndexBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    
+    m_cellPointIndexBuffer.create();
+    m_cellPointIndexBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    
     m_meshVAO.release();
     
     // Axes VAO
@@ -200,31 +275,60 @@ void GLWidget::setupBuffers()
 
 void GLWidget::updateBuffers()
 {
-    if (m_meshData.vertexData.empty()) return;
+    if (m_meshData.vertexCount == 0) return;
     
     m_meshVAO.bind();
     
     // Upload vertex data
     m_vertexBuffer.bind();
-    m_vertexBuffer.allocate(m_meshData.vertexData.data(), 
-                            static_cast<int>(m_meshData.vertexData.size() * sizeof(float)));
+    m_vertexBuffer.allocate(vertexBufferData(), vertexBufferSize());
     
-    // Setup vertex attributes
-    // Position (3 floats)
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 7 * sizeof(float), nullptr);
+    if (m_meshData.vertexFormat == VertexFormat::Compact) {
+        const GLsizei stride = sizeof(CompactVertex);
+        
+        // Position (3 unorm16, relative to the bounding box)
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride,
+                              reinterpret_cast<void*>(offsetof(CompactVertex, position)));
+        
+        // Normal (2 snorm16, octahedral)
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride,
+                              reinterpret_cast<void*>(offsetof(CompactVertex, normal)));
+    } else {
+        // Position (3 floats)
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), nullptr);
+        
+        // Normal (3 floats)
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), 
+                              reinterpret_cast<void*>(3 * sizeof(float)));
+    }
     
-    // Normal (3 floats)
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 7 * sizeof(float), 
-                          reinterpret_cast<void*>(3 * sizeof(float)));
+    m_vertexBuffer.release();
     
-    // Scalar (1 float)
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, 7 * sizeof(float), 
-                          reinterpret_cast<void*>(6 * sizeof(float)));
+    // Upload scalar stream into both halves of the double buffer
+    for (QOpenGLBuffer& buffer : m_scalarBuffers) {
+        buffer.bind();
+        buffer.allocate(scalarBufferData(), scalarBufferSize());
+        buffer.release();
+    }
+    m_activeScalarBuffer = 0;
+    bindScalarAttribute();
     
-    m_vertexBuffer.release();
+    // Point index per vertex (uint), used to fetch point data from the raw array
+    m_vertexPointBuffer.bind();
+    m_vertexPointBuffer.allocate(m_meshData.vertexToPointIndex.data(),
+                                 static_cast<int>(m_meshData.vertexToPointIndex.size() * sizeof(uint32_t)));
+    glEnableVertexAttribArray(3);
+    glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, sizeof(uint32_t), nullptr);
+    m_vertexPointBuffer.release();
+    
+    uploadStorageBuffer(m_triangleCellBuffer, m_meshData.triangleToCellIndex.data(),
+                        m_meshData.triangleToCellIndex.size() * sizeof(uint32_t));
+    uploadStorageBuffer(m_vertexCellBuffer, m_meshData.vertexToCellIndex.data(),
+                        m_meshData.vertexToCellIndex.size() * sizeof(uint32_t));
     
     // Upload index buffers
     if (!m_meshData.triangleIndices.empty()) {
@@ -248,9 +352,136 @@ void GLWidget::updateBuffers()
         m_pointIndexBuffer.release();
     }
     
+    if (!m_meshData.cellLineIndices.empty()) {
+        m_cellLineIndexBuffer.bind();
+        m_cellLineIndexBuffer.allocate(m_meshData.cellLineIndices.data(),
+                                       static_cast<int>(m_meshData.cellLineIndices.size() * sizeof(uint32_t)));
+        m_cellLineIndexBuffer.release();
+    }
+    
+    if (!m_meshData.cellPointIndices.empty()) {
+        m_cellPointIndexBuffer.bind();
+        m_cellPointIndexBuffer.allocate(m_meshData.cellPointIndices.data(),
+                                        static_cast<int>(m_meshData.cellPointIndices.size() * sizeof(uint32_t)));
+        m_cellPointIndexBuffer.release();
+    }
+    
     m_meshVAO.release();
 }
 
+const void* GLWidget::vertexBufferData() const
+{
+    if (m_meshData.vertexFormat == VertexFormat::Compact) {
+        return m_meshData.compactVertices.data();
+    }
+    return m_meshData.vertexData.data();
+}
+
+int GLWidget::vertexBufferSize() const
+{
+    if (m_meshData.vertexFormat == VertexFormat::Compact) {
+        return static_cast<int>(m_meshData.compactVertices.size() * sizeof(CompactVertex));
+    }
+    return static_cast<int>(m_meshData.vertexData.size() * sizeof(float));
+}
+
+const void* GLWidget::scalarBufferData() const
+{
+    if (m_meshData.vertexFormat == VertexFormat::Compact) {
+        return m_meshData.compactScalars.data();
+    }
+    return m_meshData.scalarData.data();
+}
+
+int GLWidget::scalarBufferSize() const
+{
+    if (m_meshData.vertexFormat == VertexFormat::Compact) {
+        return static_cast<int>(m_meshData.compactScalars.size() * sizeof(uint16_t));
+    }
+    return static_cast<int>(m_meshData.scalarData.size() * sizeof(float));
+}
+
+void GLWidget::bindScalarAttribute()
+{
+    // Scalar (1 float or 1 unorm16), expects the mesh VAO to be bound
+    m_scalarBuffers[m_activeScalarBuffer].bind();
+    glEnableVertexAttribArray(2);
+    if (m_meshData.vertexFormat == VertexFormat::Compact) {
+        glVertexAttribPointer(2, 1, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(uint16_t), nullptr);
+    } else {
+        glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(float), nullptr);
+    }
+    m_scalarBuffers[m_activeScalarBuffer].release();
+}
+
+void GLWidget::uploadStorageBuffer(GLuint buffer, const void* data, size_t bytes)
+{
+    // Never leave a binding without storage, even for empty meshes
+    static const uint32_t dummy = 0;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, bytes ? static_cast<GLsizeiptr>(bytes) : sizeof(dummy),
+                 bytes ? data : &dummy, GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+GLWidget::ArrayBuffer GLWidget::arrayBuffer(const QString& name, bool isPointData)
+{
+    const QString key = (isPointData ? "point:" : "cell:") + name;
+    auto it = m_arrayBuffers.find(key);
+    if (it != m_arrayBuffers.end()) return it.value();
+    
+    const auto& arrays = isPointData ? m_grid->point_data : m_grid->cell_data;
+    auto found = arrays.find(name.toStdString());
+    if (found == arrays.end() || !found->second) return ArrayBuffer();
+    
+    // Uploaded once per array; switching arrays or components afterwards touches no buffers
+    const DataArray& array = *found->second;
+    const std::vector<float> values = MeshProcessor::arrayToFloat(array);
+    ArrayBuffer entry;
+    entry.components = std::max(1, static_cast<int>(array.num_components));
+    entry.tuples = static_cast<GLuint>(std::min<size_t>(static_cast<size_t>(array.num_tuples),
+                                                         values.size() / entry.components));
+    glGenBuffers(1, &entry.buffer);
+    uploadStorageBuffer(entry.buffer, values.data(), values.size() * sizeof(float));
+    m_arrayBuffers.insert(key, entry);
+    return entry;
+}
+
+void GLWidget::releaseArrayBuffers()
+{
+    for (const ArrayBuffer& entry : m_arrayBuffers) {
+        glDeleteBuffers(1, &entry.buffer);
+    }
+    m_arrayBuffers.clear();
+    m_activeArray = ArrayBuffer();
+}
+
+void GLWidget::setScalarLookupUniforms(QOpenGLShaderProgram& shader)
+{
+    const bool lookup = m_gpuScalarLookup && m_activeArray.buffer != 0 &&
+                        ((m_physicalData == PointData && m_activeArrayIsPoint) ||
+                         (m_physicalData == CellData && !m_activeArrayIsPoint));
+    shader.setUniformValue("scalarLookup", lookup ? (m_activeArrayIsPoint ? 1 : 2) : 0);
+    if (!lookup) return;
+    
+    shader.setUniformValue("arrayComponents", m_activeArray.components);
+    shader.setUniformValue("arrayComponent", m_activeComponent);
+    shader.setUniformValue("arrayTuples", m_activeArray.tuples);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_activeArray.buffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_triangleCellBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_vertexCellBuffer);
+}
+
+void GLWidget::setVertexFormatUniforms(QOpenGLShaderProgram& shader)
+{
+    const bool compact = (m_meshData.vertexFormat == VertexFormat::Compact);
+    shader.setUniformValue("compactVertices", compact ? 1 : 0);
+    if (compact) {
+        shader.setUniformValue("positionOrigin", m_meshData.boundingBoxMin);
+        shader.setUniformValue("positionExtent", m_meshData.boundingBoxMax - m_meshData.boundingBoxMin);
+    }
+}
+
 void GLWidget::resizeGL(int w, int h)
 {
     m_camera.setAspectRatio(static_cast<float>(w) / static_cast<float>(h));
@@ -280,12 +511,90 @@ void GLWidget::paintGL()
     }
 }
 
+bool GLWidget::isInteracting() const
+{
+    return m_leftMousePressed || m_rightMousePressed || m_middleMousePressed || m_interactionTimer.isActive();
+}
+
+GLWidget::LodBuffer* GLWidget::interactionLod()
+{
+    if (m_lodBuffers.empty() || !isInteracting()) return nullptr;
+    for (LodBuffer& lod : m_lodBuffers) {
+        if (static_cast<size_t>(lod.indexCount) / 3 <= kInteractiveTriangleBudget) return &lod;
+    }
+    return &m_lodBuffers.back();
+}
+
+void GLWidget::drawTriangles()
+{
+    const bool anyHidden = std::find(m_partHidden.begin(), m_partHidden.end(), 1) != m_partHidden.end();
+    if (anyHidden || (m_partColoring && !m_partHidden.empty())) {
+        drawPartRanges();
+        return;
+    }
+    
+    LodBuffer* lod = interactionLod();
+    if (!lod) {
+        m_triangleIndexBuffer.bind();
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(m_meshData.triangleIndices.size()), 
+                      GL_UNSIGNED_INT, nullptr);
+        m_triangleIndexBuffer.release();
+        return;
+    }
+    
+    // The level shares the vertex streams; only gl_PrimitiveID -> cell differs
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, lod->cells);
+    lod->indices.bind();
+    glDrawElements(GL_TRIANGLES, lod->indexCount, GL_UNSIGNED_INT, nullptr);
+    lod->indices.release();
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_triangleCellBuffer);
+}
+
+void GLWidget::drawPartRanges()
+{
+    // The LOD levels don't keep the part order, so parts are always drawn in full.
+    // gl_PrimitiveID restarts with every draw; primitiveOffset keeps the cell lookup aligned.
+    const std::vector<uint32_t>& offsets = m_meshData.partOffsets;
+    const size_t parts = m_partHidden.size();
+    m_triangleIndexBuffer.bind();
+    for (size_t p = 0; p < parts; ) {
+        if (m_partHidden[p]) {
+            ++p;
+            continue;
+        }
+        size_t end = p + 1;
+        if (m_partColoring) {
+            m_meshShader->setUniformValue("solidColor", partColor(p));
+        } else {
+            while (end < parts && !m_partHidden[end]) ++end;
+        }
+        const uint32_t first = offsets[p];
+        m_meshShader->setUniformValue("primitiveOffset", static_cast<int>(first));
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>((offsets[end] - first) * 3), GL_UNSIGNED_INT,
+                       reinterpret_cast<const void*>(static_cast<size_t>(first) * 3 * sizeof(uint32_t)));
+        p = end;
+    }
+    m_triangleIndexBuffer.release();
+    m_meshShader->setUniformValue("primitiveOffset", 0);
+    m_meshShader->setUniformValue("solidColor", m_solidColor);
+}
+
 void GLWidget::renderMesh()
 {
     QMatrix4x4 mvp = m_camera.projectionMatrix() * m_camera.viewMatrix();
     QMatrix4x4 modelView = m_camera.viewMatrix();
     QMatrix3x3 normalMatrix = modelView.normalMatrix();
     
+    // The kept cells' boundary or the isosurface stand in for the whole surface
+    if (m_clipEnabled || m_thresholdEnabled || m_regionsEnabled || m_isoEnabled) {
+        if (m_clipEnabled || m_thresholdEnabled || m_regionsEnabled) drawOverlay(m_subsetOverlay, mvp, modelView, normalMatrix);
+        if (m_isoEnabled) drawOverlay(m_isoOverlay, mvp, modelView, normalMatrix);
+        if (m_sliceEnabled) drawOverlay(m_sliceOverlay, mvp, modelView, normalMatrix);
+        return;
+    }
+    
+    // While slicing, the surface in front of the plane is clipped away
+    if (m_sliceEnabled) glEnable(GL_CLIP_DISTANCE0);
     m_meshVAO.bind();
     
     // Render based on mode
@@ -293,6 +602,9 @@ void GLWidget::renderMesh()
         case Solid:
             glDisable(GL_CULL_FACE);  // 禁用背面剔除，确保所有面都渲染
             m_meshShader->bind();
+            setVertexFormatUniforms(*m_meshShader);
+            setClipUniforms(*m_meshShader);
+            setScalarLookupUniforms(*m_meshShader);
             m_meshShader->setUniformValue("mvp", mvp);
             m_meshShader->setUniformValue("modelView", modelView);
             m_meshShader->setUniformValue("normalMatrix", normalMatrix);
@@ -305,22 +617,21 @@ void GLWidget::renderMesh()
             m_meshShader->setUniformValue("twoSidedLighting", 1);  // 启用双面光照
             m_meshShader->setUniformValue("renderPoints", 0);  // 非点渲染
             
-            m_triangleIndexBuffer.bind();
-            glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(m_meshData.triangleIndices.size()), 
-                          GL_UNSIGNED_INT, nullptr);
-            m_triangleIndexBuffer.release();
+            drawTriangles();
             m_meshShader->release();
             break;
             
         case Wireframe:
             glDisable(GL_CULL_FACE);
             m_wireShader->bind();
+            setVertexFormatUniforms(*m_wireShader);
+            setClipUniforms(*m_wireShader);
             m_wireShader->setUniformValue("mvp", mvp);
             m_wireShader->setUniformValue("color", m_wireColor);
             // glLineWidth(m_lineWidth);
             
             m_lineIndexBuffer.bind();
-            glDrawElements(GL_LINES, static_cast<GLsizei>(m_meshData.lineIndices.size()), 
+            glDrawElements(GL_LINES, static_cast<GLsizei>(m_meshData.lineCount * 2), 
                           GL_UNSIGNED_INT, nullptr);
             m_lineIndexBuffer.release();
             m_wireShader->release();
@@ -329,6 +640,9 @@ void GLWidget::renderMesh()
         case Points:
             glDisable(GL_CULL_FACE);
             m_meshShader->bind();
+            setVertexFormatUniforms(*m_meshShader);
+            setClipUniforms(*m_meshShader);
+            setScalarLookupUniforms(*m_meshShader);
             m_meshShader->setUniformValue("mvp", mvp);
             m_meshShader->setUniformValue("modelView", modelView);
             m_meshShader->setUniformValue("normalMatrix", normalMatrix);
@@ -354,6 +668,9 @@ void GLWidget::renderMesh()
             glDisable(GL_CULL_FACE);  // 禁用背面剔除
             glEnable(GL_POLYGON_OFFSET_FILL);
             m_meshShader->bind();
+            setVertexFormatUniforms(*m_meshShader);
+            setClipUniforms(*m_meshShader);
+            setScalarLookupUniforms(*m_meshShader);
             m_meshShader->setUniformValue("mvp", mvp);
             m_meshShader->setUniformValue("modelView", modelView);
             m_meshShader->setUniformValue("normalMatrix", normalMatrix);
@@ -366,22 +683,21 @@ void GLWidget::renderMesh()
             m_meshShader->setUniformValue("twoSidedLighting", 1);  // 启用双面光照
             m_meshShader->setUniformValue("renderPoints", 0);  // 非点渲染
             
-            m_triangleIndexBuffer.bind();
-            glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(m_meshData.triangleIndices.size()), 
-                          GL_UNSIGNED_INT, nullptr);
-            m_triangleIndexBuffer.release();
+            drawTriangles();
             m_meshShader->release();
             glDisable(GL_POLYGON_OFFSET_FILL);
             
             // Second pass: wireframe
             glDisable(GL_CULL_FACE);
             m_wireShader->bind();
+            setVertexFormatUniforms(*m_wireShader);
+            setClipUniforms(*m_wireShader);
             m_wireShader->setUniformValue("mvp", mvp);
             m_wireShader->setUniformValue("color", m_wireColor);
             // glLineWidth(m_lineWidth);
             
             m_lineIndexBuffer.bind();
-            glDrawElements(GL_LINES, static_cast<GLsizei>(m_meshData.lineIndices.size()), 
+            glDrawElements(GL_LINES, static_cast<GLsizei>(m_meshData.lineCount * 2), 
                           GL_UNSIGNED_INT, nullptr);
             m_lineIndexBuffer.release();
             m_wireShader->release();
@@ -391,6 +707,9 @@ void GLWidget::renderMesh()
             // Surface mode: 双面渲染，禁用背面剔除，双面光照
             glDisable(GL_CULL_FACE);  // 禁用背面剔除，可以看到内部
             m_meshShader->bind();
+            setVertexFormatUniforms(*m_meshShader);
+            setClipUniforms(*m_meshShader);
+            setScalarLookupUniforms(*m_meshShader);
             m_meshShader->setUniformValue("mvp", mvp);
             m_meshShader->setUniformValue("modelView", modelView);
             m_meshShader->setUniformValue("normalMatrix", normalMatrix);
@@ -403,15 +722,58 @@ void GLWidget::renderMesh()
             m_meshShader->setUniformValue("twoSidedLighting", 1);  // 启用双面光照
             m_meshShader->setUniformValue("renderPoints", 0);  // 非点渲染
             
-            m_triangleIndexBuffer.bind();
-            glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(m_meshData.triangleIndices.size()), 
-                          GL_UNSIGNED_INT, nullptr);
-            m_triangleIndexBuffer.release();
+            drawTriangles();
             m_meshShader->release();
             break;
     }
     
+    drawCellPrimitives(mvp, modelView, normalMatrix);
     m_meshVAO.release();
+    glDisable(GL_CLIP_DISTANCE0);
+    
+    if (m_sliceEnabled) drawOverlay(m_sliceOverlay, mvp, modelView, normalMatrix);
+}
+
+void GLWidget::drawCellPrimitives(const QMatrix4x4& mvp, const QMatrix4x4& modelView, const QMatrix3x3& normalMatrix)
+{
+    if (m_meshData.cellLineIndices.empty() && m_meshData.cellPointIndices.empty()) return;
+    
+    // Same vertex streams as the surface; cell data is looked up per vertex
+    m_meshShader->bind();
+    setVertexFormatUniforms(*m_meshShader);
+    setClipUniforms(*m_meshShader);
+    setScalarLookupUniforms(*m_meshShader);
+    m_meshShader->setUniformValue("mvp", mvp);
+    m_meshShader->setUniformValue("modelView", modelView);
+    m_meshShader->setUniformValue("normalMatrix", normalMatrix);
+    m_meshShader->setUniformValue("lightDir", m_lightDir);
+    m_meshShader->setUniformValue("solidColor", m_solidColor);
+    m_meshShader->setUniformValue("physicalData", static_cast<int>(m_physicalData));
+    m_meshShader->setUniformValue("colorMode", static_cast<int>(m_colorMode));
+    m_meshShader->setUniformValue("scalarMin", m_meshData.scalarMin);
+    m_meshShader->setUniformValue("scalarMax", m_meshData.scalarMax);
+    m_meshShader->setUniformValue("pointSize", m_pointSize);
+    m_meshShader->setUniformValue("twoSidedLighting", 0);
+    
+    if (!m_meshData.cellLineIndices.empty()) {
+        m_meshShader->setUniformValue("renderPoints", 2);  // 线单元, 不参与光照
+        m_cellLineIndexBuffer.bind();
+        glDrawElements(GL_LINES, static_cast<GLsizei>(m_meshData.cellLineIndices.size()), GL_UNSIGNED_INT, nullptr);
+        m_cellLineIndexBuffer.release();
+    }
+    if (!m_meshData.cellPointIndices.empty()) {
+        m_meshShader->setUniformValue("renderPoints", 1);  // 顶点单元, 圆形点
+        m_cellPointIndexBuffer.bind();
+        glDrawElements(GL_POINTS, static_cast<GLsizei>(m_meshData.cellPointIndices.size()), GL_UNSIGNED_INT, nullptr);
+        m_cellPointIndexBuffer.release();
+    }
+    m_meshShader->release();
+}
+
+void GLWidget::setClipUniforms(QOpenGLShaderProgram& shader)
+{
+    // Kept where dot(normal, p) <= offset
+    shader.setUniformValue("clipPlane", QVector4D(-m_sliceNormal, m_sliceOffset));
 }
 
 void GLWidget::renderAxes()
@@ -473,14 +835,49 @@ bool GLWidget::loadMesh(const QString& filePath)
     qInfo(glWidgetLog) << "File load" << filePath << "in" << loadTime << "ms";
     timer.restart();
     
+    stopMeshWorker();
+    makeCurrent();
+    releaseLods();
+    releaseArrayBuffers();
+    releaseOverlay(m_sliceOverlay);
+    releaseOverlay(m_subsetOverlay);
+    releaseOverlay(m_isoOverlay);
+    doneCurrent();
+    
     m_grid = loader->getGrid();
     if (!m_grid) {
         emit statusMessage("Failed to get grid data");
         return false;
     }
     
+    // Merge points the file repeats per element, so shared faces pair up again
+    size_t weldedPoints = 0;
+    if (m_weldPoints) {
+        weldedPoints = PointWeld::weld(*m_grid, m_weldTolerance);
+        qInfo(glWidgetLog) << "Point weld" << filePath << "merged" << weldedPoints << "points in" << timer.elapsed() << "ms";
+        timer.restart();
+    }
+    
+    // Renumber points and cells along a space-filling curve for cache-friendly gathers
+    if (m_spatialReorder && SpatialReorder::reorder(*m_grid)) {
+        qInfo(glWidgetLog) << "Spatial reorder" << filePath << "in" << timer.elapsed() << "ms";
+        timer.restart();
+    }
+    
+    m_slicer.setGrid(m_grid);
+    m_subset.setGrid(m_grid);
+    m_clipper.reset();
+    m_threshold.reset();
+    m_regions.reset();
+    m_regionsEnabled = false;
+    m_regionArray.clear();
+    m_isosurface.setGrid(m_grid);
+    m_isoSurface = ContourSurface();
+    m_overlayValues.clear();
+    
     // Process mesh data
     m_meshData = m_processor.process(m_grid);
+    resetParts();
     
     qint64 processTime = timer.elapsed();
     qInfo(glWidgetLog) << "Mesh process" << filePath << "in" << processTime << "ms";
@@ -493,17 +890,21 @@ bool GLWidget::loadMesh(const QString& filePath)
     
     qint64 uploadTime = timer.elapsed();
     qInfo(glWidgetLog) << "GPU upload" << filePath << "in" << uploadTime << "ms";
+    startMeshWorker();
 
     // Fit camera to model
     m_camera.fitToBox(m_meshData.boundingBoxMin, m_meshData.boundingBoxMax);
     
     m_meshLoaded = true;
     
-    emit statusMessage(QString("Load: %1ms, Process: %2ms, Upload: %3ms")
-                       .arg(loadTime).arg(processTime).arg(uploadTime));
+    QString message = QString("Load: %1ms, Process: %2ms, Upload: %3ms")
+                      .arg(loadTime).arg(processTime).arg(uploadTime);
+    if (m_weldPoints) message += QString(", Welded points: %1").arg(weldedPoints);
+    emit statusMessage(message);
     emit meshLoaded();
     emit dataArraysUpdated();
     
+    refreshOverlays();
     update();
     return true;
 }
@@ -532,24 +933,769 @@ void GLWidget::setPhysicalValue(PhysicalData mode)
 
 void GLWidget::setActiveDataArray(const QString& name)
 {
+    if (name != m_activeDataArray) {
+        m_activeComponent = -1;
+    }
     m_activeDataArray = name;
     
     if (!m_grid || name.isEmpty()) return;
     
     bool isPointData = (m_physicalData == PointData);
-    m_processor.updateScalars(m_meshData, m_grid, name.toStdString(), isPointData);
     
-    // Update vertex buffer with new scalar values
+    if (m_gpuScalarLookup) {
+        // The shader reads the raw array; only the color range is computed here
+        makeCurrent();
+        m_activeArray = arrayBuffer(name, isPointData);
+        doneCurrent();
+        m_activeArrayIsPoint = isPointData;
+        if (m_activeArray.buffer != 0) {
+            const auto& arrays = isPointData ? m_grid->point_data : m_grid->cell_data;
+            m_processor.scalarRange(*m_grid, *arrays.at(name.toStdString()), m_activeComponent,
+                                    m_meshData.scalarMin, m_meshData.scalarMax);
+        }
+        reportArrayStatistics(name, isPointData);
+        refreshOverlays();
+        update();
+        return;
+    }
+    
+    m_processor.updateScalars(m_meshData, m_grid, name.toStdString(), isPointData, m_activeComponent);
+    reportArrayStatistics(name, isPointData);
+    
+    // Only the scalar stream changes: fill the idle half of the double buffer,
+    // then point the scalar attribute at it. Geometry stays resident.
     makeCurrent();
-    m_vertexBuffer.bind();
-    m_vertexBuffer.write(0, m_meshData.vertexData.data(),
-                         static_cast<int>(m_meshData.vertexData.size() * sizeof(float)));
-    m_vertexBuffer.release();
+    const int next = 1 - m_activeScalarBuffer;
+    m_scalarBuffers[next].bind();
+    m_scalarBuffers[next].write(0, scalarBufferData(), scalarBufferSize());
+    m_scalarBuffers[next].release();
+    m_activeScalarBuffer = next;
+    m_meshVAO.bind();
+    bindScalarAttribute();
+    m_meshVAO.release();
     doneCurrent();
     
+    refreshOverlays();
     update();
 }
 
+void GLWidget::setActiveComponent(int component)
+{
+    if (component == m_activeComponent) return;
+    m_activeComponent = component;
+    if (!m_activeDataArray.isEmpty()) {
+        setActiveDataArray(m_activeDataArray);
+    }
+}
+
+void GLWidget::setScalarRangeMode(MeshProcessor::ScalarRange mode)
+{
+    if (mode == m_processor.scalarRangeMode()) return;
+    m_processor.setScalarRangeMode(mode);
+    if (!m_activeDataArray.isEmpty()) {
+        setActiveDataArray(m_activeDataArray);
+    }
+}
+
+void GLWidget::reportArrayStatistics(const QString& name, bool isPointData)
+{
+    const auto& arrays = isPointData ? m_grid->point_data : m_grid->cell_data;
+    auto it = arrays.find(name.toStdString());
+    if (it == arrays.end() || !it->second) return;
+    
+    // Cached by the range query above, so this costs nothing
+    const ArraySummary& stats = ArrayStatistics::of(*m_grid).summary(*it->second, m_activeComponent);
+    emit statusMessage(QString("%1: min %2, max %3, mean %4, P1 %5, P99 %6")
+                       .arg(name).arg(stats.min).arg(stats.max).arg(stats.mean)
+                       .arg(stats.percentile(0.01)).arg(stats.percentile(0.99)));
+}
+
+void GLWidget::setGpuScalarLookup(bool enabled)
+{
+    if (enabled == m_gpuScalarLookup) return;
+    m_gpuScalarLookup = enabled;
+    if (!m_activeDataArray.isEmpty()) {
+        setActiveDataArray(m_activeDataArray);
+    }
+}
+
+int GLWidget::getArrayComponentCount(const QString& name, bool isPointData) const
+{
+    if (!m_grid) return 0;
+    const auto& arrays = isPointData ? m_grid->point_data : m_grid->cell_data;
+    auto it = arrays.find(name.toStdString());
+    return (it != arrays.end() && it->second) ? static_cast<int>(it->second->num_components) : 0;
+}
+
+void GLWidget::setShadingMode(MeshProcessor::ShadingMode mode)
+{
+    if (m_processor.shadingMode() == mode) return;
+    m_processor.setShadingMode(mode);
+    rebuildMesh();
+}
+
+void GLWidget::setVertexFormat(VertexFormat format)
+{
+    if (m_processor.vertexFormat() == format) return;
+    m_processor.setVertexFormat(format);
+    rebuildMesh();
+}
+
+void GLWidget::setOptimizeIndices(bool enabled)
+{
+    if (m_processor.optimizeIndices() == enabled) return;
+    m_processor.setOptimizeIndices(enabled);
+    // Only the indexed (smooth) path is reordered
+    if (m_processor.shadingMode() == MeshProcessor::ShadingMode::Smooth) {
+        rebuildMesh();
+    }
+}
+
+void GLWidget::setSubdivideCurved(bool enabled)
+{
+    if (m_processor.subdivideCurved() == enabled) return;
+    m_processor.setSubdivideCurved(enabled);
+    rebuildMesh();
+}
+
+void GLWidget::startMeshWorker()
+{
+    if (m_meshData.triangleCount == 0) return;
+    
+    // The worker only reads the geometry streams of m_meshData, which stay untouched until
+    // the next stopMeshWorker(); scalar updates write other members
+    m_workerCancel = false;
+    const int generation = ++m_workerGeneration;
+    m_meshWorker = std::thread([this, generation]() {
+        QElapsedTimer timer;
+        timer.start();
+        auto bvh = std::make_shared<TriangleBvh>();
+        if (!bvh->build(m_meshData, &m_workerCancel)) return;
+        qInfo(glWidgetLog) << "Picking BVH" << bvh->nodeCount() << "nodes in" << timer.elapsed() << "ms";
+        
+        // Queued to the GUI thread; dropped if the widget is gone or the mesh was replaced
+        QMetaObject::invokeMethod(this, [this, generation, bvh]() {
+            if (generation == m_workerGeneration) m_bvh = bvh;
+        }, Qt::QueuedConnection);
+        
+        if (m_meshData.triangleCount < kLodMinTriangles) return;
+        timer.restart();
+        auto levels = std::make_shared<std::vector<MeshLod::Level>>(
+            MeshLod::buildChain(m_meshData, {0.5f, 0.1f, 0.01f}, m_workerCancel));
+        if (m_workerCancel) return;
+        qInfo(glWidgetLog) << "LOD chain" << levels->size() << "levels in" << timer.elapsed() << "ms";
+        
+        QMetaObject::invokeMethod(this, [this, generation, levels]() {
+            if (generation == m_workerGeneration) uploadLods(*levels);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void GLWidget::stopMeshWorker()
+{
+    m_workerCancel = true;
+    if (m_meshWorker.joinable()) {
+        m_meshWorker.join();
+    }
+    ++m_workerGeneration;
+    m_bvh.reset();
+}
+
+void GLWidget::uploadLods(std::vector<MeshLod::Level>& levels)
+{
+    makeCurrent();
+    releaseLods();
+    QStringList counts;
+    for (MeshLod::Level& level : levels) {
+        LodBuffer lod;
+        lod.indices.create();
+        lod.indices.setUsagePattern(QOpenGLBuffer::StaticDraw);
+        lod.indices.bind();
+        lod.indices.allocate(level.triangleIndices.data(),
+                             static_cast<int>(level.triangleIndices.size() * sizeof(uint32_t)));
+        lod.indices.release();
+        lod.indexCount = static_cast<GLsizei>(level.triangleIndices.size());
+        
+        glGenBuffers(1, &lod.cells);
+        uploadStorageBuffer(lod.cells, level.triangleToCellIndex.data(),
+                            level.triangleToCellIndex.size() * sizeof(uint32_t));
+        m_lodBuffers.push_back(lod);
+        counts << QString::number(level.triangleCount());
+    }
+    doneCurrent();
+    
+    emit statusMessage(QString("LOD levels ready: %1 triangles").arg(counts.join(" / ")));
+}
+
+void GLWidget::releaseLods()
+{
+    for (LodBuffer& lod : m_lodBuffers) {
+        lod.indices.destroy();
+        if (lod.cells != 0) glDeleteBuffers(1, &lod.cells);
+    }
+    m_lodBuffers.clear();
+}
+
+void GLWidget::rebuildMesh()
+{
+    if (!m_meshLoaded || !m_grid) return;
+    
+    // Vertex layout depends on the processor settings, so the surface is rebuilt from the grid
+    QElapsedTimer timer;
+    timer.start();
+    stopMeshWorker();
+    m_meshData = m_processor.process(m_grid);
+    resetParts();
+    
+    makeCurrent();
+    releaseLods();
+    updateBuffers();
+    doneCurrent();
+    startMeshWorker();
+    
+    if ((m_physicalData == PointData || m_physicalData == CellData) && !m_activeDataArray.isEmpty()) {
+        setActiveDataArray(m_activeDataArray);
+    }
+    
+    emit statusMessage(QString("Rebuilt surface: %1 vertices (%2 KB) in %3ms")
+                       .arg(m_meshData.vertexCount).arg(vertexBufferSize() / 1024).arg(timer.elapsed()));
+    update();
+}
+
+void GLWidget::setFeatureAngle(int degrees)
+{
+    m_processor.setFeatureAngle(static_cast<float>(degrees));
+    // Lines are ordered sharpest first, so only the draw count changes
+    m_meshData.lineCount = MeshProcessor::featureLineCount(m_meshData, m_processor.featureAngle());
+    update();
+}
+
+void GLWidget::setSliceEnabled(bool enabled)
+{
+    if (enabled == m_sliceEnabled) return;
+    m_sliceEnabled = enabled;
+    refreshOverlays();
+}
+
+void GLWidget::setSliceAxis(int axis)
+{
+    m_sliceAxis = std::min(std::max(axis, 0), 2);
+    updateSlice();
+}
+
+void GLWidget::setSlicePosition(int permille)
+{
+    m_slicePosition = std::min(std::max(permille, 0), 1000) / 1000.0f;
+    updateSlice();
+}
+
+void GLWidget::setClipEnabled(bool enabled)
+{
+    if (enabled == m_clipEnabled) return;
+    m_clipEnabled = enabled;
+    if (!enabled) m_clipper.release();
+    refreshOverlays();
+}
+
+void GLWidget::setClipAxis(int axis)
+{
+    m_clipAxis = std::min(std::max(axis, 0), 2);
+    updateClip();
+}
+
+void GLWidget::setClipPosition(int permille)
+{
+    m_clipPosition = std::min(std::max(permille, 0), 1000) / 1000.0f;
+    updateClip();
+}
+
+void GLWidget::setThresholdEnabled(bool enabled)
+{
+    if (enabled == m_thresholdEnabled) return;
+    m_thresholdEnabled = enabled;
+    if (!enabled) m_threshold.release();
+    refreshOverlays();
+}
+
+void GLWidget::setThresholdArray(const QString& name)
+{
+    if (name == m_thresholdArray && m_threshold.hasValues()) return;
+    m_thresholdArray = name;
+    m_threshold.release();
+    m_threshold.reset();
+    updateThreshold();
+}
+
+void GLWidget::setThresholdMin(int permille)
+{
+    m_thresholdMin = std::min(std::max(permille, 0), 1000) / 1000.0f;
+    updateThreshold();
+}
+
+void GLWidget::setThresholdMax(int permille)
+{
+    m_thresholdMax = std::min(std::max(permille, 0), 1000) / 1000.0f;
+    updateThreshold();
+}
+
+void GLWidget::setRegionArray(const QString& name)
+{
+    if (name == m_regionArray && (m_regionsEnabled || name.isEmpty())) return;
+    m_regionArray = name;
+    m_regions.release();
+    m_regions.reset();
+    m_regionsEnabled = false;
+    if (!m_grid || name.isEmpty()) {
+        refreshOverlays();
+        return;
+    }
+    
+    auto it = m_grid->cell_data.find(name.toStdString());
+    if (it == m_grid->cell_data.end() || !it->second) {
+        emit statusMessage("区域: 请选择单元数据数组");
+        refreshOverlays();
+        return;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    m_regions.setIds(MeshProcessor::tupleValues(*it->second, 0));
+    if (!m_subset.prepare()) {
+        emit statusMessage("区域: 网格单元无法使用");
+        return;
+    }
+    m_regions.setInterfaces(m_interfacesEnabled);
+    m_regionsEnabled = true;
+    refreshOverlays();
+    emit statusMessage(QString("区域 %1: %2 个区域, %3 ms")
+                       .arg(name).arg(m_regions.regionCount()).arg(timer.elapsed()));
+}
+
+void GLWidget::setRegionVisible(int region, bool visible)
+{
+    if (!m_regionsEnabled || region < 0) return;
+    QElapsedTimer timer;
+    timer.start();
+    if (!m_regions.setVisible(static_cast<size_t>(region), visible)) return;
+    uploadSubset();
+    
+    emit statusMessage(QString("区域 %1: %2 %3 个单元, %4 个边界面, %5 ms")
+                       .arg(m_regions.regionId(static_cast<size_t>(region))).arg(visible ? "显示" : "隐藏")
+                       .arg(m_regions.changedCount()).arg(m_subset.boundaryFaceCount()).arg(timer.elapsed()));
+}
+
+void GLWidget::setShowInterfaces(bool enabled)
+{
+    if (enabled == m_interfacesEnabled) return;
+    m_interfacesEnabled = enabled;
+    if (!m_regionsEnabled) return;
+    QElapsedTimer timer;
+    timer.start();
+    m_regions.setInterfaces(enabled);
+    uploadSubset();
+    
+    emit statusMessage(QString("区域交界面: %1 个面, %2 ms").arg(m_subset.boundaryFaceCount()).arg(timer.elapsed()));
+}
+
+QStringList GLWidget::regionLabels() const
+{
+    QStringList labels;
+    if (!m_regionsEnabled) return labels;
+    for (size_t r = 0; r < m_regions.regionCount(); ++r) {
+        labels << QString("区域 %1 (%2 个单元)").arg(m_regions.regionId(r)).arg(m_regions.regionSize(r));
+    }
+    return labels;
+}
+
+void GLWidget::resetParts()
+{
+    const size_t parts = m_meshData.partOffsets.empty() ? 0 : m_meshData.partOffsets.size() - 1;
+    m_partHidden.assign(parts, 0);
+    emit partsChanged();
+}
+
+void GLWidget::setPartMode(int mode)
+{
+    const MeshProcessor::PartMode partMode = (mode == 1) ? MeshProcessor::PartMode::Cells
+                                           : (mode == 2) ? MeshProcessor::PartMode::Surface
+                                                         : MeshProcessor::PartMode::None;
+    if (m_processor.partMode() == partMode) return;
+    m_processor.setPartMode(partMode);
+    rebuildMesh();
+    emit statusMessage(QString("部件: %1 个").arg(m_partHidden.size()));
+}
+
+void GLWidget::setPartVisible(int part, bool visible)
+{
+    if (part < 0 || static_cast<size_t>(part) >= m_partHidden.size()) return;
+    m_partHidden[part] = visible ? 0 : 1;
+    update();
+}
+
+void GLWidget::isolatePart(int part)
+{
+    if (part < 0 || static_cast<size_t>(part) >= m_partHidden.size()) return;
+    std::fill(m_partHidden.begin(), m_partHidden.end(), 1);
+    m_partHidden[part] = 0;
+    update();
+}
+
+void GLWidget::showAllParts()
+{
+    std::fill(m_partHidden.begin(), m_partHidden.end(), 0);
+    update();
+}
+
+void GLWidget::setPartColoring(bool enabled)
+{
+    m_partColoring = enabled;
+    update();
+}
+
+QStringList GLWidget::partLabels() const
+{
+    QStringList labels;
+    for (size_t p = 0; p < m_partHidden.size(); ++p) {
+        labels << QString("部件 %1 (%2 个三角形)").arg(p + 1)
+                      .arg(m_meshData.partOffsets[p + 1] - m_meshData.partOffsets[p]);
+    }
+    return labels;
+}
+
+QString GLWidget::interpolateCellArray(const QString& name)
+{
+    if (!m_grid || name.isEmpty()) return QString();
+    QElapsedTimer timer;
+    timer.start();
+    
+    // Cached in the grid's point data, next to the native point arrays
+    const std::string pointName = CellToPoint::pointArrayName(name.toStdString());
+    const bool cached = m_grid->point_data.count(pointName) > 0;
+    if (!CellToPoint::addPointArray(*m_grid, name.toStdString())) {
+        emit statusMessage("插值: 无法读取单元数据 " + name);
+        return QString();
+    }
+    m_processor.updateArrayNames(*m_grid);
+    emit statusMessage(cached ? QString("插值: %1 已存在").arg(QString::fromStdString(pointName))
+                              : QString("插值: %1 -> %2, %3 ms").arg(name)
+                                    .arg(QString::fromStdString(pointName)).arg(timer.elapsed()));
+    return QString::fromStdString(pointName);
+}
+
+void GLWidget::setIsoEnabled(bool enabled)
+{
+    if (enabled == m_isoEnabled) return;
+    m_isoEnabled = enabled;
+    if (!enabled) m_isoSurface = ContourSurface();
+    refreshOverlays();
+}
+
+void GLWidget::setIsoArray(const QString& name)
+{
+    if (name == m_isoArray && m_isosurface.hasField()) return;
+    m_isoArray = name;
+    m_isosurface.setField(std::vector<float>());
+    updateIso();
+}
+
+void GLWidget::setIsoValue(int permille)
+{
+    m_isoPosition = std::min(std::max(permille, 0), 1000) / 1000.0f;
+    updateIso();
+}
+
+void GLWidget::updateOverlayValues()
+{
+    m_overlayValues.clear();
+    if (!m_grid || m_activeDataArray.isEmpty() || (m_physicalData != PointData && m_physicalData != CellData)) return;
+    
+    m_overlayValuesArePoint = (m_physicalData == PointData);
+    const auto& arrays = m_overlayValuesArePoint ? m_grid->point_data : m_grid->cell_data;
+    auto it = arrays.find(m_activeDataArray.toStdString());
+    if (it != arrays.end() && it->second) {
+        m_overlayValues = MeshProcessor::tupleValues(*it->second, m_activeComponent);
+    }
+}
+
+void GLWidget::refreshOverlays()
+{
+    if (!m_sliceEnabled && !m_clipEnabled && !m_thresholdEnabled && !m_regionsEnabled && !m_isoEnabled) {
+        m_overlayValues.clear();
+        m_overlayValues.shrink_to_fit();
+        update();
+        return;
+    }
+    updateOverlayValues();
+    m_subsetColorsStale = true;
+    updateSlice();
+    updateClip();
+    updateThreshold();
+    if (m_regionsEnabled && !m_clipEnabled && !m_thresholdEnabled) uploadSubset();
+    updateIso();
+}
+
+void GLWidget::updateSlice()
+{
+    if (!m_sliceEnabled || !m_grid) return;
+    QElapsedTimer timer;
+    timer.start();
+    
+    m_sliceNormal = QVector3D(m_sliceAxis == 0 ? 1.0f : 0.0f, m_sliceAxis == 1 ? 1.0f : 0.0f,
+                              m_sliceAxis == 2 ? 1.0f : 0.0f);
+    m_slicer.setNormal(m_sliceNormal);
+    float lo, hi;
+    m_slicer.offsetRange(lo, hi);
+    if (lo > hi) {
+        emit statusMessage("切片: 网格中没有三维单元");
+        return;
+    }
+    m_sliceOffset = rangeAt(lo, hi, m_slicePosition);
+    
+    // Colors only if the cached values match the grid's point / cell count
+    const size_t expected = static_cast<size_t>(m_overlayValuesArePoint ? m_grid->num_points : m_grid->num_cells);
+    const float* values = m_overlayValues.size() == expected ? m_overlayValues.data() : nullptr;
+    const ContourSurface surface = m_slicer.slice(m_sliceOffset, m_overlayValuesArePoint ? values : nullptr,
+                                                  m_overlayValuesArePoint ? nullptr : values);
+    
+    makeCurrent();
+    uploadOverlay(m_sliceOverlay, surface);
+    doneCurrent();
+    
+    emit statusMessage(QString("切片: %1 三角形, %2 个候选单元, %3 ms")
+                       .arg(surface.triangleCount()).arg(m_slicer.candidateCount()).arg(timer.elapsed()));
+    update();
+}
+
+void GLWidget::updateClip()
+{
+    if (!m_clipEnabled || !m_grid) return;
+    QElapsedTimer timer;
+    timer.start();
+    
+    m_clipper.setNormal(QVector3D(m_clipAxis == 0 ? 1.0f : 0.0f, m_clipAxis == 1 ? 1.0f : 0.0f,
+                                  m_clipAxis == 2 ? 1.0f : 0.0f));
+    float lo, hi;
+    m_clipper.offsetRange(lo, hi);
+    if (lo > hi || !m_clipper.clip(rangeAt(lo, hi, m_clipPosition))) {
+        emit statusMessage("裁剪: 网格单元无法使用");
+        return;
+    }
+    uploadSubset();
+    
+    emit statusMessage(QString("裁剪: 保留 %1 个单元 (变化 %2), %3 个边界面, %4 ms")
+                       .arg(m_subset.keptCount()).arg(m_clipper.changedCount())
+                       .arg(m_subset.boundaryFaceCount()).arg(timer.elapsed()));
+}
+
+void GLWidget::updateThreshold()
+{
+    if (!m_thresholdEnabled || !m_grid) return;
+    QElapsedTimer timer;
+    timer.start();
+    
+    // Values are sorted on first use and kept while only the range moves
+    if (!m_threshold.hasValues()) {
+        auto it = m_grid->cell_data.find(m_thresholdArray.toStdString());
+        if (it == m_grid->cell_data.end() || !it->second) {
+            uploadSubset();
+            emit statusMessage("阈值: 请选择单元数据数组");
+            return;
+        }
+        m_threshold.setValues(MeshProcessor::tupleValues(*it->second, -1));
+    }
+    float lo, hi;
+    m_threshold.valueRange(lo, hi);
+    const float low = rangeAt(lo, hi, m_thresholdMin);
+    const float high = rangeAt(lo, hi, m_thresholdMax);
+    if (lo > hi || !m_threshold.apply(low, high)) {
+        emit statusMessage("阈值: 网格单元无法使用");
+        return;
+    }
+    uploadSubset();
+    
+    emit statusMessage(QString("阈值 %1 在 [%2, %3]: 保留 %4 个单元 (变化 %5), %6 个边界面, %7 ms")
+                       .arg(m_thresholdArray).arg(low).arg(high)
+                       .arg(m_subset.keptCount()).arg(m_threshold.changedCount())
+                       .arg(m_subset.boundaryFaceCount()).arg(timer.elapsed()));
+}
+
+void GLWidget::uploadSubset()
+{
+    const size_t expected = static_cast<size_t>(m_overlayValuesArePoint ? m_grid->num_points : m_grid->num_cells);
+    const float* values = m_overlayValues.size() == expected ? m_overlayValues.data() : nullptr;
+    const float* pointValues = m_overlayValuesArePoint ? values : nullptr;
+    const float* cellValues = m_overlayValuesArePoint ? nullptr : values;
+    
+    // Only the entries of the shown face list that changed are rewritten, unless the colors
+    // changed or the list no longer fits; growth doubles the buffers to keep that rare
+    const size_t vertices = m_subset.boundaryFaceCount() * SubsetSurface::kFaceVertices;
+    std::vector<uint32_t> entries;
+    const bool patch = m_subset.takeChangedEntries(entries) && !m_subsetColorsStale
+                       && m_subsetOverlay.vao.isCreated() && vertices <= m_subsetOverlay.capacity;
+    
+    makeCurrent();
+    if (patch) {
+        const ContourSurface faces = m_subset.faceTriangles(entries.data(), entries.size(), pointValues, cellValues);
+        patchOverlay(m_subsetOverlay, faces, entries, SubsetSurface::kFaceVertices);
+        m_subsetOverlay.vertexCount = static_cast<GLsizei>(vertices);
+    } else {
+        const ContourSurface surface = m_subset.surface(pointValues, cellValues);
+        const size_t capacity = m_subsetOverlay.capacity;
+        uploadOverlay(m_subsetOverlay, surface, vertices > capacity ? std::max(vertices, capacity * 2) : capacity);
+        m_subsetColorsStale = false;
+    }
+    doneCurrent();
+    update();
+}
+
+void GLWidget::updateIso()
+{
+    if (!m_isoEnabled || !m_grid) return;
+    QElapsedTimer timer;
+    timer.start();
+    
+    // The field is gathered on first use and kept while only the isovalue moves
+    if (!m_isosurface.hasField()) {
+        auto it = m_grid->point_data.find(m_isoArray.toStdString());
+        if (it == m_grid->point_data.end() || !it->second) {
+            m_isoOverlay.vertexCount = 0;
+            m_isoSurface = ContourSurface();
+            emit statusMessage("等值面: 请选择点数据数组");
+            update();
+            return;
+        }
+        m_isosurface.setField(MeshProcessor::tupleValues(*it->second, -1));
+    }
+    float lo, hi;
+    m_isosurface.valueRange(lo, hi);
+    if (lo > hi) {
+        m_isoOverlay.vertexCount = 0;
+        m_isoSurface = ContourSurface();
+        emit statusMessage("等值面: 网格中没有三维单元");
+        update();
+        return;
+    }
+    const float isovalue = rangeAt(lo, hi, m_isoPosition);
+    
+    const size_t expected = static_cast<size_t>(m_overlayValuesArePoint ? m_grid->num_points : m_grid->num_cells);
+    const float* values = m_overlayValues.size() == expected ? m_overlayValues.data() : nullptr;
+    m_isoSurface = m_isosurface.contour(isovalue, m_overlayValuesArePoint ? values : nullptr,
+                                        m_overlayValuesArePoint ? nullptr : values);
+    
+    makeCurrent();
+    uploadOverlay(m_isoOverlay, m_isoSurface);
+    doneCurrent();
+    
+    emit statusMessage(QString("等值面 %1 = %2: %3 三角形, %4 个候选单元, %5 ms")
+                       .arg(m_isoArray).arg(isovalue).arg(m_isoSurface.triangleCount())
+                       .arg(m_isosurface.candidateCount()).arg(timer.elapsed()));
+    update();
+}
+
+std::vector<float> GLWidget::overlayScalars(const ContourSurface& surface) const
+{
+    // Normalized like the surface's scalar stream, against the current color range
+    std::vector<float> scalars(surface.vertexCount(), 0.0f);
+    if (!surface.scalars.empty()) {
+        float range = m_meshData.scalarMax - m_meshData.scalarMin;
+        if (range < 1e-10f) range = 1.0f;
+        const float invRange = 1.0f / range;
+        for (size_t v = 0; v < scalars.size(); ++v) {
+            scalars[v] = (surface.scalars[v] - m_meshData.scalarMin) * invRange;
+        }
+    }
+    return scalars;
+}
+
+void GLWidget::uploadOverlay(OverlayBuffer& overlay, const ContourSurface& surface, size_t capacity)
+{
+    if (!overlay.vao.isCreated()) {
+        overlay.vao.create();
+        overlay.vertices.create();
+        overlay.vertices.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+        overlay.scalars.create();
+        overlay.scalars.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+    }
+    
+    const std::vector<float> scalars = overlayScalars(surface);
+    const size_t vertices = surface.vertexCount();
+    const bool grow = vertices > overlay.capacity || capacity > overlay.capacity;
+    if (grow) overlay.capacity = std::max(vertices, capacity);
+    
+    overlay.vao.bind();
+    overlay.vertices.bind();
+    if (grow) overlay.vertices.allocate(static_cast<int>(overlay.capacity * 6 * sizeof(float)));
+    overlay.vertices.write(0, surface.vertexData.data(), static_cast<int>(surface.vertexData.size() * sizeof(float)));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), nullptr);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), reinterpret_cast<void*>(3 * sizeof(float)));
+    overlay.scalars.bind();
+    if (grow) overlay.scalars.allocate(static_cast<int>(overlay.capacity * sizeof(float)));
+    overlay.scalars.write(0, scalars.data(), static_cast<int>(scalars.size() * sizeof(float)));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(float), nullptr);
+    overlay.vao.release();
+    overlay.vertexCount = static_cast<GLsizei>(vertices);
+}
+
+void GLWidget::patchOverlay(OverlayBuffer& overlay, const ContourSurface& surface,
+                            const std::vector<uint32_t>& entries, size_t entryVertices)
+{
+    const std::vector<float> scalars = overlayScalars(surface);
+    for (size_t i = 0; i < entries.size(); ) {
+        size_t end = i + 1;
+        while (end < entries.size() && entries[end] == entries[end - 1] + 1) ++end;
+        const size_t first = static_cast<size_t>(entries[i]) * entryVertices;
+        const size_t count = (end - i) * entryVertices;
+        overlay.vertices.bind();
+        overlay.vertices.write(static_cast<int>(first * 6 * sizeof(float)), &surface.vertexData[i * entryVertices * 6],
+                               static_cast<int>(count * 6 * sizeof(float)));
+        overlay.scalars.bind();
+        overlay.scalars.write(static_cast<int>(first * sizeof(float)), &scalars[i * entryVertices],
+                              static_cast<int>(count * sizeof(float)));
+        i = end;
+    }
+    overlay.scalars.release();
+}
+
+void GLWidget::releaseOverlay(OverlayBuffer& overlay)
+{
+    if (!overlay.vao.isCreated()) return;
+    overlay.vertices.destroy();
+    overlay.scalars.destroy();
+    overlay.vao.destroy();
+    overlay.vertexCount = 0;
+    overlay.capacity = 0;
+}
+
+void GLWidget::drawOverlay(OverlayBuffer& overlay, const QMatrix4x4& mvp, const QMatrix4x4& modelView,
+                           const QMatrix3x3& normalMatrix)
+{
+    if (overlay.vertexCount == 0) return;
+    
+    // Plain float vertices with CPU-mapped scalars
+    glDisable(GL_CULL_FACE);
+    m_meshShader->bind();
+    m_meshShader->setUniformValue("compactVertices", 0);
+    m_meshShader->setUniformValue("scalarLookup", 0);
+    m_meshShader->setUniformValue("mvp", mvp);
+    m_meshShader->setUniformValue("modelView", modelView);
+    m_meshShader->setUniformValue("normalMatrix", normalMatrix);
+    m_meshShader->setUniformValue("lightDir", m_lightDir);
+    m_meshShader->setUniformValue("solidColor", m_solidColor);
+    m_meshShader->setUniformValue("physicalData", static_cast<int>(m_physicalData));
+    m_meshShader->setUniformValue("colorMode", static_cast<int>(m_colorMode));
+    m_meshShader->setUniformValue("scalarMin", m_meshData.scalarMin);
+    m_meshShader->setUniformValue("scalarMax", m_meshData.scalarMax);
+    m_meshShader->setUniformValue("twoSidedLighting", 1);
+    m_meshShader->setUniformValue("renderPoints", 0);
+    
+    overlay.vao.bind();
+    glDrawArrays(GL_TRIANGLES, 0, overlay.vertexCount);
+    overlay.vao.release();
+    m_meshShader->release();
+}
+
 void GLWidget::setColorMode(ColorMode mode)
 {
     m_colorMode= mode;
@@ -609,6 +1755,8 @@ void GLWidget::mouseMoveEvent(QMouseEvent *event)
     } else if (m_rightMousePressed || m_middleMousePressed) {
         m_camera.pan(delta.x(), delta.y());
         update();
+    } else {
+        probe(event->pos());
     }
     
     m_lastMousePos = event->pos();
@@ -623,10 +1771,90 @@ void GLWidget::mouseReleaseEvent(QMouseEvent *event)
     } else if (event->button() == Qt::MiddleButton) {
         m_middleMousePressed = false;
     }
+    // Back to the full mesh once the camera is idle
+    if (!m_lodBuffers.empty()) update();
+}
+
+void GLWidget::probe(const QPoint& pos)
+{
+    if (!m_grid || width() <= 0 || height() <= 0) return;
+    QElapsedTimer timer;
+    timer.start();
+    
+    // Ray through the pixel centre, from the near to the far plane
+    const QMatrix4x4 inverse = (m_camera.projectionMatrix() * m_camera.viewMatrix()).inverted();
+    const float x = 2.0f * (pos.x() + 0.5f) / width() - 1.0f;
+    const float y = 1.0f - 2.0f * (pos.y() + 0.5f) / height();
+    const QVector3D nearPoint = inverse.map(QVector3D(x, y, -1.0f));
+    const QVector3D farPoint = inverse.map(QVector3D(x, y, 1.0f));
+    const float origin[3] = {nearPoint.x(), nearPoint.y(), nearPoint.z()};
+    const float direction[3] = {farPoint.x() - nearPoint.x(), farPoint.y() - nearPoint.y(),
+                                farPoint.z() - nearPoint.z()};
+    
+    // Picked against what is drawn: the overlays standing in for the surface, else the surface
+    uint32_t cell = 0, point = 0;
+    bool found = false;
+    const bool subsetShown = m_clipEnabled || m_thresholdEnabled || m_regionsEnabled;
+    if (subsetShown || m_isoEnabled) {
+        float nearest = std::numeric_limits<float>::infinity();
+        float distance;
+        uint32_t hitCell, hitPoint;
+        if (subsetShown && m_subset.pick(origin, direction, distance, hitCell, hitPoint)) {
+            nearest = distance;
+            cell = hitCell;
+            point = hitPoint;
+            found = true;
+        }
+        if (m_isoEnabled && m_isosurface.pick(m_isoSurface, origin, direction, distance, hitCell, hitPoint)
+            && distance < nearest) {
+            cell = hitCell;
+            point = hitPoint;
+            found = true;
+        }
+    } else if (m_bvh) {
+        const TriangleBvh::Hit hit = m_bvh->intersect(m_meshData, origin, direction, m_partHidden);
+        if (hit.valid() && hit.triangle < m_meshData.triangleToCellIndex.size()) {
+            // Cell of the triangle; point of the corner nearest to the hit
+            const float weights[3] = {1.0f - hit.u - hit.v, hit.u, hit.v};
+            const int corner = static_cast<int>(std::max_element(weights, weights + 3) - weights);
+            const uint32_t vertex = m_meshData.triangleIndices[hit.triangle * 3 + corner];
+            cell = m_meshData.triangleToCellIndex[hit.triangle];
+            point = vertex < m_meshData.vertexToPointIndex.size() ? m_meshData.vertexToPointIndex[vertex] : 0;
+            found = true;
+        }
+    }
+    if (!found) {
+        if (m_probeShown) emit statusMessage(QString());
+        m_probeShown = false;
+        return;
+    }
+    
+    const bool isPointData = m_physicalData == PointData;
+    double value = std::numeric_limits<double>::quiet_NaN();
+    if ((isPointData || m_physicalData == CellData) && !m_activeDataArray.isEmpty()) {
+        const auto& arrays = isPointData ? m_grid->point_data : m_grid->cell_data;
+        auto it = arrays.find(m_activeDataArray.toStdString());
+        if (it != arrays.end() && it->second) {
+            value = MeshProcessor::arrayValue(*it->second, isPointData ? point : cell, m_activeComponent);
+        }
+    }
+    const qint64 nsecs = timer.nsecsElapsed();
+    
+    // Ids as in the file, also after spatial reordering
+    const uint32_t fileCell = cell < m_grid->original_cell_ids.size() ? m_grid->original_cell_ids[cell] : cell;
+    const uint32_t filePoint = point < m_grid->original_point_ids.size() ? m_grid->original_point_ids[point] : point;
+    QString message = QString("单元 %1 | 点 %2").arg(fileCell).arg(filePoint);
+    if (!std::isnan(value)) {
+        message += QString(" | %1: %2").arg(m_activeDataArray).arg(value, 0, 'g', 6);
+    }
+    message += QString(" | 拾取 %1 µs").arg(nsecs / 1000.0, 0, 'f', 1);
+    emit statusMessage(message);
+    m_probeShown = true;
 }
 
 void GLWidget::wheelEvent(QWheelEvent *event)
 {
     m_camera.zoom(event->angleDelta().y());
+    m_interactionTimer.start();
     update();
 }
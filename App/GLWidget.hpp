@@ -10,10 +10,21 @@
 #include <QWheelEvent>
 #include <QElapsedTimer>
 #include <QTimer>
+#include <QHash>
+#include <atomic>
 #include <memory>
+#include <thread>
+#include <vector>
 
 #include "Camera.hpp"
 #include "MeshProcessor.hpp"
+#include "MeshLod.hpp"
+#include "TriangleBvh.hpp"
+#include "PlaneSlicer.hpp"
+#include "PlaneClipper.hpp"
+#include "CellThreshold.hpp"
+#include "RegionVisibility.hpp"
+#include "Isosurface.hpp"
 #include "Loader.hpp"
 
 class GLWidget : public QOpenGLWidget, protected QOpenGLFunctions_4_3_Core
@@ -51,18 +62,55 @@ public:
     void setRenderMode(RenderMode mode);
     void setPhysicalValue(PhysicalData mode);
     void setActiveDataArray(const QString& name);
+    void setActiveComponent(int component);  // -1: 模长
+    void setGpuScalarLookup(bool enabled);
+    void setScalarRangeMode(MeshProcessor::ScalarRange mode);
+    void setSpatialReorder(bool enabled) { m_spatialReorder = enabled; }  // 下次加载生效
+    void setWeldPoints(bool enabled) { m_weldPoints = enabled; }          // 下次加载生效
+    void setWeldTolerance(double relative) { m_weldTolerance = relative; } // Fraction of the bounding box diagonal
     void setColorMode(ColorMode mode);
     void setPointSize(int size);
+    void setShadingMode(MeshProcessor::ShadingMode mode);
+    void setVertexFormat(VertexFormat format);
+    void setOptimizeIndices(bool enabled);
+    void setSubdivideCurved(bool enabled);  // Quadratic cells through their mid-edge nodes
+    void setFeatureAngle(int degrees);
+    void setSliceEnabled(bool enabled);
+    void setSliceAxis(int axis);            // 0: X, 1: Y, 2: Z
+    void setSlicePosition(int permille);    // Along the mesh extent, 0-1000
+    void setClipEnabled(bool enabled);
+    void setClipAxis(int axis);             // 0: X, 1: Y, 2: Z
+    void setClipPosition(int permille);     // Along the mesh extent, 0-1000
+    void setThresholdEnabled(bool enabled);
+    void setThresholdArray(const QString& name);  // Cell data array to filter by (magnitude of vectors)
+    void setThresholdMin(int permille);           // Along the array's range, 0-1000
+    void setThresholdMax(int permille);
+    void setRegionArray(const QString& name);  // Integer cell data array naming the regions; empty turns them off
+    void setRegionVisible(int region, bool visible);
+    void setShowInterfaces(bool enabled);      // Faces between visible regions
+    QStringList regionLabels() const;          // One per region of the array, in ascending id order
+    void setPartMode(int mode);                // 0: 无, 1: 体单元连通, 2: 表面连通
+    void setPartVisible(int part, bool visible);
+    void isolatePart(int part);                // Hides every other part
+    void showAllParts();
+    void setPartColoring(bool enabled);        // One color per part (solid color mode)
+    QStringList partLabels() const;            // One per connected part, in triangle order
+    QString interpolateCellArray(const QString& name);  // Adds a smooth point array; returns its name
+    void setIsoEnabled(bool enabled);
+    void setIsoArray(const QString& name);  // Point data array to contour (magnitude of vectors)
+    void setIsoValue(int permille);         // Along the array's range over the 3D cells, 0-1000
     // void setLineWidth(int width);
     
     QPair<int64_t, int64_t> getMeshStats() const;
     QStringList getPointDataArrayNames() const;
     QStringList getCellDataArrayNames() const;
+    int getArrayComponentCount(const QString& name, bool isPointData) const;
 
 signals:
     void statusMessage(const QString& message);
     void meshLoaded();
     void dataArraysUpdated();
+    void partsChanged();  // The surface was (re)processed; every part is visible again
 
 protected:
     void initializeGL() override;
@@ -78,6 +126,73 @@ private:
     void setupShaders();
     void setupBuffers();
     void updateBuffers();
+    void rebuildMesh();
+    const void* vertexBufferData() const;
+    int vertexBufferSize() const;
+    const void* scalarBufferData() const;
+    int scalarBufferSize() const;
+    void bindScalarAttribute();
+    void setVertexFormatUniforms(QOpenGLShaderProgram& shader);
+    
+    // GPU scalar lookup: raw arrays as shader storage buffers, uploaded on first use
+    struct ArrayBuffer {
+        GLuint buffer = 0;
+        int components = 1;
+        GLuint tuples = 0;
+    };
+    void uploadStorageBuffer(GLuint buffer, const void* data, size_t bytes);
+    ArrayBuffer arrayBuffer(const QString& name, bool isPointData);  // buffer 0 if missing
+    void releaseArrayBuffers();
+    void reportArrayStatistics(const QString& name, bool isPointData);
+    void setScalarLookupUniforms(QOpenGLShaderProgram& shader);
+    
+    // Built on a worker thread after every (re)process: the picking BVH, then the LOD chain
+    // that is drawn while the camera moves
+    struct LodBuffer {
+        QOpenGLBuffer indices{QOpenGLBuffer::IndexBuffer};
+        GLuint cells = 0;  // triangle -> cell for gl_PrimitiveID lookups
+        GLsizei indexCount = 0;
+    };
+    void startMeshWorker();
+    void stopMeshWorker();  // Cancels and joins the worker, drops the BVH; m_meshData may be replaced afterwards
+    void uploadLods(std::vector<MeshLod::Level>& levels);
+    void releaseLods();
+    LodBuffer* interactionLod();
+    bool isInteracting() const;
+    void probe(const QPoint& pos);  // Cell, point and active value under the cursor to the status bar
+    void drawTriangles();
+    void drawPartRanges();  // Visible parts only, one draw per run (or per part when colored)
+    void resetParts();      // After m_meshData was replaced
+    // Vertex and line cells, in every render mode
+    void drawCellPrimitives(const QMatrix4x4& mvp, const QMatrix4x4& modelView, const QMatrix3x3& normalMatrix);
+    
+    // Filter output drawn next to the surface: unindexed triangles, position + normal and a
+    // scalar already normalized to the color range
+    struct OverlayBuffer {
+        QOpenGLVertexArrayObject vao;
+        QOpenGLBuffer vertices;
+        QOpenGLBuffer scalars;
+        GLsizei vertexCount = 0;
+        size_t capacity = 0;  // Vertices the buffers have room for
+    };
+    std::vector<float> overlayScalars(const ContourSurface& surface) const;
+    // Replaces the contents; the buffers are reallocated only to grow past `capacity` vertices
+    void uploadOverlay(OverlayBuffer& overlay, const ContourSurface& surface, size_t capacity = 0);
+    // Overwrites entry entries[i] with vertices [i * entryVertices, (i + 1) * entryVertices) of
+    // `surface`, one write per run of consecutive entries
+    void patchOverlay(OverlayBuffer& overlay, const ContourSurface& surface,
+                      const std::vector<uint32_t>& entries, size_t entryVertices);
+    void releaseOverlay(OverlayBuffer& overlay);
+    void drawOverlay(OverlayBuffer& overlay, const QMatrix4x4& mvp, const QMatrix4x4& modelView,
+                     const QMatrix3x3& normalMatrix);
+    void updateOverlayValues();  // Active array as one float per tuple, for the filters
+    void refreshOverlays();      // Recomputes the filters after a color change
+    void updateSlice();
+    void updateClip();
+    void updateThreshold();
+    void uploadSubset();  // Boundary of the kept cells, after a clip, threshold or region change
+    void updateIso();
+    void setClipUniforms(QOpenGLShaderProgram& shader);
     void renderMesh();
     void renderAxes();
     
@@ -89,9 +204,67 @@ private:
     // Buffers
     QOpenGLVertexArrayObject m_meshVAO;
     QOpenGLBuffer m_vertexBuffer;
+    QOpenGLBuffer m_scalarBuffers[2];
+    int m_activeScalarBuffer = 0;
+    QOpenGLBuffer m_vertexPointBuffer;
+    GLuint m_triangleCellBuffer = 0;
+    GLuint m_vertexCellBuffer = 0;
+    QHash<QString, ArrayBuffer> m_arrayBuffers;
+    ArrayBuffer m_activeArray;
+    bool m_activeArrayIsPoint = true;
     QOpenGLBuffer m_triangleIndexBuffer;
     QOpenGLBuffer m_lineIndexBuffer;
     QOpenGLBuffer m_pointIndexBuffer;
+    QOpenGLBuffer m_cellLineIndexBuffer;
+    QOpenGLBuffer m_cellPointIndexBuffer;
+    std::vector<LodBuffer> m_lodBuffers;  // Finest first
+    std::thread m_meshWorker;
+    std::atomic<bool> m_workerCancel{false};
+    int m_workerGeneration = 0;
+    QTimer m_interactionTimer;  // Keeps the coarse level up briefly after wheel zooming
+    std::shared_ptr<TriangleBvh> m_bvh;  // Over m_meshData's triangles; null until the worker is done
+    bool m_probeShown = false;
+    
+    // Slice: the surface is clipped away in front of the plane, the cut is an overlay
+    PlaneSlicer m_slicer;
+    OverlayBuffer m_sliceOverlay;
+    bool m_sliceEnabled = false;
+    int m_sliceAxis = 2;
+    float m_slicePosition = 0.5f;
+    QVector3D m_sliceNormal{0.0f, 0.0f, 1.0f};
+    float m_sliceOffset = 0.0f;
+    std::vector<float> m_overlayValues;  // Empty, or one per point / cell of the active array
+    bool m_overlayValuesArePoint = true;
+    
+    // Cells kept by the crinkle clip, the threshold and the regions; their boundary replaces the surface
+    SubsetSurface m_subset;
+    OverlayBuffer m_subsetOverlay;  // Mirrors the shown face list, patched where it changed
+    bool m_subsetColorsStale = true;
+    PlaneClipper m_clipper{m_subset};
+    bool m_clipEnabled = false;
+    int m_clipAxis = 2;
+    float m_clipPosition = 0.5f;
+    CellThreshold m_threshold{m_subset};
+    bool m_thresholdEnabled = false;
+    QString m_thresholdArray;
+    float m_thresholdMin = 0.0f;  // Fractions of the array's range
+    float m_thresholdMax = 1.0f;
+    RegionVisibility m_regions{m_subset};
+    bool m_regionsEnabled = false;
+    QString m_regionArray;
+    bool m_interfacesEnabled = false;
+    
+    // Connected parts of the surface, shown or hidden through their triangle ranges
+    std::vector<uint8_t> m_partHidden;
+    bool m_partColoring = false;
+    
+    // Isosurface of a point array; like the clip it stands in for the surface
+    Isosurface m_isosurface;
+    OverlayBuffer m_isoOverlay;
+    ContourSurface m_isoSurface;  // What m_isoOverlay shows, kept for picking
+    bool m_isoEnabled = false;
+    QString m_isoArray;
+    float m_isoPosition = 0.5f;
     
     QOpenGLVertexArrayObject m_axesVAO;
     QOpenGLBuffer m_axesBuffer;
@@ -115,6 +288,11 @@ private:
     PhysicalData m_physicalData = SolidColor;
     ColorMode m_colorMode = Viridis;
     QString m_activeDataArray;
+    int m_activeComponent = -1;
+    bool m_gpuScalarLookup = true;
+    bool m_spatialReorder = true;
+    bool m_weldPoints = false;
+    double m_weldTolerance = 0.0;
     float m_pointSize = 5.0f;
     // float m_lineWidth = 1.0f;
     
@@ -0,0 +1,87 @@
+#include "IntervalIndex.hpp"
+#include "Parallel.hpp"
+#include "RadixSort.hpp"
+#include <algorithm>
+
+void IntervalIndex::clear()
+{
+    m_min.clear();
+    m_max.clear();
+    m_ids.clear();
+    m_blockMax.clear();
+    m_lowest = 1.0f;
+    m_highest = 0.0f;
+}
+
+void IntervalIndex::build(const std::vector<float>& mins, const std::vector<float>& maxs)
+{
+    clear();
+    const size_t count = std::min(mins.size(), maxs.size());
+
+    // Non-empty intervals only (NaN bounds fail the comparison as well)
+    m_ids = Parallel::collect<uint32_t>(count,
+        [&](size_t i) { return mins[i] <= maxs[i]; },
+        [](size_t i) { return static_cast<uint32_t>(i); });
+    if (m_ids.empty()) return;
+
+    const int64_t n = static_cast<int64_t>(m_ids.size());
+    std::vector<uint32_t> keys(m_ids.size());
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < n; ++i) {
+        keys[i] = RadixSort::floatKey(mins[m_ids[i]]);
+    }
+    RadixSort::sortPairs(keys, m_ids, 32, [](uint32_t key, int shift) { return (key >> shift) & 0xFF; });
+
+    m_min.resize(m_ids.size());
+    m_max.resize(m_ids.size());
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < n; ++i) {
+        m_min[i] = mins[m_ids[i]];
+        m_max[i] = maxs[m_ids[i]];
+    }
+
+    const int64_t blocks = static_cast<int64_t>((m_ids.size() + kBlockSize - 1) / kBlockSize);
+    m_blockMax.resize(static_cast<size_t>(blocks));
+    #pragma omp parallel for schedule(static)
+    for (int64_t b = 0; b < blocks; ++b) {
+        const size_t begin = static_cast<size_t>(b) * kBlockSize;
+        const size_t end = std::min(begin + kBlockSize, m_ids.size());
+        m_blockMax[b] = *std::max_element(m_max.begin() + begin, m_max.begin() + end);
+    }
+    m_lowest = m_min.front();
+    m_highest = *std::max_element(m_blockMax.begin(), m_blockMax.end());
+}
+
+std::vector<uint32_t> IntervalIndex::stab(float value) const
+{
+    // Intervals starting after value are past the upper bound of the sorted mins
+    const size_t end = static_cast<size_t>(std::upper_bound(m_min.begin(), m_min.end(), value) - m_min.begin());
+    const size_t blocks = (end + kBlockSize - 1) / kBlockSize;
+    const int chunks = std::max(1, std::min(Parallel::maxThreads(), static_cast<int>(blocks / 1024) + 1));
+
+    // Per-chunk hits, concatenated in chunk order
+    std::vector<std::vector<uint32_t>> chunkHits(chunks);
+    #pragma omp parallel for schedule(static, 1) num_threads(chunks)
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        size_t firstBlock, lastBlock;
+        Parallel::chunkRange(blocks, chunks, chunk, firstBlock, lastBlock);
+        std::vector<uint32_t>& hits = chunkHits[chunk];
+        for (size_t b = firstBlock; b < lastBlock; ++b) {
+            if (m_blockMax[b] < value) continue;
+            const size_t stop = std::min((b + 1) * kBlockSize, end);
+            for (size_t i = b * kBlockSize; i < stop; ++i) {
+                if (m_max[i] >= value) hits.push_back(m_ids[i]);
+            }
+        }
+    }
+
+    std::vector<size_t> offsets(chunks + 1, 0);
+    for (int chunk = 0; chunk < chunks; ++chunk) offsets[chunk] = chunkHits[chunk].size();
+    const size_t total = Parallel::exclusiveScan(offsets);
+    std::vector<uint32_t> result(total);
+    #pragma omp parallel for schedule(static, 1) num_threads(chunks)
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        std::copy(chunkHits[chunk].begin(), chunkHits[chunk].end(), result.begin() + offsets[chunk]);
+    }
+    return result;
+}
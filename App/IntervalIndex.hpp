@@ -0,0 +1,42 @@
+#ifndef INTERVALINDEX_HPP
+#define INTERVALINDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Stabbing queries over one closed interval [min, max] per id (cell extents along a
+// plane normal, cell scalar ranges). Intervals are sorted by min, so the candidates for
+// a value v are a prefix; within it, blocks whose largest max is below v are skipped.
+// Intervals are short compared to the whole range in practice, so a query touches the
+// blocks near v plus one comparison per skipped block.
+class IntervalIndex
+{
+public:
+    static constexpr size_t kBlockSize = 256;
+
+    // mins[i], maxs[i] is the interval of id i. Empty intervals (min > max, e.g. for
+    // cells that are not indexed) are never reported.
+    void build(const std::vector<float>& mins, const std::vector<float>& maxs);
+    void clear();
+
+    // Ids whose interval contains value, in order of increasing min
+    std::vector<uint32_t> stab(float value) const;
+
+    bool empty() const { return m_ids.empty(); }
+    size_t size() const { return m_ids.size(); }
+
+    // Smallest min and largest max over all intervals (min > max when empty)
+    float lowest() const { return m_lowest; }
+    float highest() const { return m_highest; }
+
+private:
+    std::vector<float> m_min;       // Sorted ascending
+    std::vector<float> m_max;       // Same order
+    std::vector<uint32_t> m_ids;    // Same order
+    std::vector<float> m_blockMax;  // Largest max of each block of kBlockSize entries
+    float m_lowest = 1.0f;
+    float m_highest = 0.0f;
+};
+
+#endif // INTERVALINDEX_HPP
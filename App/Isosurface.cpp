@@ -0,0 +1,113 @@
+#include "Isosurface.hpp"
+#include "CellTopology.hpp"
+#include "TriangleBvh.hpp"
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <algorithm>
+#include <limits>
+
+Q_LOGGING_CATEGORY(isosurfaceLog, "VTKViewer.Isosurface")
+
+void Isosurface::setGrid(const std::shared_ptr<UnstructuredGrid>& grid)
+{
+    m_grid = grid;
+    m_cellOffsets.clear();
+    m_positions.clear();
+    m_field.clear();
+    m_index.clear();
+    m_indexValid = false;
+    m_candidateCount = 0;
+}
+
+void Isosurface::setField(std::vector<float> values)
+{
+    m_field = std::move(values);
+    m_index.clear();
+    m_indexValid = false;
+}
+
+void Isosurface::valueRange(float& min, float& max)
+{
+    buildIndex();
+    min = m_index.lowest();
+    max = m_index.highest();
+}
+
+void Isosurface::buildIndex()
+{
+    if (m_indexValid || !m_grid || !m_grid->points || m_field.empty()) return;
+    QElapsedTimer timer;
+    timer.start();
+
+    // Geometry and cell addressing are kept across fields
+    if (m_positions.empty()) {
+        const size_t numPoints = static_cast<size_t>(std::max<int64_t>(m_grid->num_points, 0));
+        m_positions = CellTopology::pointPositions(*m_grid->points, numPoints);
+        m_cellOffsets = CellTopology::cellOffsets(*m_grid);
+    }
+
+    const size_t numPoints = m_positions.size() / 3;
+    if (m_field.size() < numPoints) {
+        qWarning(isosurfaceLog) << "Field has" << m_field.size() << "values for" << numPoints << "points";
+        return;
+    }
+    std::vector<float> mins, maxs;
+    Contour::cellRanges(*m_grid, m_cellOffsets, m_field.data(), numPoints, mins, maxs);
+    m_index.build(mins, maxs);
+    m_indexValid = true;
+    qInfo(isosurfaceLog) << "Isosurface index" << m_index.size() << "cells in" << timer.elapsed() << "ms";
+}
+
+ContourSurface Isosurface::contour(float isovalue, const float* pointScalars, const float* cellScalars)
+{
+    buildIndex();
+    if (!m_indexValid) return ContourSurface();
+
+    QElapsedTimer timer;
+    timer.start();
+    const std::vector<uint32_t> candidates = m_index.stab(isovalue);
+    m_candidateCount = candidates.size();
+    ContourSurface surface = Contour::contourCells(*m_grid, m_cellOffsets, m_positions, candidates,
+                                                   m_field.data(), isovalue, pointScalars, cellScalars);
+    qInfo(isosurfaceLog) << "Isosurface" << surface.triangleCount() << "tris from" << m_candidateCount
+                         << "cells in" << timer.elapsed() << "ms";
+    return surface;
+}
+
+bool Isosurface::pick(const ContourSurface& surface, const float origin[3], const float direction[3],
+                      float& distance, uint32_t& cell, uint32_t& point) const
+{
+    auto corners = [&surface](size_t t, float* p0, float* p1, float* p2) {
+        const float* v = &surface.vertexData[t * 18];
+        for (int a = 0; a < 3; ++a) {
+            p0[a] = v[a];
+            p1[a] = v[6 + a];
+            p2[a] = v[12 + a];
+        }
+        return true;
+    };
+    const TriangleBvh::Hit hit = TriangleBvh::intersectEach(surface.triangleCount(), corners, origin, direction);
+    if (!hit.valid() || surface.triangleCells[hit.triangle] >= m_cellOffsets.size() || !m_grid) return false;
+
+    // The triangle's corners lie on edges; report the cell's point nearest to the hit
+    cell = surface.triangleCells[hit.triangle];
+    const float at[3] = {origin[0] + hit.distance * direction[0], origin[1] + hit.distance * direction[1],
+                         origin[2] + hit.distance * direction[2]};
+    const int32_t* record = &m_grid->cells[m_cellOffsets[cell]];
+    const uint32_t numPoints = static_cast<uint32_t>(m_positions.size() / 3);
+    const uint8_t type = cell < m_grid->cell_types.size() ? m_grid->cell_types[cell] : 0;
+    float nearest = std::numeric_limits<float>::infinity();
+    point = 0;
+    CellTopology::visitPointSlots(type, record, [&](int32_t k) {
+        if (record[k] < 0 || static_cast<uint32_t>(record[k]) >= numPoints) return;
+        const float* p = &m_positions[static_cast<size_t>(record[k]) * 3];
+        const float d = (p[0] - at[0]) * (p[0] - at[0]) + (p[1] - at[1]) * (p[1] - at[1])
+                      + (p[2] - at[2]) * (p[2] - at[2]);
+        if (d < nearest) {
+            nearest = d;
+            point = static_cast<uint32_t>(record[k]);
+        }
+    });
+    distance = hit.distance;
+    return true;
+}
@@ -0,0 +1,49 @@
+#ifndef ISOSURFACE_HPP
+#define ISOSURFACE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Contour.hpp"
+#include "IntervalIndex.hpp"
+#include "Loader.hpp"
+
+// Isosurfaces of one point field over the 3D cells. Setting the field indexes every
+// cell's [min, max] of it once; an isovalue then only contours the cells whose range
+// contains it, so dragging the value costs time in the cut cells rather than the mesh.
+class Isosurface
+{
+public:
+    void setGrid(const std::shared_ptr<UnstructuredGrid>& grid);  // Drops the field
+    void setField(std::vector<float> values);  // One value per point; indexed on the next contour
+    bool hasField() const { return !m_field.empty(); }
+
+    // Range of isovalues that cut the indexed cells (min > max without 3D cells)
+    void valueRange(float& min, float& max);
+
+    // Triangles facing towards growing field; colors as in Contour::contourCells
+    ContourSurface contour(float isovalue, const float* pointScalars, const float* cellScalars);
+
+    // Triangle of `surface` (from contour()) hit first by origin + t * direction (t >= 0),
+    // testing every triangle: its distance along the ray, its cell and the cell's point
+    // nearest to the hit
+    bool pick(const ContourSurface& surface, const float origin[3], const float direction[3],
+              float& distance, uint32_t& cell, uint32_t& point) const;
+
+    // Cells contoured by the last contour()
+    size_t candidateCount() const { return m_candidateCount; }
+
+private:
+    void buildIndex();
+
+    std::shared_ptr<UnstructuredGrid> m_grid;
+    std::vector<size_t> m_cellOffsets;
+    std::vector<float> m_positions;
+    std::vector<float> m_field;
+    IntervalIndex m_index;
+    bool m_indexValid = false;
+    size_t m_candidateCount = 0;
+};
+
+#endif // ISOSURFACE_HPP
@@ -66,6 +66,42 @@ void MainWindow::setupDockWidget()
     m_renderModeCombo->addItem("表面", 4);  // Surface双面表面渲染
     renderLayout->addWidget(m_renderModeCombo);
     
+    m_shadingCombo = new QComboBox();
+    m_shadingCombo->addItem("平面着色", 0);//Flat
+    m_shadingCombo->addItem("平滑着色", 1);//Smooth, shared vertices
+    renderLayout->addWidget(m_shadingCombo);
+    
+    m_vertexFormatCombo = new QComboBox();
+    m_vertexFormatCombo->addItem("压缩顶点 (12字节)", 0);//Compact
+    m_vertexFormatCombo->addItem("完整顶点 (28字节)", 1);//Full precision
+    renderLayout->addWidget(m_vertexFormatCombo);
+    
+    m_optimizeIndicesCheck = new QCheckBox("顶点缓存优化 (平滑着色)");
+    m_optimizeIndicesCheck->setChecked(true);
+    renderLayout->addWidget(m_optimizeIndicesCheck);
+    
+    m_subdivideCurvedCheck = new QCheckBox("细分二次单元曲面");
+    m_subdivideCurvedCheck->setChecked(false);
+    renderLayout->addWidget(m_subdivideCurvedCheck);
+    
+    m_spatialReorderCheck = new QCheckBox("空间重排序 (下次加载生效)");
+    m_spatialReorderCheck->setChecked(true);
+    renderLayout->addWidget(m_spatialReorderCheck);
+    
+    m_weldPointsCheck = new QCheckBox("合并重合点 (下次加载生效)");
+    m_weldPointsCheck->setChecked(false);
+    renderLayout->addWidget(m_weldPointsCheck);
+    
+    QLabel* weldToleranceLabel = new QLabel("合并容差 (相对包围盒对角线):");
+    m_weldToleranceCombo = new QComboBox();
+    m_weldToleranceCombo->addItem("0 (坐标相同)", 0.0);
+    m_weldToleranceCombo->addItem("1e-7", 1e-7);
+    m_weldToleranceCombo->addItem("1e-6", 1e-6);
+    m_weldToleranceCombo->addItem("1e-5", 1e-5);
+    m_weldToleranceCombo->addItem("1e-4", 1e-4);
+    renderLayout->addWidget(weldToleranceLabel);
+    renderLayout->addWidget(m_weldToleranceCombo);
+    
     QLabel* pointSizeLabel = new QLabel("点大小:");
     m_pointSizeSlider = new QSlider(Qt::Horizontal);
     m_pointSizeSlider->setRange(1, 20);
@@ -73,6 +109,13 @@ void MainWindow::setupDockWidget()
     renderLayout->addWidget(pointSizeLabel);
     renderLayout->addWidget(m_pointSizeSlider);
     
+    QLabel* featureAngleLabel = new QLabel("线框特征角:");
+    m_featureAngleSlider = new QSlider(Qt::Horizontal);
+    m_featureAngleSlider->setRange(0, 90);  // 0: 显示所有边
+    m_featureAngleSlider->setValue(0);
+    renderLayout->addWidget(featureAngleLabel);
+    renderLayout->addWidget(m_featureAngleSlider);
+    
     // QLabel* lineWidthLabel = new QLabel("线宽:");
     // m_lineWidthSlider = new QSlider(Qt::Horizontal);
     // m_lineWidthSlider->setRange(1, 10);
@@ -99,6 +142,27 @@ void MainWindow::setupDockWidget()
     physicalLayout->addWidget(dataArrayLabel);
     physicalLayout->addWidget(m_dataArrayCombo);
     
+    m_interpolateButton = new QPushButton("插值到点 (平滑着色)");
+    m_interpolateButton->setEnabled(false);
+    physicalLayout->addWidget(m_interpolateButton);
+    
+    QLabel* componentLabel = new QLabel("分量:");
+    m_componentCombo = new QComboBox();
+    m_componentCombo->setEnabled(false);
+    physicalLayout->addWidget(componentLabel);
+    physicalLayout->addWidget(m_componentCombo);
+    
+    QLabel* scalarRangeLabel = new QLabel("颜色范围:");
+    m_scalarRangeCombo = new QComboBox();
+    m_scalarRangeCombo->addItem("最小值-最大值", 0);
+    m_scalarRangeCombo->addItem("1%-99%分位数", 1);  // 忽略离群值
+    physicalLayout->addWidget(scalarRangeLabel);
+    physicalLayout->addWidget(m_scalarRangeCombo);
+    
+    m_gpuLookupCheck = new QCheckBox("GPU标量查找");
+    m_gpuLookupCheck->setChecked(true);
+    physicalLayout->addWidget(m_gpuLookupCheck);
+    
     layout->addWidget(physicalGroup);
     //Color Mode Group
     QGroupBox* colorGroup = new QGroupBox("配色方案");
@@ -110,6 +174,142 @@ void MainWindow::setupDockWidget()
     m_colorModeCombo->addItem("rainbow",2);
     colorLayout->addWidget(m_colorModeCombo);
     layout->addWidget(colorGroup);
+    
+    // Slice Group
+    QGroupBox* sliceGroup = new QGroupBox("切片");
+    QVBoxLayout* sliceLayout = new QVBoxLayout(sliceGroup);
+    
+    m_sliceCheck = new QCheckBox("显示切片");
+    sliceLayout->addWidget(m_sliceCheck);
+    
+    m_sliceAxisCombo = new QComboBox();
+    m_sliceAxisCombo->addItem("法向 X", 0);
+    m_sliceAxisCombo->addItem("法向 Y", 1);
+    m_sliceAxisCombo->addItem("法向 Z", 2);
+    m_sliceAxisCombo->setCurrentIndex(2);
+    sliceLayout->addWidget(m_sliceAxisCombo);
+    
+    QLabel* slicePositionLabel = new QLabel("位置:");
+    m_slicePositionSlider = new QSlider(Qt::Horizontal);
+    m_slicePositionSlider->setRange(0, 1000);
+    m_slicePositionSlider->setValue(500);
+    sliceLayout->addWidget(slicePositionLabel);
+    sliceLayout->addWidget(m_slicePositionSlider);
+    layout->addWidget(sliceGroup);
+    
+    // Clip Group
+    QGroupBox* clipGroup = new QGroupBox("裁剪");
+    QVBoxLayout* clipLayout = new QVBoxLayout(clipGroup);
+    
+    m_clipCheck = new QCheckBox("按整单元裁剪");
+    clipLayout->addWidget(m_clipCheck);
+    
+    m_clipAxisCombo = new QComboBox();
+    m_clipAxisCombo->addItem("法向 X", 0);
+    m_clipAxisCombo->addItem("法向 Y", 1);
+    m_clipAxisCombo->addItem("法向 Z", 2);
+    m_clipAxisCombo->setCurrentIndex(2);
+    clipLayout->addWidget(m_clipAxisCombo);
+    
+    QLabel* clipPositionLabel = new QLabel("位置:");
+    m_clipPositionSlider = new QSlider(Qt::Horizontal);
+    m_clipPositionSlider->setRange(0, 1000);
+    m_clipPositionSlider->setValue(500);
+    clipLayout->addWidget(clipPositionLabel);
+    clipLayout->addWidget(m_clipPositionSlider);
+    layout->addWidget(clipGroup);
+    
+    // Threshold Group
+    QGroupBox* thresholdGroup = new QGroupBox("阈值");
+    QVBoxLayout* thresholdLayout = new QVBoxLayout(thresholdGroup);
+    
+    m_thresholdCheck = new QCheckBox("按单元数据筛选");
+    thresholdLayout->addWidget(m_thresholdCheck);
+    
+    QLabel* thresholdArrayLabel = new QLabel("单元数据:");
+    m_thresholdArrayCombo = new QComboBox();
+    thresholdLayout->addWidget(thresholdArrayLabel);
+    thresholdLayout->addWidget(m_thresholdArrayCombo);
+    
+    QLabel* thresholdMinLabel = new QLabel("下限:");
+    m_thresholdMinSlider = new QSlider(Qt::Horizontal);
+    m_thresholdMinSlider->setRange(0, 1000);
+    m_thresholdMinSlider->setValue(0);
+    thresholdLayout->addWidget(thresholdMinLabel);
+    thresholdLayout->addWidget(m_thresholdMinSlider);
+    
+    QLabel* thresholdMaxLabel = new QLabel("上限:");
+    m_thresholdMaxSlider = new QSlider(Qt::Horizontal);
+    m_thresholdMaxSlider->setRange(0, 1000);
+    m_thresholdMaxSlider->setValue(1000);
+    thresholdLayout->addWidget(thresholdMaxLabel);
+    thresholdLayout->addWidget(m_thresholdMaxSlider);
+    layout->addWidget(thresholdGroup);
+    
+    // Region Group
+    QGroupBox* regionGroup = new QGroupBox("区域");
+    QVBoxLayout* regionLayout = new QVBoxLayout(regionGroup);
+    
+    QLabel* regionArrayLabel = new QLabel("区域编号:");
+    m_regionArrayCombo = new QComboBox();
+    m_regionArrayCombo->addItem("无");
+    regionLayout->addWidget(regionArrayLabel);
+    regionLayout->addWidget(m_regionArrayCombo);
+    
+    m_interfaceCheck = new QCheckBox("显示区域交界面");
+    regionLayout->addWidget(m_interfaceCheck);
+    
+    m_regionList = new QListWidget();
+    m_regionList->setMaximumHeight(160);
+    regionLayout->addWidget(m_regionList);
+    layout->addWidget(regionGroup);
+    
+    // Part Group
+    QGroupBox* partGroup = new QGroupBox("部件");
+    QVBoxLayout* partLayout = new QVBoxLayout(partGroup);
+    
+    QLabel* partModeLabel = new QLabel("连通划分:");
+    m_partModeCombo = new QComboBox();
+    m_partModeCombo->addItem("无");
+    m_partModeCombo->addItem("体单元连通");
+    m_partModeCombo->addItem("表面连通");
+    partLayout->addWidget(partModeLabel);
+    partLayout->addWidget(m_partModeCombo);
+    
+    m_partColorCheck = new QCheckBox("按部件着色 (纯色模式)");
+    partLayout->addWidget(m_partColorCheck);
+    
+    m_partList = new QListWidget();
+    m_partList->setMaximumHeight(160);
+    partLayout->addWidget(m_partList);
+    
+    QHBoxLayout* partButtonLayout = new QHBoxLayout();
+    m_isolatePartButton = new QPushButton("仅显示选中");
+    m_showAllPartsButton = new QPushButton("全部显示");
+    partButtonLayout->addWidget(m_isolatePartButton);
+    partButtonLayout->addWidget(m_showAllPartsButton);
+    partLayout->addLayout(partButtonLayout);
+    layout->addWidget(partGroup);
+    
+    // Isosurface Group
+    QGroupBox* isoGroup = new QGroupBox("等值面");
+    QVBoxLayout* isoLayout = new QVBoxLayout(isoGroup);
+    
+    m_isoCheck = new QCheckBox("显示等值面");
+    isoLayout->addWidget(m_isoCheck);
+    
+    QLabel* isoArrayLabel = new QLabel("点数据:");
+    m_isoArrayCombo = new QComboBox();
+    isoLayout->addWidget(isoArrayLabel);
+    isoLayout->addWidget(m_isoArrayCombo);
+    
+    QLabel* isoValueLabel = new QLabel("等值:");
+    m_isoValueSlider = new QSlider(Qt::Horizontal);
+    m_isoValueSlider->setRange(0, 1000);
+    m_isoValueSlider->setValue(500);
+    isoLayout->addWidget(isoValueLabel);
+    isoLayout->addWidget(m_isoValueSlider);
+    layout->addWidget(isoGroup);
 
 
     layout->addStretch();
@@ -129,10 +329,53 @@ void MainWindow::setupConnections()
             this, &MainWindow::onPhysicalValueChanged);
     connect(m_colorModeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
             this, &MainWindow::onColorModeChanged);
+    connect(m_shadingCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onShadingModeChanged);
+    connect(m_vertexFormatCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onVertexFormatChanged);
     connect(m_dataArrayCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
             this, &MainWindow::onDataArrayChanged);
+    connect(m_componentCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onComponentChanged);
+    connect(m_interpolateButton, &QPushButton::clicked, this, &MainWindow::onInterpolateClicked);
+    connect(m_gpuLookupCheck, &QCheckBox::toggled, m_glWidget, &GLWidget::setGpuScalarLookup);
+    connect(m_spatialReorderCheck, &QCheckBox::toggled, m_glWidget, &GLWidget::setSpatialReorder);
+    connect(m_weldPointsCheck, &QCheckBox::toggled, m_glWidget, &GLWidget::setWeldPoints);
+    connect(m_weldToleranceCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onWeldToleranceChanged);
+    connect(m_optimizeIndicesCheck, &QCheckBox::toggled, m_glWidget, &GLWidget::setOptimizeIndices);
+    connect(m_subdivideCurvedCheck, &QCheckBox::toggled, m_glWidget, &GLWidget::setSubdivideCurved);
+    connect(m_scalarRangeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onScalarRangeChanged);
     
     connect(m_pointSizeSlider, &QSlider::valueChanged, m_glWidget, &GLWidget::setPointSize);
+    connect(m_featureAngleSlider, &QSlider::valueChanged, m_glWidget, &GLWidget::setFeatureAngle);
+    connect(m_sliceCheck, &QCheckBox::toggled, m_glWidget, &GLWidget::setSliceEnabled);
+    connect(m_sliceAxisCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), m_glWidget, &GLWidget::setSliceAxis);
+    connect(m_slicePositionSlider, &QSlider::valueChanged, m_glWidget, &GLWidget::setSlicePosition);
+    connect(m_clipCheck, &QCheckBox::toggled, m_glWidget, &GLWidget::setClipEnabled);
+    connect(m_clipAxisCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), m_glWidget, &GLWidget::setClipAxis);
+    connect(m_clipPositionSlider, &QSlider::valueChanged, m_glWidget, &GLWidget::setClipPosition);
+    connect(m_thresholdCheck, &QCheckBox::toggled, m_glWidget, &GLWidget::setThresholdEnabled);
+    connect(m_thresholdArrayCombo, &QComboBox::currentTextChanged, m_glWidget, &GLWidget::setThresholdArray);
+    connect(m_thresholdMinSlider, &QSlider::valueChanged, m_glWidget, &GLWidget::setThresholdMin);
+    connect(m_thresholdMaxSlider, &QSlider::valueChanged, m_glWidget, &GLWidget::setThresholdMax);
+    connect(m_regionArrayCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onRegionArrayChanged);
+    connect(m_interfaceCheck, &QCheckBox::toggled, m_glWidget, &GLWidget::setShowInterfaces);
+    connect(m_regionList, &QListWidget::itemChanged, this, &MainWindow::onRegionItemChanged);
+    
+    // Parts
+    connect(m_partModeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            m_glWidget, &GLWidget::setPartMode);
+    connect(m_partColorCheck, &QCheckBox::toggled, m_glWidget, &GLWidget::setPartColoring);
+    connect(m_glWidget, &GLWidget::partsChanged, this, &MainWindow::onPartsChanged);
+    connect(m_partList, &QListWidget::itemChanged, this, &MainWindow::onPartItemChanged);
+    connect(m_isolatePartButton, &QPushButton::clicked, this, &MainWindow::onIsolatePartClicked);
+    connect(m_showAllPartsButton, &QPushButton::clicked, this, &MainWindow::onShowAllPartsClicked);
+    connect(m_isoCheck, &QCheckBox::toggled, m_glWidget, &GLWidget::setIsoEnabled);
+    connect(m_isoArrayCombo, &QComboBox::currentTextChanged, m_glWidget, &GLWidget::setIsoArray);
+    connect(m_isoValueSlider, &QSlider::valueChanged, m_glWidget, &GLWidget::setIsoValue);
     // connect(m_lineWidthSlider, &QSlider::valueChanged, m_glWidget, &GLWidget::setLineWidth);
     
     connect(m_glWidget, &GLWidget::statusMessage, this, &MainWindow::updateStatusBar);
@@ -181,6 +424,7 @@ void MainWindow::onRenderModeChanged(int index)
 void MainWindow::onPhysicalValueChanged(int index)
 {
     m_dataArrayCombo->setEnabled(index == 1 || index == 2);
+    m_interpolateButton->setEnabled(index == 2);
     m_glWidget->setPhysicalValue(static_cast<GLWidget::PhysicalData>(index));
     updateDataArrayList();
     
@@ -195,6 +439,25 @@ void MainWindow::onDataArrayChanged(int index)
     if (index >= 0) {
         m_glWidget->setActiveDataArray(m_dataArrayCombo->currentText());
     }
+    updateComponentList();
+}
+
+void MainWindow::onInterpolateClicked()
+{
+    const QString pointName = m_glWidget->interpolateCellArray(m_dataArrayCombo->currentText());
+    if (pointName.isEmpty()) return;
+    
+    // Show it right away as point data; the isosurface can use it too
+    if (m_isoArrayCombo->findText(pointName) < 0) m_isoArrayCombo->addItem(pointName);
+    m_physicalValueCombo->setCurrentIndex(1);
+    m_dataArrayCombo->setCurrentText(pointName);
+}
+
+void MainWindow::onComponentChanged(int index)
+{
+    if (index >= 0) {
+        m_glWidget->setActiveComponent(m_componentCombo->itemData(index).toInt());
+    }
 }
 
 void MainWindow::onColorModeChanged(int index)
@@ -202,6 +465,23 @@ void MainWindow::onColorModeChanged(int index)
     m_glWidget->setColorMode(static_cast<GLWidget::ColorMode>(index));
 }
 
+void MainWindow::onShadingModeChanged(int index)
+{
+    m_glWidget->setShadingMode(index == 1 ? MeshProcessor::ShadingMode::Smooth
+                                          : MeshProcessor::ShadingMode::Flat);
+}
+
+void MainWindow::onVertexFormatChanged(int index)
+{
+    m_glWidget->setVertexFormat(index == 1 ? VertexFormat::Full : VertexFormat::Compact);
+}
+
+void MainWindow::onScalarRangeChanged(int index)
+{
+    m_glWidget->setScalarRangeMode(index == 1 ? MeshProcessor::ScalarRange::Percentile
+                                              : MeshProcessor::ScalarRange::MinMax);
+}
+
 void MainWindow::resetCamera()
 {
     m_glWidget->resetCamera();
@@ -223,6 +503,83 @@ void MainWindow::onLoadingFinished()
     m_statsLabel->setText(QString("Points: %1 | Cells: %2")
         .arg(stats.first).arg(stats.second));
     updateDataArrayList();
+    
+    m_isoArrayCombo->clear();
+    m_isoArrayCombo->addItems(m_glWidget->getPointDataArrayNames());
+    m_thresholdArrayCombo->clear();
+    m_thresholdArrayCombo->addItems(m_glWidget->getCellDataArrayNames());
+    
+    // The new grid starts without regions
+    {
+        QSignalBlocker blocker(m_regionArrayCombo);
+        m_regionArrayCombo->clear();
+        m_regionArrayCombo->addItem("无");
+        m_regionArrayCombo->addItems(m_glWidget->getCellDataArrayNames());
+    }
+    m_regionList->clear();
+}
+
+void MainWindow::onRegionArrayChanged(int index)
+{
+    m_glWidget->setRegionArray(index > 0 ? m_regionArrayCombo->itemText(index) : QString());
+    
+    // Rebuilt without signals: every region starts out visible
+    QSignalBlocker blocker(m_regionList);
+    m_regionList->clear();
+    for (const QString& label : m_glWidget->regionLabels()) {
+        QListWidgetItem* item = new QListWidgetItem(label, m_regionList);
+        item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+        item->setCheckState(Qt::Checked);
+    }
+}
+
+void MainWindow::onRegionItemChanged(QListWidgetItem* item)
+{
+    m_glWidget->setRegionVisible(m_regionList->row(item), item->checkState() == Qt::Checked);
+}
+
+void MainWindow::onWeldToleranceChanged(int index)
+{
+    m_glWidget->setWeldTolerance(m_weldToleranceCombo->itemData(index).toDouble());
+}
+
+void MainWindow::onPartsChanged()
+{
+    // Rebuilt without signals: every part starts out visible
+    QSignalBlocker blocker(m_partList);
+    m_partList->clear();
+    for (const QString& label : m_glWidget->partLabels()) {
+        QListWidgetItem* item = new QListWidgetItem(label, m_partList);
+        item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+        item->setCheckState(Qt::Checked);
+    }
+}
+
+void MainWindow::onPartItemChanged(QListWidgetItem* item)
+{
+    m_glWidget->setPartVisible(m_partList->row(item), item->checkState() == Qt::Checked);
+}
+
+void MainWindow::onIsolatePartClicked()
+{
+    const int part = m_partList->currentRow();
+    if (part < 0) return;
+    m_glWidget->isolatePart(part);
+    
+    QSignalBlocker blocker(m_partList);
+    for (int row = 0; row < m_partList->count(); ++row) {
+        m_partList->item(row)->setCheckState(row == part ? Qt::Checked : Qt::Unchecked);
+    }
+}
+
+void MainWindow::onShowAllPartsClicked()
+{
+    m_glWidget->showAllParts();
+    
+    QSignalBlocker blocker(m_partList);
+    for (int row = 0; row < m_partList->count(); ++row) {
+        m_partList->item(row)->setCheckState(Qt::Checked);
+    }
 }
 
 void MainWindow::updateDataArrayList()
@@ -238,3 +595,21 @@ void MainWindow::updateDataArrayList()
     
     m_dataArrayCombo->addItems(arrays);
 }
+
+void MainWindow::updateComponentList()
+{
+    // Rebuilt without signals: a new array always starts at its magnitude
+    QSignalBlocker blocker(m_componentCombo);
+    m_componentCombo->clear();
+    
+    const bool isPointData = (m_physicalValueCombo->currentIndex() == 1);
+    const int components = m_glWidget->getArrayComponentCount(m_dataArrayCombo->currentText(), isPointData);
+    if (components > 1) {
+        static const char* axisNames[] = {"X", "Y", "Z"};
+        m_componentCombo->addItem("模长", -1);
+        for (int c = 0; c < components; ++c) {
+            m_componentCombo->addItem(components <= 3 ? QString(axisNames[c]) : QString("分量 %1").arg(c), c);
+        }
+    }
+    m_componentCombo->setEnabled(components > 1 && m_dataArrayCombo->isEnabled());
+}
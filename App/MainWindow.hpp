@@ -7,11 +7,13 @@
 #include <QDockWidget>
 #include <QListWidget>
 #include <QComboBox>
+#include <QCheckBox>
 #include <QSlider>
 #include <QLabel>
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QVBoxLayout>
+#include <QHBoxLayout>
 #include <QGroupBox>
 #include <QPushButton>
 #include <QProgressBar>
@@ -32,11 +34,23 @@ private slots:
     void onRenderModeChanged(int index);
     void onPhysicalValueChanged(int index);
     void onDataArrayChanged(int index);
+    void onInterpolateClicked();
+    void onComponentChanged(int index);
+    void onScalarRangeChanged(int index);
     void onColorModeChanged(int index);
+    void onShadingModeChanged(int index);
+    void onVertexFormatChanged(int index);
     void resetCamera();
     void updateStatusBar(const QString& message);
     void onLoadingProgress(int progress);
     void onLoadingFinished();
+    void onRegionArrayChanged(int index);
+    void onRegionItemChanged(QListWidgetItem* item);
+    void onWeldToleranceChanged(int index);
+    void onPartsChanged();
+    void onPartItemChanged(QListWidgetItem* item);
+    void onIsolatePartClicked();
+    void onShowAllPartsClicked();
 
 private:
     void setupUI();
@@ -44,6 +58,7 @@ private:
     void setupDockWidget();
     void setupConnections();
     void updateDataArrayList();
+    void updateComponentList();
 
     GLWidget* m_glWidget;
     
@@ -55,10 +70,43 @@ private:
     // Dock widget for controls
     QDockWidget* m_controlDock;
     QComboBox* m_renderModeCombo;
+    QComboBox* m_shadingCombo;
+    QComboBox* m_vertexFormatCombo;
     QComboBox* m_physicalValueCombo;
     QComboBox* m_colorModeCombo;
     QComboBox* m_dataArrayCombo;
+    QComboBox* m_componentCombo;
+    QPushButton* m_interpolateButton;
+    QCheckBox* m_gpuLookupCheck;
+    QCheckBox* m_spatialReorderCheck;
+    QCheckBox* m_weldPointsCheck;
+    QComboBox* m_weldToleranceCombo;
+    QCheckBox* m_optimizeIndicesCheck;
+    QCheckBox* m_subdivideCurvedCheck;
+    QComboBox* m_scalarRangeCombo;
     QSlider* m_pointSizeSlider;
+    QSlider* m_featureAngleSlider;
+    QCheckBox* m_sliceCheck;
+    QComboBox* m_sliceAxisCombo;
+    QSlider* m_slicePositionSlider;
+    QCheckBox* m_clipCheck;
+    QComboBox* m_clipAxisCombo;
+    QSlider* m_clipPositionSlider;
+    QCheckBox* m_thresholdCheck;
+    QComboBox* m_thresholdArrayCombo;
+    QSlider* m_thresholdMinSlider;
+    QSlider* m_thresholdMaxSlider;
+    QComboBox* m_regionArrayCombo;
+    QCheckBox* m_interfaceCheck;
+    QListWidget* m_regionList;
+    QComboBox* m_partModeCombo;
+    QCheckBox* m_partColorCheck;
+    QListWidget* m_partList;
+    QPushButton* m_isolatePartButton;
+    QPushButton* m_showAllPartsButton;
+    QCheckBox* m_isoCheck;
+    QComboBox* m_isoArrayCombo;
+    QSlider* m_isoValueSlider;
     // QSlider* m_lineWidthSlider;
     
     // Status
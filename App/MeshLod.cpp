@@ -0,0 +1,239 @@
+#include "MeshLod.hpp"
+#include "Parallel.hpp"
+#include "RadixSort.hpp"
+#include "VertexReader.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace {
+
+// Symmetric 3x3 matrix A, vector b and constant c of the error x^T A x + 2 b.x + c
+struct Quadric {
+    double a[6] = {0, 0, 0, 0, 0, 0};  // xx, xy, xz, yy, yz, zz
+    double b[3] = {0, 0, 0};
+    double c = 0;
+
+    // Squared distance to the plane through p with unit normal n
+    void addPlane(const float n[3], const float p[3])
+    {
+        const double d = -(static_cast<double>(n[0]) * p[0] + static_cast<double>(n[1]) * p[1] +
+                           static_cast<double>(n[2]) * p[2]);
+        a[0] += n[0] * n[0]; a[1] += n[0] * n[1]; a[2] += n[0] * n[2];
+        a[3] += n[1] * n[1]; a[4] += n[1] * n[2]; a[5] += n[2] * n[2];
+        b[0] += n[0] * d; b[1] += n[1] * d; b[2] += n[2] * d;
+        c += d * d;
+    }
+
+    double error(const float p[3]) const
+    {
+        const double x = p[0], y = p[1], z = p[2];
+        return a[0] * x * x + 2 * a[1] * x * y + 2 * a[2] * x * z + a[3] * y * y + 2 * a[4] * y * z + a[5] * z * z +
+               2 * (b[0] * x + b[1] * y + b[2] * z) + c;
+    }
+};
+
+int bitsFor(uint64_t maxValue)
+{
+    int bits = 1;
+    while (bits < 63 && (maxValue >> bits) != 0) ++bits;
+    return bits;
+}
+
+double surfaceArea(const GPUMeshData& mesh, const VertexReader& reader)
+{
+    const size_t triCount = mesh.triangleIndices.size() / 3;
+    const int chunks = std::max(1, std::min(Parallel::maxThreads(), static_cast<int>(triCount / 65536) + 1));
+    std::vector<double> chunkArea(chunks, 0.0);
+    #pragma omp parallel for schedule(static, 1) num_threads(chunks)
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        size_t begin, end;
+        Parallel::chunkRange(triCount, chunks, chunk, begin, end);
+        double area = 0.0;
+        for (size_t t = begin; t < end; ++t) {
+            float p0[3], p1[3], p2[3];
+            reader.position(mesh.triangleIndices[t * 3 + 0], p0);
+            reader.position(mesh.triangleIndices[t * 3 + 1], p1);
+            reader.position(mesh.triangleIndices[t * 3 + 2], p2);
+            const double e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+            const double e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+            const double cx = e1[1] * e2[2] - e1[2] * e2[1];
+            const double cy = e1[2] * e2[0] - e1[0] * e2[2];
+            const double cz = e1[0] * e2[1] - e1[1] * e2[0];
+            area += 0.5 * std::sqrt(cx * cx + cy * cy + cz * cz);
+        }
+        chunkArea[chunk] = area;
+    }
+    return std::accumulate(chunkArea.begin(), chunkArea.end(), 0.0);
+}
+
+} // namespace
+
+namespace MeshLod {
+
+Level clusterLevel(const GPUMeshData& mesh, float cellSize)
+{
+    Level level;
+    const VertexReader reader(mesh);
+    const size_t vertexCount = mesh.vertexCount;
+    const size_t triCount = mesh.triangleIndices.size() / 3;
+    if (vertexCount == 0 || triCount == 0 || !(cellSize > 0.0f)) return level;
+
+    // ---- Grid cell of every vertex; sorting by cell makes each cluster a contiguous run ----
+    const float origin[3] = {mesh.boundingBoxMin.x(), mesh.boundingBoxMin.y(), mesh.boundingBoxMin.z()};
+    const float extent[3] = {mesh.boundingBoxMax.x() - origin[0],
+                             mesh.boundingBoxMax.y() - origin[1],
+                             mesh.boundingBoxMax.z() - origin[2]};
+    const uint32_t maxCell = (1u << 21) - 1;
+    uint32_t cells[3];
+    for (int i = 0; i < 3; ++i) {
+        cells[i] = static_cast<uint32_t>(std::min<double>(maxCell, std::floor(extent[i] / cellSize) + 1.0));
+    }
+    const int axisBits = bitsFor(std::max({cells[0], cells[1], cells[2]}));
+    const float invCell = 1.0f / cellSize;
+
+    const int64_t numVerts = static_cast<int64_t>(vertexCount);
+    std::vector<uint64_t> keys(vertexCount);
+    std::vector<uint32_t> order(vertexCount);
+    #pragma omp parallel for schedule(static)
+    for (int64_t v = 0; v < numVerts; ++v) {
+        float p[3];
+        reader.position(static_cast<size_t>(v), p);
+        uint64_t key = 0;
+        for (int i = 0; i < 3; ++i) {
+            const float cell = std::floor((p[i] - origin[i]) * invCell);
+            key = (key << axisBits) | std::min<uint64_t>(cells[i] - 1, static_cast<uint64_t>(std::max(cell, 0.0f)));
+        }
+        keys[v] = key;
+        order[v] = static_cast<uint32_t>(v);
+    }
+    RadixSort::sortPairs(keys, order, 3 * axisBits);
+
+    const uint64_t* k = keys.data();
+    const std::vector<uint32_t> runStarts = Parallel::collect<uint32_t>(vertexCount,
+        [k](size_t i) { return i == 0 || k[i] != k[i - 1]; },
+        [](size_t i) { return static_cast<uint32_t>(i); });
+    std::vector<uint64_t>().swap(keys);
+    const int64_t clusterCount = static_cast<int64_t>(runStarts.size());
+
+    // ---- Representative of each cluster: the member closest to all member tangent planes ----
+    std::vector<uint32_t> clusterOf(vertexCount);
+    std::vector<uint32_t> representative(runStarts.size());
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (int64_t c = 0; c < clusterCount; ++c) {
+        const size_t begin = runStarts[c];
+        const size_t end = (c + 1 < clusterCount) ? runStarts[c + 1] : vertexCount;
+        Quadric q;
+        for (size_t i = begin; i < end; ++i) {
+            float p[3], n[3];
+            reader.position(order[i], p);
+            reader.normal(order[i], n);
+            q.addPlane(n, p);
+            clusterOf[order[i]] = static_cast<uint32_t>(c);
+        }
+        double bestError = std::numeric_limits<double>::max();
+        uint32_t best = order[begin];
+        for (size_t i = begin; i < end; ++i) {
+            float p[3];
+            reader.position(order[i], p);
+            const double e = q.error(p);
+            if (e < bestError) {
+                bestError = e;
+                best = order[i];
+            }
+        }
+        representative[c] = best;
+    }
+    std::vector<uint32_t>().swap(order);
+
+    // ---- Triangles whose corners fall into three different clusters survive ----
+    const std::vector<uint32_t>& indices = mesh.triangleIndices;
+    std::vector<uint32_t> kept = Parallel::collect<uint32_t>(triCount,
+        [&](size_t t) {
+            const uint32_t c0 = clusterOf[indices[t * 3 + 0]];
+            const uint32_t c1 = clusterOf[indices[t * 3 + 1]];
+            const uint32_t c2 = clusterOf[indices[t * 3 + 2]];
+            return c0 != c1 && c1 != c2 && c0 != c2;
+        },
+        [](size_t t) { return static_cast<uint32_t>(t); });
+
+    // Several triangles usually collapse onto the same cluster triple: keep the first of
+    // each (same winding), then restore the original (cache-optimized) order
+    const int clusterBits = bitsFor(static_cast<uint64_t>(clusterCount));
+    if (3 * clusterBits + 1 <= 64 && !kept.empty()) {
+        const int64_t keptCount = static_cast<int64_t>(kept.size());
+        std::vector<uint64_t> triKeys(kept.size());
+        std::vector<uint32_t> slots(kept.size());
+        #pragma omp parallel for schedule(static)
+        for (int64_t i = 0; i < keptCount; ++i) {
+            uint64_t c[3] = {clusterOf[indices[kept[i] * 3 + 0]], clusterOf[indices[kept[i] * 3 + 1]],
+                             clusterOf[indices[kept[i] * 3 + 2]]};
+            // Each swap of the sorting network flips the winding parity
+            uint64_t parity = 0;
+            if (c[0] > c[1]) { std::swap(c[0], c[1]); parity ^= 1; }
+            if (c[1] > c[2]) { std::swap(c[1], c[2]); parity ^= 1; }
+            if (c[0] > c[1]) { std::swap(c[0], c[1]); parity ^= 1; }
+            triKeys[i] = (((c[0] << clusterBits | c[1]) << clusterBits | c[2]) << 1) | parity;
+            slots[i] = static_cast<uint32_t>(i);
+        }
+        RadixSort::sortPairs(triKeys, slots, 3 * clusterBits + 1);
+
+        std::vector<uint8_t> unique(kept.size(), 0);
+        #pragma omp parallel for schedule(static)
+        for (int64_t i = 0; i < keptCount; ++i) {
+            if (i == 0 || triKeys[i] != triKeys[i - 1]) unique[slots[i]] = 1;
+        }
+        kept = Parallel::collect<uint32_t>(kept.size(),
+            [&unique](size_t i) { return unique[i] != 0; },
+            [&kept](size_t i) { return kept[i]; });
+    }
+
+    const int64_t outCount = static_cast<int64_t>(kept.size());
+    level.triangleIndices.resize(kept.size() * 3);
+    level.triangleToCellIndex.resize(kept.size());
+    const bool hasCells = (mesh.triangleToCellIndex.size() == triCount);
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < outCount; ++i) {
+        const uint32_t t = kept[i];
+        for (int j = 0; j < 3; ++j) {
+            level.triangleIndices[i * 3 + j] = representative[clusterOf[indices[t * 3 + j]]];
+        }
+        level.triangleToCellIndex[i] = hasCells ? mesh.triangleToCellIndex[t] : 0;
+    }
+    return level;
+}
+
+std::vector<Level> buildChain(const GPUMeshData& mesh, const std::vector<float>& ratios,
+                              const std::atomic<bool>& cancel)
+{
+    std::vector<Level> chain;
+    const size_t triCount = mesh.triangleIndices.size() / 3;
+    if (triCount == 0) return chain;
+
+    // A surface of area A meets roughly A / h^2 grid cubes of edge h, and every
+    // cluster yields about two triangles
+    const double area = surfaceArea(mesh, VertexReader(mesh));
+    size_t previous = triCount;
+    for (float ratio : ratios) {
+        if (cancel.load(std::memory_order_relaxed)) break;
+        const double target = static_cast<double>(triCount) * ratio;
+        if (target < 16.0 || area <= 0.0) break;
+
+        double cellSize = std::sqrt(area / (0.5 * target));
+        Level level = clusterLevel(mesh, static_cast<float>(cellSize));
+        // One correction step when the estimate is off by more than 30%
+        const double achieved = static_cast<double>(level.triangleCount());
+        if (achieved > 0.0 && std::fabs(achieved - target) > 0.3 * target && !cancel.load(std::memory_order_relaxed)) {
+            cellSize *= std::sqrt(achieved / target);
+            level = clusterLevel(mesh, static_cast<float>(cellSize));
+        }
+
+        if (level.triangleCount() == 0 || level.triangleCount() > previous * 9 / 10) continue;
+        previous = level.triangleCount();
+        chain.push_back(std::move(level));
+    }
+    return chain;
+}
+
+} // namespace MeshLod
@@ -0,0 +1,34 @@
+#ifndef MESHLOD_HPP
+#define MESHLOD_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "MeshProcessor.hpp"
+
+// Level-of-detail chain for interaction. Each level is a new index buffer into the
+// full mesh's vertices: vertices are clustered on a uniform grid and every cluster is
+// represented by the member vertex with the least quadric error against the tangent
+// planes of the cluster. Since no vertices are created, the vertex buffer, the scalar
+// stream and the point lookups are shared with the full mesh.
+namespace MeshLod {
+
+struct Level {
+    std::vector<uint32_t> triangleIndices;      // Into the full mesh's vertices
+    std::vector<uint32_t> triangleToCellIndex;  // Cell of each triangle (gl_PrimitiveID lookup)
+
+    size_t triangleCount() const { return triangleToCellIndex.size(); }
+};
+
+// One level per ratio of the full triangle count (e.g. 0.5, 0.1, 0.01), finest first.
+// Levels that would not be coarser than the previous one are skipped. Returns early
+// with an incomplete chain once `cancel` is set.
+std::vector<Level> buildChain(const GPUMeshData& mesh, const std::vector<float>& ratios,
+                              const std::atomic<bool>& cancel);
+
+// Clusters vertices on a grid of cubes with the given edge length
+Level clusterLevel(const GPUMeshData& mesh, float cellSize);
+
+} // namespace MeshLod
+
+#endif // MESHLOD_HPP
@@ -0,0 +1,406 @@
+#include "MeshOptimizer.hpp"
+#include "Parallel.hpp"
+#include "RadixSort.hpp"
+#include "SpatialReorder.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace {
+
+// A cluster may end where Tipsify restarts on an uncached vertex, once it has this many triangles
+constexpr size_t kMinClusterTriangles = 128;
+
+struct ChunkOrder {
+    std::vector<uint32_t> triangles;      // Global triangle ids in emission order
+    std::vector<uint32_t> clusterStarts;  // Offsets into `triangles`
+};
+
+// Tipsify over the triangles input[begin, end), on chunk-local vertex ids
+void tipsifyChunk(const std::vector<uint32_t>& indices, const std::vector<uint32_t>& input,
+                  size_t begin, size_t end, ChunkOrder& out)
+{
+    const size_t triCount = end - begin;
+    const uint32_t cacheSize = MeshOptimizer::kCacheSize;
+
+    // Local vertex ids: rank among the chunk's distinct vertices
+    std::vector<uint32_t> corners(triCount * 3);
+    for (size_t t = 0; t < triCount; ++t) {
+        const uint32_t src = input[begin + t];
+        for (int k = 0; k < 3; ++k) corners[t * 3 + k] = indices[src * 3 + k];
+    }
+    std::vector<uint32_t> vertices(corners);
+    std::sort(vertices.begin(), vertices.end());
+    vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+    const size_t vertCount = vertices.size();
+
+    std::vector<uint32_t> live(vertCount, 0);
+    for (size_t i = 0; i < corners.size(); ++i) {
+        corners[i] = static_cast<uint32_t>(std::lower_bound(vertices.begin(), vertices.end(), corners[i]) - vertices.begin());
+        ++live[corners[i]];
+    }
+
+    // Vertex -> triangles (CSR)
+    std::vector<uint32_t> adjOffsets(vertCount + 1, 0);
+    for (size_t v = 0; v < vertCount; ++v) {
+        adjOffsets[v + 1] = adjOffsets[v] + live[v];
+    }
+    std::vector<uint32_t> adjTris(corners.size());
+    {
+        std::vector<uint32_t> cursor(adjOffsets.begin(), adjOffsets.end() - 1);
+        for (size_t i = 0; i < corners.size(); ++i) {
+            adjTris[cursor[corners[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+    }
+
+    std::vector<uint32_t> cacheTime(vertCount, 0);
+    std::vector<uint8_t> emitted(triCount, 0);
+    std::vector<uint32_t> deadEnd;
+    std::vector<uint32_t> candidates;
+    deadEnd.reserve(corners.size());
+    uint32_t timestamp = cacheSize + 1;
+    size_t scan = 0;  // Fallback cursor over local vertices
+    size_t clusterBegin = 0;
+
+    out.triangles.reserve(triCount);
+    out.clusterStarts.assign(1, 0);
+
+    int64_t fanning = (vertCount > 0) ? 0 : -1;
+    while (fanning >= 0) {
+        // Emit every live triangle around the fanning vertex
+        candidates.clear();
+        for (uint32_t a = adjOffsets[fanning]; a < adjOffsets[fanning + 1]; ++a) {
+            const uint32_t t = adjTris[a];
+            if (emitted[t]) continue;
+            emitted[t] = 1;
+            out.triangles.push_back(input[begin + t]);
+            for (int k = 0; k < 3; ++k) {
+                const uint32_t v = corners[t * 3 + k];
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                --live[v];
+                if (timestamp - cacheTime[v] > cacheSize) cacheTime[v] = timestamp++;
+            }
+        }
+
+        // Next fanning vertex: the candidate that will still be cached after its fan is emitted
+        fanning = -1;
+        int64_t bestPriority = -1;
+        for (uint32_t v : candidates) {
+            if (live[v] == 0) continue;
+            int64_t priority = 0;
+            if (timestamp - cacheTime[v] + 2 * live[v] <= cacheSize) priority = timestamp - cacheTime[v];
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                fanning = v;
+            }
+        }
+        // Dead end: the most recently referenced vertex with work left, else the next one in order
+        while (fanning < 0 && !deadEnd.empty()) {
+            const uint32_t v = deadEnd.back();
+            deadEnd.pop_back();
+            if (live[v] > 0) fanning = v;
+        }
+        while (fanning < 0 && scan < vertCount) {
+            if (live[scan] > 0) fanning = static_cast<int64_t>(scan);
+            ++scan;
+        }
+
+        // Restarting on an uncached vertex costs the same misses whether or not a cluster ends here
+        const size_t emittedCount = out.triangles.size();
+        if (fanning >= 0 && timestamp - cacheTime[fanning] > cacheSize &&
+            emittedCount - clusterBegin >= kMinClusterTriangles) {
+            out.clusterStarts.push_back(static_cast<uint32_t>(emittedCount));
+            clusterBegin = emittedCount;
+        }
+    }
+}
+
+// Unnormalized normal (twice the area) and centroid of triangle t
+inline void triangleFrame(const std::vector<uint32_t>& indices, const float* positions, size_t stride,
+                          size_t t, double normal[3], double centroid[3])
+{
+    const float* p0 = positions + static_cast<size_t>(indices[t * 3 + 0]) * stride;
+    const float* p1 = positions + static_cast<size_t>(indices[t * 3 + 1]) * stride;
+    const float* p2 = positions + static_cast<size_t>(indices[t * 3 + 2]) * stride;
+    const double e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+    const double e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+    normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+    for (int i = 0; i < 3; ++i) {
+        centroid[i] = (static_cast<double>(p0[i]) + p1[i] + p2[i]) / 3.0;
+    }
+}
+
+} // namespace
+
+namespace MeshOptimizer {
+
+double acmr(const std::vector<uint32_t>& indices, size_t vertexCount, int cacheSize)
+{
+    const size_t triCount = indices.size() / 3;
+    if (triCount == 0) return 0.0;
+
+    // FIFO: a vertex is cached while fewer than cacheSize misses happened since it was loaded
+    std::vector<uint64_t> loadedAt(vertexCount, 0);
+    uint64_t misses = 0;
+    for (size_t i = 0; i < triCount * 3; ++i) {
+        const uint32_t v = indices[i];
+        if (loadedAt[v] == 0 || misses - loadedAt[v] >= static_cast<uint64_t>(cacheSize)) {
+            ++misses;
+            loadedAt[v] = misses;
+        }
+    }
+    return static_cast<double>(misses) / static_cast<double>(triCount);
+}
+
+double overdraw(const std::vector<uint32_t>& indices, const float* positions, size_t stride)
+{
+    constexpr int kResolution = 256;
+    const size_t triCount = indices.size() / 3;
+    if (triCount == 0) return 0.0;
+
+    float boxMin[3], boxMax[3];
+    for (int i = 0; i < 3; ++i) {
+        boxMin[i] = std::numeric_limits<float>::max();
+        boxMax[i] = std::numeric_limits<float>::lowest();
+    }
+    for (uint32_t v : indices) {
+        const float* p = positions + static_cast<size_t>(v) * stride;
+        for (int i = 0; i < 3; ++i) {
+            boxMin[i] = std::min(boxMin[i], p[i]);
+            boxMax[i] = std::max(boxMax[i], p[i]);
+        }
+    }
+
+    // View 2a looks down -axis a, view 2a+1 down +axis a (mirrored, so winding stays CCW = front)
+    uint64_t shaded[6] = {0, 0, 0, 0, 0, 0};
+    uint64_t covered[6] = {0, 0, 0, 0, 0, 0};
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int view = 0; view < 6; ++view) {
+        const int w = view / 2;
+        const int u = (w + 1) % 3;
+        const int v = (w + 2) % 3;
+        const bool mirrored = (view % 2) != 0;
+        const float extent = std::max(boxMax[u] - boxMin[u], boxMax[v] - boxMin[v]);
+        const float scale = (extent > 0.0f) ? (kResolution - 1) / extent : 0.0f;
+
+        std::vector<float> depth(kResolution * kResolution, std::numeric_limits<float>::lowest());
+        std::vector<uint32_t> hits(kResolution * kResolution, 0);
+        for (size_t t = 0; t < triCount; ++t) {
+            float x[3], y[3], z[3];
+            for (int k = 0; k < 3; ++k) {
+                const float* p = positions + static_cast<size_t>(indices[t * 3 + k]) * stride;
+                x[k] = (p[u] - boxMin[u]) * scale;
+                y[k] = (p[v] - boxMin[v]) * scale;
+                z[k] = p[w];
+                if (mirrored) {
+                    x[k] = (kResolution - 1) - x[k];
+                    z[k] = -z[k];
+                }
+            }
+            const float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+            if (area <= 0.0f) continue;  // Back-facing or degenerate
+
+            const int minX = std::max(0, static_cast<int>(std::floor(std::min({x[0], x[1], x[2]}))));
+            const int maxX = std::min(kResolution - 1, static_cast<int>(std::ceil(std::max({x[0], x[1], x[2]}))));
+            const int minY = std::max(0, static_cast<int>(std::floor(std::min({y[0], y[1], y[2]}))));
+            const int maxY = std::min(kResolution - 1, static_cast<int>(std::ceil(std::max({y[0], y[1], y[2]}))));
+            for (int py = minY; py <= maxY; ++py) {
+                for (int px = minX; px <= maxX; ++px) {
+                    const float cx = px + 0.5f, cy = py + 0.5f;
+                    const float b0 = (x[2] - x[1]) * (cy - y[1]) - (y[2] - y[1]) * (cx - x[1]);
+                    const float b1 = (x[0] - x[2]) * (cy - y[2]) - (y[0] - y[2]) * (cx - x[2]);
+                    const float b2 = (x[1] - x[0]) * (cy - y[0]) - (y[1] - y[0]) * (cx - x[0]);
+                    if (b0 < 0.0f || b1 < 0.0f || b2 < 0.0f) continue;
+                    const float d = (b0 * z[0] + b1 * z[1] + b2 * z[2]) / area;
+                    const size_t pixel = static_cast<size_t>(py) * kResolution + px;
+                    if (d > depth[pixel]) {
+                        depth[pixel] = d;
+                        ++hits[pixel];
+                    }
+                }
+            }
+        }
+        for (uint32_t h : hits) {
+            shaded[view] += h;
+            covered[view] += (h != 0) ? 1 : 0;
+        }
+    }
+
+    uint64_t totalShaded = 0, totalCovered = 0;
+    for (int view = 0; view < 6; ++view) {
+        totalShaded += shaded[view];
+        totalCovered += covered[view];
+    }
+    return totalCovered ? static_cast<double>(totalShaded) / static_cast<double>(totalCovered) : 0.0;
+}
+
+std::vector<uint32_t> optimizeTriangleOrder(const std::vector<uint32_t>& indices,
+                                            const float* positions, size_t stride)
+{
+    const size_t triCount = indices.size() / 3;
+    const int64_t chunkCount = static_cast<int64_t>((triCount + kChunkTriangles - 1) / kChunkTriangles);
+
+    // Chunks must be spatially compact (boundary faces arrive in hash or key order),
+    // so with more than one the triangles are first sorted along a Morton curve
+    std::vector<uint32_t> input(triCount);
+    std::iota(input.begin(), input.end(), 0u);
+    if (chunkCount > 1) {
+        float boxMin[3], boxMax[3];
+        for (int k = 0; k < 3; ++k) {
+            boxMin[k] = std::numeric_limits<float>::max();
+            boxMax[k] = std::numeric_limits<float>::lowest();
+        }
+        for (uint32_t v : indices) {
+            const float* p = positions + static_cast<size_t>(v) * stride;
+            for (int k = 0; k < 3; ++k) {
+                boxMin[k] = std::min(boxMin[k], p[k]);
+                boxMax[k] = std::max(boxMax[k], p[k]);
+            }
+        }
+        std::vector<uint64_t> keys(triCount);
+        const int64_t count = static_cast<int64_t>(triCount);
+        #pragma omp parallel for schedule(static)
+        for (int64_t t = 0; t < count; ++t) {
+            const float* p0 = positions + static_cast<size_t>(indices[t * 3 + 0]) * stride;
+            const float* p1 = positions + static_cast<size_t>(indices[t * 3 + 1]) * stride;
+            const float* p2 = positions + static_cast<size_t>(indices[t * 3 + 2]) * stride;
+            uint32_t q[3];
+            for (int k = 0; k < 3; ++k) {
+                const float extent = boxMax[k] - boxMin[k];
+                const float c = (p0[k] + p1[k] + p2[k]) / 3.0f;
+                q[k] = (extent > 0.0f) ? static_cast<uint32_t>(std::min(std::max((c - boxMin[k]) / extent, 0.0f), 1.0f) * 65535.0f) : 0;
+            }
+            keys[t] = SpatialReorder::mortonCode(q[0], q[1], q[2]);
+        }
+        RadixSort::sortPairs(keys, input, 48);
+    }
+
+    // Fixed-size chunks, so the result does not depend on the thread count
+    std::vector<ChunkOrder> chunks(static_cast<size_t>(chunkCount));
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int64_t c = 0; c < chunkCount; ++c) {
+        const size_t begin = static_cast<size_t>(c) * kChunkTriangles;
+        tipsifyChunk(indices, input, begin, std::min(begin + kChunkTriangles, triCount), chunks[c]);
+    }
+
+    // Clusters of all chunks as [begin, end) ranges of the concatenated chunk orders
+    std::vector<uint32_t> order;
+    std::vector<size_t> clusterBegin;
+    order.reserve(triCount);
+    for (const ChunkOrder& chunk : chunks) {
+        for (uint32_t start : chunk.clusterStarts) {
+            clusterBegin.push_back(order.size() + start);
+        }
+        order.insert(order.end(), chunk.triangles.begin(), chunk.triangles.end());
+    }
+    clusterBegin.push_back(order.size());
+    const int64_t clusterCount = static_cast<int64_t>(clusterBegin.size() - 1);
+    if (clusterCount < 2) return order;
+
+    // Area-weighted centroid and normal sum of each cluster
+    std::vector<double> clusterCentroid(static_cast<size_t>(clusterCount) * 3);
+    std::vector<double> clusterNormal(static_cast<size_t>(clusterCount) * 3);
+    std::vector<double> clusterArea(static_cast<size_t>(clusterCount));
+    #pragma omp parallel for schedule(static)
+    for (int64_t c = 0; c < clusterCount; ++c) {
+        double centroid[3] = {0.0, 0.0, 0.0}, normal[3] = {0.0, 0.0, 0.0}, area = 0.0;
+        for (size_t i = clusterBegin[c]; i < clusterBegin[c + 1]; ++i) {
+            double n[3], m[3];
+            triangleFrame(indices, positions, stride, order[i], n, m);
+            const double a = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            for (int k = 0; k < 3; ++k) {
+                normal[k] += n[k];
+                centroid[k] += m[k] * a;
+            }
+            area += a;
+        }
+        for (int k = 0; k < 3; ++k) {
+            clusterNormal[c * 3 + k] = normal[k];
+            clusterCentroid[c * 3 + k] = centroid[k];
+        }
+        clusterArea[c] = area;
+    }
+
+    double meshCentroid[3] = {0.0, 0.0, 0.0}, meshArea = 0.0;
+    for (int64_t c = 0; c < clusterCount; ++c) {
+        for (int k = 0; k < 3; ++k) meshCentroid[k] += clusterCentroid[c * 3 + k];
+        meshArea += clusterArea[c];
+    }
+    for (int k = 0; k < 3; ++k) meshCentroid[k] = (meshArea > 0.0) ? meshCentroid[k] / meshArea : 0.0;
+
+    // Clusters facing away from the centre are likely occluders: draw them first
+    std::vector<double> sortKey(static_cast<size_t>(clusterCount));
+    #pragma omp parallel for schedule(static)
+    for (int64_t c = 0; c < clusterCount; ++c) {
+        const double* n = &clusterNormal[c * 3];
+        const double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        double key = 0.0;
+        if (length > 0.0 && clusterArea[c] > 0.0) {
+            for (int k = 0; k < 3; ++k) {
+                key += (clusterCentroid[c * 3 + k] / clusterArea[c] - meshCentroid[k]) * n[k] / length;
+            }
+        }
+        sortKey[c] = key;
+    }
+    std::vector<uint32_t> clusterOrder(static_cast<size_t>(clusterCount));
+    std::iota(clusterOrder.begin(), clusterOrder.end(), 0u);
+    std::stable_sort(clusterOrder.begin(), clusterOrder.end(),
+                     [&sortKey](uint32_t a, uint32_t b) { return sortKey[a] > sortKey[b]; });
+
+    std::vector<size_t> outOffsets(static_cast<size_t>(clusterCount) + 1, 0);
+    for (int64_t i = 0; i < clusterCount; ++i) {
+        const uint32_t c = clusterOrder[i];
+        outOffsets[i] = clusterBegin[c + 1] - clusterBegin[c];
+    }
+    Parallel::exclusiveScan(outOffsets);
+
+    std::vector<uint32_t> result(order.size());
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < clusterCount; ++i) {
+        const uint32_t c = clusterOrder[i];
+        std::copy(order.begin() + clusterBegin[c], order.begin() + clusterBegin[c + 1],
+                  result.begin() + outOffsets[i]);
+    }
+    return result;
+}
+
+std::vector<uint32_t> vertexFetchOrder(const std::vector<uint32_t>& indices, size_t vertexCount)
+{
+    std::vector<uint32_t> order(vertexCount);
+    std::iota(order.begin(), order.end(), 0u);
+    if (indices.size() >= std::numeric_limits<uint32_t>::max()) return order;
+
+    // First corner referencing each vertex (atomic min, so independent of scheduling)
+    std::vector<std::atomic<uint32_t>> firstUse(vertexCount);
+    const int64_t vertCount = static_cast<int64_t>(vertexCount);
+    #pragma omp parallel for schedule(static)
+    for (int64_t v = 0; v < vertCount; ++v) {
+        firstUse[v].store(std::numeric_limits<uint32_t>::max(), std::memory_order_relaxed);
+    }
+    const int64_t cornerCount = static_cast<int64_t>(indices.size());
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < cornerCount; ++i) {
+        std::atomic<uint32_t>& slot = firstUse[indices[i]];
+        uint32_t current = slot.load(std::memory_order_relaxed);
+        while (static_cast<uint32_t>(i) < current &&
+               !slot.compare_exchange_weak(current, static_cast<uint32_t>(i), std::memory_order_relaxed)) {
+        }
+    }
+
+    std::vector<uint32_t> keys(vertexCount);
+    #pragma omp parallel for schedule(static)
+    for (int64_t v = 0; v < vertCount; ++v) {
+        keys[v] = firstUse[v].load(std::memory_order_relaxed);
+    }
+    RadixSort::sortPairs(keys, order, 32, [](uint32_t key, int shift) {
+        return (key >> shift) & 0xFF;
+    });
+    return order;
+}
+
+} // namespace MeshOptimizer
@@ -0,0 +1,34 @@
+#ifndef MESHOPTIMIZER_HPP
+#define MESHOPTIMIZER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Index buffer optimization for the indexed (smooth-shaded) render path:
+// Tipsify vertex cache ordering (Sander et al. 2007) per chunk of triangles, an
+// outside-in cluster ordering against overdraw, and a first-use vertex fetch order.
+// Positions are read as 3 floats at `positions + vertex * stride`.
+namespace MeshOptimizer {
+
+constexpr int kCacheSize = 16;             // Post-transform cache entries assumed by Tipsify
+constexpr size_t kChunkTriangles = 65536;  // Triangles optimized together by one thread
+
+// Average cache miss ratio: vertices transformed per triangle with a FIFO cache
+double acmr(const std::vector<uint32_t>& indices, size_t vertexCount, int cacheSize = kCacheSize);
+
+// Shaded / visible pixels of six axis-aligned orthographic views with back faces culled
+double overdraw(const std::vector<uint32_t>& indices, const float* positions, size_t stride);
+
+// New triangle order (old triangle ids): Tipsify per chunk, then clusters facing
+// away from the mesh centre are moved to the front so they occlude the rest early
+std::vector<uint32_t> optimizeTriangleOrder(const std::vector<uint32_t>& indices,
+                                            const float* positions, size_t stride);
+
+// Vertices in order of first use by the index buffer: new vertex i is old vertex result[i].
+// Unused vertices keep their relative order at the end.
+std::vector<uint32_t> vertexFetchOrder(const std::vector<uint32_t>& indices, size_t vertexCount);
+
+} // namespace MeshOptimizer
+
+#endif // MESHOPTIMIZER_HPP
@@ -0,0 +1,73 @@
+#include "MeshParts.hpp"
+#include "Parallel.hpp"
+#include "RadixSort.hpp"
+#include <utility>
+
+namespace MeshParts {
+
+PointForest::PointForest(size_t numPoints)
+    : m_parent(numPoints)
+{
+    const int64_t count = static_cast<int64_t>(numPoints);
+    #pragma omp parallel for schedule(static)
+    for (int64_t p = 0; p < count; ++p) {
+        m_parent[p].store(static_cast<uint32_t>(p), std::memory_order_relaxed);
+    }
+}
+
+uint32_t PointForest::find(uint32_t point)
+{
+    uint32_t parent = m_parent[point].load(std::memory_order_relaxed);
+    while (parent != point) {
+        // Path halving: a stale grandparent is still an ancestor
+        const uint32_t grand = m_parent[parent].load(std::memory_order_relaxed);
+        if (grand != parent) m_parent[point].store(grand, std::memory_order_relaxed);
+        point = grand;
+        parent = m_parent[point].load(std::memory_order_relaxed);
+    }
+    return point;
+}
+
+void PointForest::unite(uint32_t a, uint32_t b)
+{
+    for (;;) {
+        a = find(a);
+        b = find(b);
+        if (a == b) return;
+        if (a < b) std::swap(a, b);
+        // Hang the larger root under the smaller one; retry if another thread linked it first
+        uint32_t expected = a;
+        if (m_parent[a].compare_exchange_strong(expected, b, std::memory_order_acq_rel)) return;
+    }
+}
+
+std::vector<uint32_t> groupTriangles(PointForest& forest,
+                                     const std::vector<uint32_t>& triangleIndices,
+                                     const std::vector<uint32_t>& vertexToPoint,
+                                     std::vector<uint32_t>& partOffsets)
+{
+    const size_t triCount = triangleIndices.size() / 3;
+    std::vector<uint32_t> roots(triCount);
+    std::vector<uint32_t> order(triCount);
+    const int64_t count = static_cast<int64_t>(triCount);
+    #pragma omp parallel for schedule(static)
+    for (int64_t t = 0; t < count; ++t) {
+        roots[t] = forest.find(vertexToPoint[triangleIndices[t * 3]]);
+        order[t] = static_cast<uint32_t>(t);
+    }
+
+    // Stable sort by root keeps each part's triangles in their optimized order
+    int rootBits = 1;
+    while (rootBits < 32 && ((forest.size() - 1) >> rootBits) != 0) ++rootBits;
+    RadixSort::sortPairs(roots, order, rootBits,
+                         [](uint32_t key, int shift) { return (key >> shift) & 0xFFu; });
+
+    partOffsets = Parallel::collect<uint32_t>(
+        triCount,
+        [&roots](size_t i) { return i == 0 || roots[i] != roots[i - 1]; },
+        [](size_t i) { return static_cast<uint32_t>(i); });
+    partOffsets.push_back(static_cast<uint32_t>(triCount));
+    return order;
+}
+
+} // namespace MeshParts
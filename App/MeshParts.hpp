@@ -0,0 +1,41 @@
+#ifndef MESHPARTS_HPP
+#define MESHPARTS_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Connected parts of the extracted surface: points joined by the cells (or triangles)
+// using them, merged concurrently in a union-find forest. Every set is rooted at its
+// smallest point id, so the parts and their numbering don't depend on thread scheduling.
+namespace MeshParts {
+
+// Disjoint sets of point ids. unite() and find() may run from many threads at once:
+// roots only change by compare-and-swap, and path halving only ever points a node at
+// one of its ancestors.
+class PointForest
+{
+public:
+    explicit PointForest(size_t numPoints);
+
+    void unite(uint32_t a, uint32_t b);
+    uint32_t find(uint32_t point);
+
+    size_t size() const { return m_parent.size(); }
+
+private:
+    std::vector<std::atomic<uint32_t>> m_parent;
+};
+
+// Groups triangles by the set of their first point: new triangle i is old triangle
+// result[i], in the old order within a part. partOffsets gets each part's first
+// triangle plus the total; parts are numbered by their smallest point id.
+std::vector<uint32_t> groupTriangles(PointForest& forest,
+                                     const std::vector<uint32_t>& triangleIndices,
+                                     const std::vector<uint32_t>& vertexToPoint,
+                                     std::vector<uint32_t>& partOffsets);
+
+} // namespace MeshParts
+
+#endif // MESHPARTS_HPP
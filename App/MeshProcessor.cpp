@@ -1,20 +1,23 @@
 #include "MeshProcessor.hpp"
+#include "ArrayStatistics.hpp"
+#include "ArrayValues.hpp"
+#include "FaceHashTable.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshParts.hpp"
+#include "Parallel.hpp"
+#include "RadixSort.hpp"
+#include <atomic>
 #include <cmath>
+#include <cstring>
 #include <algorithm>
 #include <limits>
 #include <numeric>
+#include <type_traits>
 #include <QDebug>
 #include <QElapsedTimer>
 #include <QLoggingCategory>
 
 
-#ifdef _MSC_VER
-#include <execution>
-#define PAR_SORT(begin, end) std::sort(std::execution::par, begin, end)
-#else
-#define PAR_SORT(begin, end) std::sort(begin, end)
-#endif
-
 Q_LOGGING_CATEGORY(meshProcessorLog, "VTKViewer.MeshProcessor")
 
 GPUMeshData MeshProcessor::process(const std::shared_ptr<UnstructuredGrid>& grid)
@@ -30,14 +33,7 @@ GPUMeshData MeshProcessor::process(const std::shared_ptr<UnstructuredGrid>& grid
     loadTimer.start();
 
     // Store data array names
-    m_pointDataNames.clear();
-    m_cellDataNames.clear();
-    for (const auto& pair : grid->point_data) {
-        m_pointDataNames.append(QString::fromStdString(pair.first));
-    }
-    for (const auto& pair : grid->cell_data) {
-        m_cellDataNames.append(QString::fromStdString(pair.first));
-    }
+    updateArrayNames(*grid);
     
     // ============ Step 1: Extract point positions ============
     const auto& points = grid->points;
@@ -71,268 +67,110 @@ GPUMeshData MeshProcessor::process(const std::shared_ptr<UnstructuredGrid>& grid
     QElapsedTimer stageTimer;
     stageTimer.start();
 
-    // ============ Step 2: Extract all faces from cells ============
-    const auto& cells = grid->cells;
-    const auto& cellTypes = grid->cell_types;
-    const size_t totalCells = grid->num_cells;
-    
-    std::vector<Face> allFaces;
-    allFaces.reserve(totalCells * 4);
+    // ============ Step 2: Index cells and faces ============
+    // Every face of every cell gets a slot; counts are prefix-summed per cell so the
+    // passes below can run in parallel with each thread writing its cells' slots.
+    CellFaceIndex index = buildCellFaceIndex(*grid);
+    const size_t totalCells = index.cellCount();
+    const size_t totalFaces = index.faceCount();
     
-    size_t cellOffset = 0;
-    const int32_t* cellsPtr = cells.data();
-    const uint8_t* typesPtr = cellTypes.data();
-    
-    for (size_t cellIdx = 0; cellIdx < totalCells && cellOffset < cells.size(); ++cellIdx) {
-        int32_t n = cellsPtr[cellOffset];
-        uint8_t type = (cellIdx < cellTypes.size()) ? typesPtr[cellIdx] : VTK_TRIANGLE;
-        const int32_t* c = &cellsPtr[cellOffset + 1];
-        uint32_t cIdx = static_cast<uint32_t>(cellIdx);
-        
-        #define IDX(k) static_cast<uint32_t>(c[k])
-        
-        switch (type) {
-            case VTK_TRIANGLE:
-                if (n >= 3) {
-                    Face f; f.set3(IDX(0), IDX(1), IDX(2), cIdx);
-                    allFaces.push_back(f);
-                }
-                break;
-                
-            case VTK_TRIANGLE_STRIP:
-                for (int k = 0; k < n - 2; ++k) {
-                    Face f;
-                    if (k % 2 == 0) f.set3(IDX(k), IDX(k+1), IDX(k+2), cIdx);
-                    else f.set3(IDX(k), IDX(k+2), IDX(k+1), cIdx);
-                    allFaces.push_back(f);
-                }
-                break;
-                
-            case VTK_QUAD:
-                if (n >= 4) {
-                    Face f; f.set4(IDX(0), IDX(1), IDX(2), IDX(3), cIdx);
-                    allFaces.push_back(f);
-                }
-                break;
-                
-            case VTK_POLYGON:
-                if (n >= 3) {
-                    // Fan triangulation
-                    for (int k = 1; k < n - 1; ++k) {
-                        Face f; f.set3(IDX(0), IDX(k), IDX(k+1), cIdx);
-                        allFaces.push_back(f);
-                    }
-                }
-                break;
-                
-            case VTK_TETRA:
-                if (n >= 4) {
-                    Face f;
-                    f.set3(IDX(0), IDX(1), IDX(3), cIdx); allFaces.push_back(f);
-                    f.set3(IDX(1), IDX(2), IDX(3), cIdx); allFaces.push_back(f);
-                    f.set3(IDX(2), IDX(0), IDX(3), cIdx); allFaces.push_back(f);
-                    f.set3(IDX(0), IDX(2), IDX(1), cIdx); allFaces.push_back(f);
-                }
-                break;
-                
-            case VTK_VOXEL:
-                if (n >= 8) {
-                    Face f;
-                    f.set4(IDX(0), IDX(1), IDX(3), IDX(2), cIdx); allFaces.push_back(f); // -Z
-                    f.set4(IDX(4), IDX(6), IDX(7), IDX(5), cIdx); allFaces.push_back(f); // +Z
-                    f.set4(IDX(0), IDX(2), IDX(6), IDX(4), cIdx); allFaces.push_back(f); // -X
-                    f.set4(IDX(1), IDX(5), IDX(7), IDX(3), cIdx); allFaces.push_back(f); // +X
-                    f.set4(IDX(0), IDX(4), IDX(5), IDX(1), cIdx); allFaces.push_back(f); // -Y
-                    f.set4(IDX(2), IDX(3), IDX(7), IDX(6), cIdx); allFaces.push_back(f); // +Y
-                }
-                break;
-                
-            case VTK_HEXAHEDRON:
-                if (n >= 8) {
-                    Face f;
-                    f.set4(IDX(0), IDX(1), IDX(5), IDX(4), cIdx); allFaces.push_back(f); // Front
-                    f.set4(IDX(1), IDX(2), IDX(6), IDX(5), cIdx); allFaces.push_back(f); // Right
-                    f.set4(IDX(2), IDX(3), IDX(7), IDX(6), cIdx); allFaces.push_back(f); // Back
-                    f.set4(IDX(3), IDX(0), IDX(4), IDX(7), cIdx); allFaces.push_back(f); // Left
-                    f.set4(IDX(0), IDX(3), IDX(2), IDX(1), cIdx); allFaces.push_back(f); // Bottom
-                    f.set4(IDX(4), IDX(5), IDX(6), IDX(7), cIdx); allFaces.push_back(f); // Top
-                }
-                break;
-                
-            case VTK_WEDGE:
-                if (n >= 6) {
-                    Face f;
-                    f.set3(IDX(0), IDX(1), IDX(2), cIdx); allFaces.push_back(f); // Bottom tri
-                    f.set3(IDX(3), IDX(5), IDX(4), cIdx); allFaces.push_back(f); // Top tri
-                    f.set4(IDX(0), IDX(1), IDX(4), IDX(3), cIdx); allFaces.push_back(f);
-                    f.set4(IDX(1), IDX(2), IDX(5), IDX(4), cIdx); allFaces.push_back(f);
-                    f.set4(IDX(2), IDX(0), IDX(3), IDX(5), cIdx); allFaces.push_back(f);
-                }
-                break;
-                
-            case VTK_PYRAMID:
-                if (n >= 5) {
-                    Face f;
-                    f.set4(IDX(0), IDX(3), IDX(2), IDX(1), cIdx); allFaces.push_back(f); // Base
-                    f.set3(IDX(0), IDX(1), IDX(4), cIdx); allFaces.push_back(f);
-                    f.set3(IDX(1), IDX(2), IDX(4), cIdx); allFaces.push_back(f);
-                    f.set3(IDX(2), IDX(3), IDX(4), cIdx); allFaces.push_back(f);
-                    f.set3(IDX(3), IDX(0), IDX(4), cIdx); allFaces.push_back(f);
-                }
-                break;
-                
-            default:
-                break;
-        }
-        
-        #undef IDX
-        cellOffset += (n + 1);
+    if (totalFaces > UINT32_MAX) {
+        qWarning(meshProcessorLog) << "Too many faces for 32-bit face slots:" << totalFaces;
+        return result;
+    }
+    const uint32_t maxId = maxPointId(index);
+    if (totalFaces > 0 && maxId >= numPoints) {
+        qWarning(meshProcessorLog) << "Cells reference point" << maxId << "but only" << numPoints << "points exist";
+        return result;
     }
     qInfo(meshProcessorLog)
-        << "Face extraction" << allFaces.size() << "faces from" << totalCells << "cells in" << stageTimer.elapsed() << "ms";
-    stageTimer.restart();
-
-    // ============ Step 3: Sort faces to find unique boundary faces ============
-    // Using parallel sort for performance on large meshes
-    PAR_SORT(allFaces.begin(), allFaces.end());
-    qInfo(meshProcessorLog) << "Face sorting" << allFaces.size() << "faces in" << stageTimer.elapsed() << "ms";
+        << "Cell indexing" << totalFaces << "faces from" << totalCells << "cells in" << stageTimer.elapsed() << "ms";
     stageTimer.restart();
 
-    // ============ Step 4: Extract boundary faces (count == 1) ============
-    // A face that appears exactly once is on the boundary
-    std::vector<const Face*> boundaryFaces;
-    boundaryFaces.reserve(allFaces.size() / 2);
-    
-    size_t i = 0;
-    size_t nFaces = allFaces.size();
-    while (i < nFaces) {
-        size_t j = i + 1;
-        while (j < nFaces && allFaces[i] == allFaces[j]) {
-            ++j;
-        }
-        
-        // If count is 1, it's a boundary face
-        if (j - i == 1) {
-            boundaryFaces.push_back(&allFaces[i]);
-        }
-        
-        i = j;
+    // ============ Steps 3-4: Find boundary faces (faces that occur exactly once) ============
+    // Only packed keys and 32-bit face slots are touched; winding is fetched afterwards
+    // for the surviving faces. Small meshes fit the whole key into 64 bits.
+    int idBits = 1;
+    while (idBits < 31 && (maxId >> idBits) != 0) ++idBits;
+    const int keyBits = 1 + 4 * idBits;
+    
+    std::vector<uint32_t> boundarySlots;
+    if (keyBits <= 64) {
+        std::vector<uint64_t> keys = packFaceKeys<uint64_t>(index, idBits);
+        qInfo(meshProcessorLog) << "Face extraction" << keys.size() << "64-bit keys in" << stageTimer.elapsed() << "ms";
+        stageTimer.restart();
+        boundarySlots = findBoundarySlots(keys, keyBits);
+    } else {
+        std::vector<FaceKey> keys = packFaceKeys<FaceKey>(index, idBits);
+        qInfo(meshProcessorLog) << "Face extraction" << keys.size() << "128-bit keys in" << stageTimer.elapsed() << "ms";
+        stageTimer.restart();
+        boundarySlots = findBoundarySlots(keys, keyBits);
     }
     qInfo(meshProcessorLog)
-        << "Boundary selection" << boundaryFaces.size() << "faces in" << stageTimer.elapsed() << "ms";
+        << "Boundary selection" << boundarySlots.size() << "faces in" << stageTimer.elapsed() << "ms";
     stageTimer.restart();
+    
+    std::vector<Face> boundaryFaces = fetchFaces(index, boundarySlots);
+    if (m_subdivideCurved) {
+        boundaryFaces = subdivideFaces(index, boundarySlots, boundaryFaces);
+    }
 
-    // ============ Step 5: Generate flat-shaded vertices ============
-    // Count total triangles (quads become 2 triangles)
-    size_t numTriangles = 0;
-    for (const Face* f : boundaryFaces) {
-        numTriangles += (f->n == 4) ? 2 : 1;
+    // ============ Step 5: Triangulate boundary faces ============
+    // Quads become 2 triangles (0-1-2 and 0-2-3); per-face offsets let every face
+    // write its own triangles in parallel, in boundary-face order.
+    const int64_t faceCount = static_cast<int64_t>(boundaryFaces.size());
+    std::vector<size_t> triOffsets(boundaryFaces.size() + 1, 0);
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < faceCount; ++i) {
+        triOffsets[i] = (boundaryFaces[i].n == 4) ? 2 : 1;
     }
+    const size_t numTriangles = Parallel::exclusiveScan(triOffsets);
     
-    result.triangleCount = numTriangles;
-    result.vertexCount = numTriangles * 3;
-    
-    // vertex data: position(3) + normal(3) + scalar(1) = 7 floats per vertex
-    const size_t stride = 7;
-    result.vertexData.resize(result.vertexCount * stride);
-    result.vertexToPointIndex.resize(result.vertexCount);
-    result.vertexToCellIndex.resize(result.vertexCount);
+    std::vector<uint32_t> triPoints(numTriangles * 3);
+    std::vector<uint32_t> triCells(numTriangles);
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < faceCount; ++i) {
+        const Face& f = boundaryFaces[i];
+        const size_t t = triOffsets[i];
+        triPoints[t*3+0] = f.orig[0]; triPoints[t*3+1] = f.orig[1]; triPoints[t*3+2] = f.orig[2];
+        triCells[t] = f.cellIdx;
+        if (f.n == 4) {
+            triPoints[t*3+3] = f.orig[0]; triPoints[t*3+4] = f.orig[2]; triPoints[t*3+5] = f.orig[3];
+            triCells[t+1] = f.cellIdx;
+        }
+    }
     
-    // Also generate line indices for wireframe
-    result.lineIndices.reserve(numTriangles * 6);
+    // ============ Step 6: Generate vertices ============
+    result.triangleCount = numTriangles;
+    if (m_shadingMode == ShadingMode::Smooth) {
+        buildSmoothVertices(result, positions, numPoints, triPoints, triCells);
+    } else {
+        buildFlatVertices(result, positions, triPoints, triCells);
+    }
     
-    size_t vertIdx = 0;
+    // ============ Step 7: Unique edges for the wireframe ============
+    buildEdges(result, positions, boundaryFaces, triOffsets, idBits);
+    result.lineCount = featureLineCount(result, m_featureAngle);
+    result.triangleToCellIndex = std::move(triCells);
     
-    auto emitTriangle = [&](uint32_t i0, uint32_t i1, uint32_t i2, uint32_t cellIdx) {
-        // Get positions
-        float v0x = positions[i0*3+0], v0y = positions[i0*3+1], v0z = positions[i0*3+2];
-        float v1x = positions[i1*3+0], v1y = positions[i1*3+1], v1z = positions[i1*3+2];
-        float v2x = positions[i2*3+0], v2y = positions[i2*3+1], v2z = positions[i2*3+2];
-        
-        // Compute face normal
-        float e1x = v1x - v0x, e1y = v1y - v0y, e1z = v1z - v0z;
-        float e2x = v2x - v0x, e2y = v2y - v0y, e2z = v2z - v0z;
-        
-        float nx = e1y * e2z - e1z * e2y;
-        float ny = e1z * e2x - e1x * e2z;
-        float nz = e1x * e2y - e1y * e2x;
-        
-        float len = std::sqrt(nx*nx + ny*ny + nz*nz);
-        if (len > 1e-8f) {
-            float invLen = 1.0f / len;
-            nx *= invLen; ny *= invLen; nz *= invLen;
-        } else {
-            nx = 0.0f; ny = 1.0f; nz = 0.0f;
-        }
-        
-        // Store 3 vertices for this triangle
-        size_t baseIdx = vertIdx * stride;
-        
-        // Vertex 0
-        result.vertexData[baseIdx + 0] = v0x;
-        result.vertexData[baseIdx + 1] = v0y;
-        result.vertexData[baseIdx + 2] = v0z;
-        result.vertexData[baseIdx + 3] = nx;
-        result.vertexData[baseIdx + 4] = ny;
-        result.vertexData[baseIdx + 5] = nz;
-        result.vertexData[baseIdx + 6] = 0.5f;
-        result.vertexToPointIndex[vertIdx] = i0;
-        result.vertexToCellIndex[vertIdx] = cellIdx;
-        
-        // Vertex 1
-        result.vertexData[baseIdx + 7] = v1x;
-        result.vertexData[baseIdx + 8] = v1y;
-        result.vertexData[baseIdx + 9] = v1z;
-        result.vertexData[baseIdx + 10] = nx;
-        result.vertexData[baseIdx + 11] = ny;
-        result.vertexData[baseIdx + 12] = nz;
-        result.vertexData[baseIdx + 13] = 0.5f;
-        result.vertexToPointIndex[vertIdx + 1] = i1;
-        result.vertexToCellIndex[vertIdx + 1] = cellIdx;
-        
-        // Vertex 2
-        result.vertexData[baseIdx + 14] = v2x;
-        result.vertexData[baseIdx + 15] = v2y;
-        result.vertexData[baseIdx + 16] = v2z;
-        result.vertexData[baseIdx + 17] = nx;
-        result.vertexData[baseIdx + 18] = ny;
-        result.vertexData[baseIdx + 19] = nz;
-        result.vertexData[baseIdx + 20] = 0.5f;
-        result.vertexToPointIndex[vertIdx + 2] = i2;
-        result.vertexToCellIndex[vertIdx + 2] = cellIdx;
-        
-        // Line indices for wireframe
-        uint32_t vi0 = static_cast<uint32_t>(vertIdx);
-        uint32_t vi1 = static_cast<uint32_t>(vertIdx + 1);
-        uint32_t vi2 = static_cast<uint32_t>(vertIdx + 2);
-        result.lineIndices.push_back(vi0); result.lineIndices.push_back(vi1);
-        result.lineIndices.push_back(vi1); result.lineIndices.push_back(vi2);
-        result.lineIndices.push_back(vi2); result.lineIndices.push_back(vi0);
-        
-        vertIdx += 3;
-    };
-    
-    for (const Face* f : boundaryFaces) {
-        if (f->n == 3) {
-            emitTriangle(f->orig[0], f->orig[1], f->orig[2], f->cellIdx);
-        } else if (f->n == 4) {
-            // Triangulate quad: 0-1-2 and 0-2-3
-            emitTriangle(f->orig[0], f->orig[1], f->orig[2], f->cellIdx);
-            emitTriangle(f->orig[0], f->orig[2], f->orig[3], f->cellIdx);
-        }
+    // ============ Step 8: Vertex cache and overdraw order (indexed path) ============
+    if (!result.useFlatShading && m_optimizeIndices) {
+        optimizeIndexOrder(result);
     }
     
-    result.lineCount = result.lineIndices.size() / 2;
+    // ============ Step 9: Connected parts as triangle ranges ============
+    splitParts(result, index, numPoints);
     
-    // Point indices for point rendering (all vertices)
-    result.pointIndices.resize(result.vertexCount);
-    for (size_t i = 0; i < result.vertexCount; ++i) {
-        result.pointIndices[i] = static_cast<uint32_t>(i);
+    // ============ Step 10: Vertex and line cells, after the surface's vertices ============
+    appendCellPrimitives(result, index, positions, numPoints, m_subdivideCurved);
+    if (!result.cellLineIndices.empty() || !result.cellPointIndices.empty()) {
+        qInfo(meshProcessorLog) << "Cell primitives" << result.cellLineIndices.size() / 2 << "segments,"
+                                << result.cellPointIndices.size() << "points";
     }
     
-    // Triangle indices (sequential for flat shading with glDrawArrays)
-    result.triangleIndices.resize(result.vertexCount);
-    std::iota(result.triangleIndices.begin(), result.triangleIndices.end(), 0);
+    if (m_vertexFormat == VertexFormat::Compact) {
+        packCompactVertices(result);
+    }
     qInfo(meshProcessorLog)
         << "Vertex generation" << result.triangleCount << "tris," << result.vertexCount << "verts in"
         << stageTimer.elapsed() << "ms";
@@ -376,12 +214,1006 @@ void MeshProcessor::computeBoundingBox(const std::vector<float>& positions, size
     max = QVector3D(maxX, maxY, maxZ);
 }
 
+namespace {
+
+// Appends `width` (< 64) bits to the low end of a packed key
+inline void pushBits(uint64_t& key, uint64_t value, int width)
+{
+    key = (key << width) | value;
+}
+
+inline void pushBits(FaceKey& key, uint64_t value, int width)
+{
+    key.hi = (key.hi << width) | (key.lo >> (64 - width));
+    key.lo = (key.lo << width) | value;
+}
+
+inline uint32_t keyDigit(uint64_t key, int shift)
+{
+    return static_cast<uint32_t>((key >> shift) & 0xFF);
+}
+
+inline uint32_t keyDigit(const FaceKey& key, int shift)
+{
+    return key.digit(shift);
+}
+
+// Distinct face slots in ascending order. Marks each slot, then collects the marks, so
+// neither the hash table's probing nor the key order leaks into the result.
+std::vector<uint32_t> ascendingSlots(const std::vector<uint32_t>& slots, size_t slotCount)
+{
+    std::vector<uint8_t> marked(slotCount, 0);
+    const int64_t count = static_cast<int64_t>(slots.size());
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < count; ++i) {
+        marked[slots[i]] = 1;
+    }
+    return Parallel::collect<uint32_t>(slotCount,
+        [&marked](size_t i) { return marked[i] != 0; },
+        [](size_t i) { return static_cast<uint32_t>(i); });
+}
+
+template<typename Key>
+inline Key packFaceKey(const Face& f, int idBits)
+{
+    // Most significant first: triangles (flag 0) sort before quads (flag 1)
+    Key key{};
+    pushBits(key, f.n == 4 ? 1 : 0, 1);
+    pushBits(key, f.sorted[0], idBits);
+    pushBits(key, f.sorted[1], idBits);
+    pushBits(key, f.sorted[2], idBits);
+    pushBits(key, f.n == 4 ? f.sorted[3] : 0, idBits);
+    return key;
+}
+
+template<typename Key>
+struct KeySink {
+    Key* out;
+    int idBits;
+    void tri(uint32_t a, uint32_t b, uint32_t c) {
+        Face f; f.set3(a, b, c);
+        *out++ = packFaceKey<Key>(f, idBits);
+    }
+    void quad(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+        Face f; f.set4(a, b, c, d);
+        *out++ = packFaceKey<Key>(f, idBits);
+    }
+};
+
+// Picks the local face `wanted` out of a cell's faces
+struct FaceFetchSink {
+    Face* out;
+    uint32_t cellIdx;
+    size_t wanted;
+    size_t current;
+    void tri(uint32_t a, uint32_t b, uint32_t c) {
+        if (current++ == wanted) out->set3(a, b, c, cellIdx);
+    }
+    void quad(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+        if (current++ == wanted) out->set4(a, b, c, d, cellIdx);
+    }
+};
+
+// Counts the pieces of a subdivided face
+struct PieceCountSink {
+    void tri(uint32_t, uint32_t, uint32_t) {}
+    void quad(uint32_t, uint32_t, uint32_t, uint32_t) {}
+};
+
+// Writes the pieces of a subdivided face, owned by the face's cell
+struct PieceSink {
+    Face* out;
+    uint32_t cellIdx;
+    void tri(uint32_t a, uint32_t b, uint32_t c) { (out++)->set3(a, b, c, cellIdx); }
+    void quad(uint32_t a, uint32_t b, uint32_t c, uint32_t d) { (out++)->set4(a, b, c, d, cellIdx); }
+};
+
+// Unnormalized normal of triangle (i0, i1, i2); its length is twice the triangle area
+inline void triangleNormal(const float* positions, uint32_t i0, uint32_t i1, uint32_t i2,
+                           float& nx, float& ny, float& nz)
+{
+    const float* v0 = &positions[i0 * 3];
+    const float* v1 = &positions[i1 * 3];
+    const float* v2 = &positions[i2 * 3];
+    float e1x = v1[0] - v0[0], e1y = v1[1] - v0[1], e1z = v1[2] - v0[2];
+    float e2x = v2[0] - v0[0], e2y = v2[1] - v0[1], e2z = v2[2] - v0[2];
+    
+    nx = e1y * e2z - e1z * e2y;
+    ny = e1z * e2x - e1x * e2z;
+    nz = e1x * e2y - e1y * e2x;
+}
+
+// Normalizes in place; degenerate normals fall back to +Y
+inline void normalizeOrUp(float& nx, float& ny, float& nz)
+{
+    float len = std::sqrt(nx*nx + ny*ny + nz*nz);
+    if (len > 1e-8f) {
+        float invLen = 1.0f / len;
+        nx *= invLen; ny *= invLen; nz *= invLen;
+    } else {
+        nx = 0.0f; ny = 1.0f; nz = 0.0f;
+    }
+}
+
+// [0, 1] -> unorm16
+inline uint16_t quantizeUnit(float value)
+{
+    const float clamped = std::max(0.0f, std::min(1.0f, value));
+    return static_cast<uint16_t>(clamped * 65535.0f + 0.5f);
+}
+
+// [-1, 1] -> snorm16
+inline int16_t quantizeSigned(float value)
+{
+    const float clamped = std::max(-1.0f, std::min(1.0f, value));
+    return static_cast<int16_t>(std::lround(clamped * 32767.0f));
+}
+
+// Unit normal -> octahedral coordinates in [-1, 1]^2 (decoded in mesh.vert)
+inline void octEncode(float nx, float ny, float nz, float& u, float& v)
+{
+    const float invL1 = 1.0f / (std::fabs(nx) + std::fabs(ny) + std::fabs(nz));
+    u = nx * invL1;
+    v = ny * invL1;
+    if (nz < 0.0f) {
+        // Fold the lower hemisphere over the diagonals
+        const float fu = (1.0f - std::fabs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+        const float fv = (1.0f - std::fabs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+        u = fu;
+        v = fv;
+    }
+}
+
+// Cell ids grouped by type with a counting sort: every chunk counts its types, then
+// scatters its cells behind those of earlier chunks, so ids stay ascending within a type.
+// typeStarts gets the start of each of the 256 types in typeCells, plus the total.
+template<typename TypeAt>
+void groupByType(size_t count, TypeAt typeAt, std::vector<uint32_t>& typeCells, std::vector<size_t>& typeStarts)
+{
+    const int chunks = std::max(1, std::min(Parallel::maxThreads(), static_cast<int>(count / 65536) + 1));
+    std::vector<size_t> next(static_cast<size_t>(chunks) * 256, 0);
+    #pragma omp parallel for schedule(static, 1) num_threads(chunks)
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        size_t begin, end;
+        Parallel::chunkRange(count, chunks, chunk, begin, end);
+        size_t* histogram = &next[static_cast<size_t>(chunk) * 256];
+        for (size_t i = begin; i < end; ++i) ++histogram[typeAt(i)];
+    }
+    
+    typeStarts.assign(257, 0);
+    size_t total = 0;
+    for (int type = 0; type < 256; ++type) {
+        typeStarts[type] = total;
+        for (int chunk = 0; chunk < chunks; ++chunk) {
+            size_t& slot = next[static_cast<size_t>(chunk) * 256 + type];
+            const size_t n = slot;
+            slot = total;
+            total += n;
+        }
+    }
+    typeStarts[256] = total;
+    
+    typeCells.resize(count);
+    #pragma omp parallel for schedule(static, 1) num_threads(chunks)
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        size_t begin, end;
+        Parallel::chunkRange(count, chunks, chunk, begin, end);
+        size_t* out = &next[static_cast<size_t>(chunk) * 256];
+        for (size_t i = begin; i < end; ++i) typeCells[out[typeAt(i)]++] = static_cast<uint32_t>(i);
+    }
+}
+
+// Calls fn(tag, cells, count) once per type present, with the type as a compile-time
+// constant in tag, so each homogeneous batch runs its own specialized loop
+template<typename Fn>
+void forEachTypeBatch(const std::vector<size_t>& typeStarts, const std::vector<uint32_t>& typeCells, Fn fn)
+{
+    for (int type = 0; type < 256; ++type) {
+        const size_t begin = typeStarts[type];
+        const size_t end = typeStarts[type + 1];
+        if (begin == end) continue;
+        CellTopology::withCellType(static_cast<uint8_t>(type), [&](auto tag) {
+            fn(tag, typeCells.data() + begin, static_cast<int64_t>(end - begin));
+        });
+    }
+}
+
+// One float per tuple. The inner loops have no type or bounds checks so they vectorize;
+// 3-component vectors get an unrolled magnitude, summed in double like ArrayValues::tupleValue.
+template<typename T>
+void computeTupleValues(const T* data, size_t tuples, int numComp, int comp, float* out)
+{
+    const int64_t count = static_cast<int64_t>(tuples);
+    if (comp >= 0) {
+        #pragma omp parallel for schedule(static)
+        for (int64_t i = 0; i < count; ++i) {
+            out[i] = static_cast<float>(data[i * numComp + comp]);
+        }
+    } else if (numComp == 3) {
+        #pragma omp parallel for schedule(static)
+        for (int64_t i = 0; i < count; ++i) {
+            const double x = static_cast<double>(data[i * 3 + 0]);
+            const double y = static_cast<double>(data[i * 3 + 1]);
+            const double z = static_cast<double>(data[i * 3 + 2]);
+            out[i] = static_cast<float>(std::sqrt(x * x + y * y + z * z));
+        }
+    } else {
+        #pragma omp parallel for schedule(static)
+        for (int64_t i = 0; i < count; ++i) {
+            out[i] = static_cast<float>(ArrayValues::tupleValue(data, static_cast<size_t>(i), numComp, -1));
+        }
+    }
+}
+
+} // namespace
+
+MeshProcessor::CellFaceIndex MeshProcessor::buildCellFaceIndex(const UnstructuredGrid& grid)
+{
+    CellFaceIndex index;
+    index.cells = grid.cells.data();
+    index.types = grid.cell_types.data();
+    index.numTypes = grid.cell_types.size();
+    
+    // Cell-offset index into the flattened [n, ids...] array (inherently sequential)
+    index.cellOffsets = CellTopology::cellOffsets(grid);
+    
+    groupByType(index.cellOffsets.size(), [&index](size_t cellIdx) { return index.typeAt(cellIdx); },
+                index.typeCells, index.typeStarts);
+    
+    // Face count per cell, turned into per-cell face slots
+    index.faceOffsets.assign(index.cellOffsets.size() + 1, 0);
+    forEachTypeBatch(index.typeStarts, index.typeCells, [&index](auto tag, const uint32_t* cells, int64_t count) {
+        #pragma omp parallel for schedule(static)
+        for (int64_t i = 0; i < count; ++i) {
+            const int32_t* record = &index.cells[index.cellOffsets[cells[i]]];
+            index.faceOffsets[cells[i]] = CellTopology::faceCount<decltype(tag)::value>(record[0], record + 1);
+        }
+    });
+    Parallel::exclusiveScan(index.faceOffsets);
+    return index;
+}
+
+uint32_t MeshProcessor::maxPointId(const CellFaceIndex& index)
+{
+    const int chunks = Parallel::maxThreads();
+    std::vector<uint32_t> chunkMax(chunks, 0);
+    
+    #pragma omp parallel for schedule(static, 1)
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        size_t begin, end;
+        Parallel::chunkRange(index.cellCount(), chunks, chunk, begin, end);
+        uint32_t m = 0;
+        for (size_t cellIdx = begin; cellIdx < end; ++cellIdx) {
+            if (index.faceOffsets[cellIdx + 1] == index.faceOffsets[cellIdx]) continue;
+            const int32_t* c = &index.cells[index.cellOffsets[cellIdx]];
+            CellTopology::visitPointSlots(index.typeAt(cellIdx), c, [c, &m](int32_t k) {
+                // Negative ids wrap to huge values and get rejected by the caller
+                m = std::max(m, static_cast<uint32_t>(c[k]));
+            });
+        }
+        chunkMax[chunk] = m;
+    }
+    return *std::max_element(chunkMax.begin(), chunkMax.end());
+}
+
+template<typename Key>
+std::vector<Key> MeshProcessor::packFaceKeys(const CellFaceIndex& index, int idBits)
+{
+    std::vector<Key> keys(index.faceCount());
+    
+    // One loop per cell type, with that type's face table inlined
+    forEachTypeBatch(index.typeStarts, index.typeCells, [&](auto tag, const uint32_t* cells, int64_t count) {
+        constexpr uint8_t type = decltype(tag)::value;
+        if (CellTopology::CellTraits<type>::layout == CellTopology::FaceLayout::None) return;
+        #pragma omp parallel for schedule(static)
+        for (int64_t i = 0; i < count; ++i) {
+            const size_t cellIdx = cells[i];
+            const size_t offset = index.cellOffsets[cellIdx];
+            KeySink<Key> sink{keys.data() + index.faceOffsets[cellIdx], idBits};
+            CellTopology::visitFaces<type>(index.cells[offset], &index.cells[offset + 1], sink);
+        }
+    });
+    return keys;
+}
+
+template<typename Key>
+std::vector<uint32_t> MeshProcessor::findBoundarySlots(std::vector<Key>& keys, int keyBits) const
+{
+    const size_t nFaces = keys.size();
+    
+    if (m_boundaryMethod == BoundaryMethod::Hash) {
+        // Expected O(F): shared faces cancel each other in a concurrent hash table
+        FaceHashTable<Key> table(keys.data(), nFaces);
+        table.insertAll();
+        return ascendingSlots(table.boundaryFaces(), nFaces);
+    }
+    
+    // Radix sort keys together with their face slots
+    std::vector<uint32_t> slots(nFaces);
+    const int64_t nFacesSigned = static_cast<int64_t>(nFaces);
+    #pragma omp parallel for schedule(static)
+    for (int64_t f = 0; f < nFacesSigned; ++f) {
+        slots[f] = static_cast<uint32_t>(f);
+    }
+    RadixSort::sortPairs(keys, slots, keyBits, [](const Key& key, int shift) { return keyDigit(key, shift); });
+    
+    // A face that appears exactly once differs from both sorted neighbours
+    const Key* k = keys.data();
+    return ascendingSlots(Parallel::collect<uint32_t>(nFaces,
+        [k, nFaces](size_t i) {
+            return (i == 0 || k[i] != k[i - 1]) && (i + 1 == nFaces || k[i] != k[i + 1]);
+        },
+        [&slots](size_t i) { return slots[i]; }), nFaces);
+}
+
+template<typename Key>
+void MeshProcessor::numberFaces(std::vector<Key>& keys, int keyBits, FaceTopology& topology)
+{
+    const size_t nSlots = keys.size();
+    std::vector<uint32_t>& slots = topology.faceSlots;
+    slots.resize(nSlots);
+    const int64_t nSlotsSigned = static_cast<int64_t>(nSlots);
+    #pragma omp parallel for schedule(static)
+    for (int64_t s = 0; s < nSlotsSigned; ++s) {
+        slots[s] = static_cast<uint32_t>(s);
+    }
+    RadixSort::sortPairs(keys, slots, keyBits, [](const Key& key, int shift) { return keyDigit(key, shift); });
+    
+    // Every run of equal keys starts a new face
+    const Key* k = keys.data();
+    topology.faceSlotOffsets = Parallel::collect<uint32_t>(nSlots,
+        [k](size_t i) { return i == 0 || k[i] != k[i - 1]; },
+        [](size_t i) { return static_cast<uint32_t>(i); });
+    topology.faceSlotOffsets.push_back(static_cast<uint32_t>(nSlots));
+    
+    topology.slotFaces.resize(nSlots);
+    const int64_t nFaces = static_cast<int64_t>(topology.faceCount());
+    #pragma omp parallel for schedule(static)
+    for (int64_t f = 0; f < nFaces; ++f) {
+        for (uint32_t i = topology.faceSlotOffsets[f]; i < topology.faceSlotOffsets[f + 1]; ++i) {
+            topology.slotFaces[slots[i]] = static_cast<uint32_t>(f);
+        }
+    }
+}
+
+bool MeshProcessor::buildFaceTopology(const UnstructuredGrid& grid, size_t numPoints, FaceTopology& topology)
+{
+    topology = FaceTopology();
+    CellFaceIndex index = buildCellFaceIndex(grid);
+    if (index.faceCount() >= UINT32_MAX) return false;
+    const uint32_t maxId = maxPointId(index);
+    if (index.faceCount() > 0 && maxId >= numPoints) return false;
+    
+    int idBits = 1;
+    while (idBits < 31 && (maxId >> idBits) != 0) ++idBits;
+    const int keyBits = 1 + 4 * idBits;
+    if (keyBits <= 64) {
+        std::vector<uint64_t> keys = packFaceKeys<uint64_t>(index, idBits);
+        numberFaces(keys, keyBits, topology);
+    } else {
+        std::vector<FaceKey> keys = packFaceKeys<FaceKey>(index, idBits);
+        numberFaces(keys, keyBits, topology);
+    }
+    topology.cellOffsets = std::move(index.cellOffsets);
+    topology.cellSlots = std::move(index.faceOffsets);
+    return true;
+}
+
+std::vector<Face> MeshProcessor::fetchFaces(const CellFaceIndex& index, const std::vector<uint32_t>& slots)
+{
+    std::vector<Face> faces(slots.size());
+    const int64_t count = static_cast<int64_t>(slots.size());
+    
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < count; ++i) {
+        const size_t slot = slots[i];
+        const size_t cellIdx = static_cast<size_t>(
+            std::upper_bound(index.faceOffsets.begin(), index.faceOffsets.end(), slot) - index.faceOffsets.begin()) - 1;
+        const size_t offset = index.cellOffsets[cellIdx];
+        FaceFetchSink sink{&faces[i], static_cast<uint32_t>(cellIdx), slot - index.faceOffsets[cellIdx], 0};
+        CellTopology::visitCellFaces(index.typeAt(cellIdx), index.cells[offset], &index.cells[offset + 1], sink);
+    }
+    return faces;
+}
+
+std::vector<Face> MeshProcessor::subdivideFaces(const CellFaceIndex& index, const std::vector<uint32_t>& slots,
+                                                const std::vector<Face>& faces)
+{
+    // Pieces of face i (0: kept whole), from the table entry of its local face
+    auto split = [&](int64_t i, auto& sink) {
+        const uint32_t cellIdx = faces[i].cellIdx;
+        const CellTopology::FaceDef* def =
+            CellTopology::faceDef(index.typeAt(cellIdx), slots[i] - index.faceOffsets[cellIdx]);
+        return def ? CellTopology::subdivideFace(*def, &index.cells[index.cellOffsets[cellIdx] + 1], sink) : 0;
+    };
+    
+    const int64_t count = static_cast<int64_t>(faces.size());
+    std::vector<size_t> offsets(faces.size() + 1, 0);
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < count; ++i) {
+        PieceCountSink sink;
+        offsets[i] = std::max(split(i, sink), 1);
+    }
+    const size_t total = Parallel::exclusiveScan(offsets);
+    
+    std::vector<Face> pieces(total);
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < count; ++i) {
+        PieceSink sink{&pieces[offsets[i]], faces[i].cellIdx};
+        if (split(i, sink) == 0) pieces[offsets[i]] = faces[i];
+    }
+    return pieces;
+}
+
+void MeshProcessor::appendCellPrimitives(GPUMeshData& mesh, const CellFaceIndex& index,
+                                         const std::vector<float>& positions, size_t numPoints, bool curved)
+{
+    std::vector<uint32_t> cells;
+    forEachTypeBatch(index.typeStarts, index.typeCells, [&cells](auto tag, const uint32_t* batch, int64_t count) {
+        const int dimension = CellTopology::CellTraits<decltype(tag)::value>::dimension;
+        if (dimension == 0 || dimension == 1) cells.insert(cells.end(), batch, batch + count);
+    });
+    if (cells.empty()) return;
+    
+    // Vertices, segment ends and points of every cell; cells with invalid ids (or lines
+    // of a single point) get none
+    const int64_t count = static_cast<int64_t>(cells.size());
+    std::vector<size_t> vertexOffsets(cells.size() + 1, 0);
+    std::vector<size_t> lineOffsets(cells.size() + 1, 0);
+    std::vector<size_t> pointOffsets(cells.size() + 1, 0);
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < count; ++i) {
+        const uint32_t cellIdx = cells[i];
+        const int32_t* record = &index.cells[index.cellOffsets[cellIdx]];
+        const uint8_t type = index.typeAt(cellIdx);
+        size_t length = 0;
+        bool valid = true;
+        CellTopology::visitCellPath(type, record[0], record + 1, curved, [&](uint32_t p) {
+            valid = valid && p < numPoints;
+            ++length;
+        });
+        const bool line = CellTopology::cellDimension(type) == 1;
+        if (!valid || (line && length < 2)) length = 0;
+        vertexOffsets[i] = length;
+        lineOffsets[i] = line && length > 0 ? (length - 1) * 2 : 0;
+        pointOffsets[i] = line ? 0 : length;
+    }
+    const size_t added = Parallel::exclusiveScan(vertexOffsets);
+    const size_t lineEnds = Parallel::exclusiveScan(lineOffsets);
+    const size_t points = Parallel::exclusiveScan(pointOffsets);
+    if (added == 0) return;
+    
+    // Same streams as the surface's vertices, with an up normal and no scalar yet
+    const size_t stride = 6;
+    const size_t base = mesh.vertexCount;
+    mesh.vertexData.resize((base + added) * stride);
+    mesh.scalarData.resize(base + added, 0.5f);
+    mesh.vertexToPointIndex.resize(base + added);
+    mesh.vertexToCellIndex.resize(base + added);
+    mesh.cellLineIndices.resize(lineEnds);
+    mesh.cellPointIndices.resize(points);
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < count; ++i) {
+        const size_t first = base + vertexOffsets[i];
+        const size_t length = vertexOffsets[i + 1] - vertexOffsets[i];
+        if (length == 0) continue;
+        const uint32_t cellIdx = cells[i];
+        const int32_t* record = &index.cells[index.cellOffsets[cellIdx]];
+        size_t v = first;
+        CellTopology::visitCellPath(index.typeAt(cellIdx), record[0], record + 1, curved, [&](uint32_t p) {
+            float* out = &mesh.vertexData[v * stride];
+            out[0] = positions[p*3+0];
+            out[1] = positions[p*3+1];
+            out[2] = positions[p*3+2];
+            out[3] = 0.0f;
+            out[4] = 1.0f;
+            out[5] = 0.0f;
+            mesh.vertexToPointIndex[v] = p;
+            mesh.vertexToCellIndex[v] = cellIdx;
+            ++v;
+        });
+        uint32_t* segments = mesh.cellLineIndices.data() + lineOffsets[i];
+        for (size_t k = 0; k < (lineOffsets[i + 1] - lineOffsets[i]) / 2; ++k) {
+            segments[k*2+0] = static_cast<uint32_t>(first + k);
+            segments[k*2+1] = static_cast<uint32_t>(first + k + 1);
+        }
+        for (size_t k = 0; k < pointOffsets[i + 1] - pointOffsets[i]; ++k) {
+            mesh.cellPointIndices[pointOffsets[i] + k] = static_cast<uint32_t>(first + k);
+        }
+    }
+    mesh.vertexCount += added;
+}
+
+void MeshProcessor::buildFlatVertices(GPUMeshData& mesh, const std::vector<float>& positions,
+                                      const std::vector<uint32_t>& triPoints,
+                                      const std::vector<uint32_t>& triCells)
+{
+    const size_t numTriangles = triCells.size();
+    mesh.useFlatShading = true;
+    mesh.vertexCount = numTriangles * 3;
+    
+    // vertex data: position(3) + normal(3) = 6 floats per vertex, scalars in their own stream
+    const size_t stride = 6;
+    mesh.vertexData.resize(mesh.vertexCount * stride);
+    mesh.scalarData.assign(mesh.vertexCount, 0.5f);
+    mesh.vertexToPointIndex.resize(mesh.vertexCount);
+    mesh.vertexToCellIndex.resize(mesh.vertexCount);
+    
+    // Triangle t owns vertices 3t..3t+2
+    const int64_t count = static_cast<int64_t>(numTriangles);
+    #pragma omp parallel for schedule(static)
+    for (int64_t t = 0; t < count; ++t) {
+        const uint32_t* tri = &triPoints[t * 3];
+        float nx, ny, nz;
+        triangleNormal(positions.data(), tri[0], tri[1], tri[2], nx, ny, nz);
+        normalizeOrUp(nx, ny, nz);
+        
+        const size_t vertIdx = static_cast<size_t>(t) * 3;
+        for (int k = 0; k < 3; ++k) {
+            float* v = &mesh.vertexData[(vertIdx + k) * stride];
+            v[0] = positions[tri[k]*3+0];
+            v[1] = positions[tri[k]*3+1];
+            v[2] = positions[tri[k]*3+2];
+            v[3] = nx;
+            v[4] = ny;
+            v[5] = nz;
+            mesh.vertexToPointIndex[vertIdx + k] = tri[k];
+            mesh.vertexToCellIndex[vertIdx + k] = triCells[t];
+        }
+    }
+    
+    // Triangle and point indices are sequential for flat shading
+    mesh.triangleIndices.resize(mesh.vertexCount);
+    mesh.pointIndices.resize(mesh.vertexCount);
+    const int64_t numVerts = static_cast<int64_t>(mesh.vertexCount);
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < numVerts; ++i) {
+        mesh.triangleIndices[i] = static_cast<uint32_t>(i);
+        mesh.pointIndices[i] = static_cast<uint32_t>(i);
+    }
+}
+
+void MeshProcessor::buildSmoothVertices(GPUMeshData& mesh, const std::vector<float>& positions, size_t numPoints,
+                                        const std::vector<uint32_t>& triPoints,
+                                        const std::vector<uint32_t>& triCells)
+{
+    const size_t numTriangles = triCells.size();
+    const int64_t triCount = static_cast<int64_t>(numTriangles);
+    const int64_t cornerCount = static_cast<int64_t>(triPoints.size());
+    mesh.useFlatShading = false;
+    
+    // Triangles per point; points with any become render vertices, numbered in point order
+    std::vector<std::atomic<uint32_t>> pointTris(numPoints);
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < cornerCount; ++i) {
+        pointTris[triPoints[i]].fetch_add(1, std::memory_order_relaxed);
+    }
+    mesh.vertexToPointIndex = Parallel::collect<uint32_t>(numPoints,
+        [&pointTris](size_t p) { return pointTris[p].load(std::memory_order_relaxed) != 0; },
+        [](size_t p) { return static_cast<uint32_t>(p); });
+    mesh.vertexCount = mesh.vertexToPointIndex.size();
+    const int64_t numVerts = static_cast<int64_t>(mesh.vertexCount);
+    
+    // Vertex -> adjacent triangles (CSR). Each list is sorted afterwards so that the
+    // normal sums do not depend on thread scheduling.
+    std::vector<uint32_t> pointToVertex(numPoints, 0);
+    std::vector<size_t> adjOffsets(mesh.vertexCount + 1, 0);
+    #pragma omp parallel for schedule(static)
+    for (int64_t v = 0; v < numVerts; ++v) {
+        const uint32_t p = mesh.vertexToPointIndex[v];
+        pointToVertex[p] = static_cast<uint32_t>(v);
+        adjOffsets[v] = pointTris[p].load(std::memory_order_relaxed);
+    }
+    Parallel::exclusiveScan(adjOffsets);
+    
+    std::vector<uint32_t> adjTris(triPoints.size());
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < cornerCount; ++i) {
+        const uint32_t p = triPoints[i];
+        const size_t pos = adjOffsets[pointToVertex[p]] + pointTris[p].fetch_sub(1, std::memory_order_relaxed) - 1;
+        adjTris[pos] = static_cast<uint32_t>(i / 3);
+    }
+    
+    // Area-weighted face normals: the unnormalized cross product is twice the area
+    std::vector<float> faceNormals(numTriangles * 3);
+    #pragma omp parallel for schedule(static)
+    for (int64_t t = 0; t < triCount; ++t) {
+        triangleNormal(positions.data(), triPoints[t*3+0], triPoints[t*3+1], triPoints[t*3+2],
+                       faceNormals[t*3+0], faceNormals[t*3+1], faceNormals[t*3+2]);
+    }
+    
+    // vertex data: position(3) + normal(3) = 6 floats per vertex, scalars in their own stream
+    const size_t stride = 6;
+    mesh.vertexData.resize(mesh.vertexCount * stride);
+    mesh.scalarData.assign(mesh.vertexCount, 0.5f);
+    mesh.vertexToCellIndex.resize(mesh.vertexCount);
+    mesh.pointIndices.resize(mesh.vertexCount);
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (int64_t v = 0; v < numVerts; ++v) {
+        uint32_t* first = &adjTris[adjOffsets[v]];
+        uint32_t* last = &adjTris[0] + adjOffsets[v + 1];
+        std::sort(first, last);
+        
+        float nx = 0.0f, ny = 0.0f, nz = 0.0f;
+        for (const uint32_t* t = first; t != last; ++t) {
+            nx += faceNormals[*t * 3 + 0];
+            ny += faceNormals[*t * 3 + 1];
+            nz += faceNormals[*t * 3 + 2];
+        }
+        normalizeOrUp(nx, ny, nz);
+        
+        const uint32_t p = mesh.vertexToPointIndex[v];
+        float* out = &mesh.vertexData[static_cast<size_t>(v) * stride];
+        out[0] = positions[p*3+0];
+        out[1] = positions[p*3+1];
+        out[2] = positions[p*3+2];
+        out[3] = nx;
+        out[4] = ny;
+        out[5] = nz;
+        // Shared vertices have no single cell; cell data is taken from the first adjacent triangle
+        mesh.vertexToCellIndex[v] = triCells[*first];
+        mesh.pointIndices[v] = static_cast<uint32_t>(v);
+    }
+    
+    // Real triangle indices into the shared vertices
+    mesh.triangleIndices.resize(triPoints.size());
+    #pragma omp parallel for schedule(static)
+    for (int64_t t = 0; t < triCount; ++t) {
+        const uint32_t v0 = pointToVertex[triPoints[t*3+0]];
+        const uint32_t v1 = pointToVertex[triPoints[t*3+1]];
+        const uint32_t v2 = pointToVertex[triPoints[t*3+2]];
+        mesh.triangleIndices[t*3+0] = v0;
+        mesh.triangleIndices[t*3+1] = v1;
+        mesh.triangleIndices[t*3+2] = v2;
+    }
+}
+
+void MeshProcessor::permuteTriangles(GPUMeshData& mesh, const std::vector<uint32_t>& order)
+{
+    const int64_t triCount = static_cast<int64_t>(order.size());
+    std::vector<uint32_t> indices(mesh.triangleIndices.size());
+    std::vector<uint32_t> cells(mesh.triangleToCellIndex.size());
+    const bool hasCells = (cells.size() == order.size());
+    #pragma omp parallel for schedule(static)
+    for (int64_t t = 0; t < triCount; ++t) {
+        const uint32_t src = order[t];
+        indices[t*3+0] = mesh.triangleIndices[src*3+0];
+        indices[t*3+1] = mesh.triangleIndices[src*3+1];
+        indices[t*3+2] = mesh.triangleIndices[src*3+2];
+        if (hasCells) cells[t] = mesh.triangleToCellIndex[src];
+    }
+    mesh.triangleIndices.swap(indices);
+    if (hasCells) mesh.triangleToCellIndex.swap(cells);
+}
+
+void MeshProcessor::splitParts(GPUMeshData& mesh, const CellFaceIndex& index, size_t numPoints) const
+{
+    if (m_partMode == PartMode::None || mesh.triangleCount == 0) return;
+    QElapsedTimer timer;
+    timer.start();
+    
+    MeshParts::PointForest forest(numPoints);
+    if (m_partMode == PartMode::Cells) {
+        // Every point of a cell joins its first valid point; lines and vertices link parts too
+        const int64_t cellCount = static_cast<int64_t>(index.cellCount());
+        #pragma omp parallel for schedule(static)
+        for (int64_t c = 0; c < cellCount; ++c) {
+            const int32_t* record = &index.cells[index.cellOffsets[c]];
+            uint32_t first = UINT32_MAX;
+            CellTopology::visitPointSlots(index.typeAt(c), record, [&](int32_t k) {
+                const uint32_t id = static_cast<uint32_t>(record[k]);
+                if (id >= numPoints) return;
+                if (first == UINT32_MAX) first = id;
+                else if (id != first) forest.unite(first, id);
+            });
+        }
+    } else {
+        const std::vector<uint32_t>& tris = mesh.triangleIndices;
+        const std::vector<uint32_t>& points = mesh.vertexToPointIndex;
+        const int64_t triCount = static_cast<int64_t>(mesh.triangleCount);
+        #pragma omp parallel for schedule(static)
+        for (int64_t t = 0; t < triCount; ++t) {
+            forest.unite(points[tris[t*3+0]], points[tris[t*3+1]]);
+            forest.unite(points[tris[t*3+0]], points[tris[t*3+2]]);
+        }
+    }
+    
+    permuteTriangles(mesh, MeshParts::groupTriangles(forest, mesh.triangleIndices, mesh.vertexToPointIndex,
+                                                     mesh.partOffsets));
+    qInfo(meshProcessorLog) << "Part split" << mesh.partOffsets.size() - 1 << "parts in" << timer.elapsed() << "ms";
+}
+
+void MeshProcessor::permuteVertices(GPUMeshData& mesh, const std::vector<uint32_t>& order)
+{
+    const int64_t numVerts = static_cast<int64_t>(order.size());
+    std::vector<uint32_t> oldToNew(order.size());
+    #pragma omp parallel for schedule(static)
+    for (int64_t v = 0; v < numVerts; ++v) {
+        oldToNew[order[v]] = static_cast<uint32_t>(v);
+    }
+    
+    // Per-vertex streams: gather through the new order
+    auto gather = [&order, numVerts](auto& values, size_t stride) {
+        if (values.size() != order.size() * stride) return;
+        std::remove_reference_t<decltype(values)> permuted(values.size());
+        #pragma omp parallel for schedule(static)
+        for (int64_t v = 0; v < numVerts; ++v) {
+            for (size_t k = 0; k < stride; ++k) {
+                permuted[v * stride + k] = values[order[v] * stride + k];
+            }
+        }
+        values.swap(permuted);
+    };
+    gather(mesh.vertexData, 6);
+    gather(mesh.compactVertices, 1);
+    gather(mesh.scalarData, 1);
+    gather(mesh.compactScalars, 1);
+    gather(mesh.vertexToPointIndex, 1);
+    gather(mesh.vertexToCellIndex, 1);
+    
+    // Index buffers: rename in place
+    auto remap = [&oldToNew](std::vector<uint32_t>& indices) {
+        const int64_t count = static_cast<int64_t>(indices.size());
+        #pragma omp parallel for schedule(static)
+        for (int64_t i = 0; i < count; ++i) {
+            indices[i] = oldToNew[indices[i]];
+        }
+    };
+    remap(mesh.triangleIndices);
+    remap(mesh.lineIndices);
+    remap(mesh.pointIndices);
+}
+
+void MeshProcessor::optimizeIndexOrder(GPUMeshData& mesh)
+{
+    QElapsedTimer timer;
+    timer.start();
+    const size_t stride = 6;
+    
+    // The metrics cost a full software rasterization, so only gather them when they are shown
+    const bool report = meshProcessorLog().isInfoEnabled();
+    double acmrBefore = 0.0, overdrawBefore = 0.0;
+    if (report) {
+        acmrBefore = MeshOptimizer::acmr(mesh.triangleIndices, mesh.vertexCount);
+        overdrawBefore = MeshOptimizer::overdraw(mesh.triangleIndices, mesh.vertexData.data(), stride);
+        timer.restart();
+    }
+    
+    permuteTriangles(mesh, MeshOptimizer::optimizeTriangleOrder(mesh.triangleIndices, mesh.vertexData.data(), stride));
+    permuteVertices(mesh, MeshOptimizer::vertexFetchOrder(mesh.triangleIndices, mesh.vertexCount));
+    const qint64 elapsed = timer.elapsed();
+    
+    if (report) {
+        qInfo(meshProcessorLog) << "Index optimization" << mesh.triangleCount << "tris in" << elapsed << "ms:"
+                                << "ACMR" << acmrBefore << "->" << MeshOptimizer::acmr(mesh.triangleIndices, mesh.vertexCount)
+                                << ", overdraw" << overdrawBefore << "->"
+                                << MeshOptimizer::overdraw(mesh.triangleIndices, mesh.vertexData.data(), stride);
+    }
+}
+
+void MeshProcessor::packCompactVertices(GPUMeshData& mesh)
+{
+    const float origin[3] = {mesh.boundingBoxMin.x(), mesh.boundingBoxMin.y(), mesh.boundingBoxMin.z()};
+    const float extent[3] = {mesh.boundingBoxMax.x() - origin[0],
+                             mesh.boundingBoxMax.y() - origin[1],
+                             mesh.boundingBoxMax.z() - origin[2]};
+    float invExtent[3];
+    for (int i = 0; i < 3; ++i) {
+        invExtent[i] = (extent[i] > 0.0f) ? 1.0f / extent[i] : 0.0f;
+    }
+    
+    const size_t stride = 6;
+    mesh.compactVertices.resize(mesh.vertexCount);
+    mesh.compactScalars.resize(mesh.vertexCount);
+    const int64_t numVerts = static_cast<int64_t>(mesh.vertexCount);
+    #pragma omp parallel for schedule(static)
+    for (int64_t v = 0; v < numVerts; ++v) {
+        const float* in = &mesh.vertexData[static_cast<size_t>(v) * stride];
+        CompactVertex& out = mesh.compactVertices[v];
+        for (int i = 0; i < 3; ++i) {
+            out.position[i] = quantizeUnit((in[i] - origin[i]) * invExtent[i]);
+        }
+        float u, w;
+        octEncode(in[3], in[4], in[5], u, w);
+        out.normal[0] = quantizeSigned(u);
+        out.normal[1] = quantizeSigned(w);
+        out.padding = 0;
+        mesh.compactScalars[v] = quantizeUnit(mesh.scalarData[v]);
+    }
+    
+    mesh.vertexFormat = VertexFormat::Compact;
+    std::vector<float>().swap(mesh.vertexData);
+    std::vector<float>().swap(mesh.scalarData);
+}
+
+void MeshProcessor::buildEdges(GPUMeshData& mesh, const std::vector<float>& positions,
+                               const std::vector<Face>& faces, const std::vector<size_t>& triOffsets,
+                               int idBits)
+{
+    const int64_t faceCount = static_cast<int64_t>(faces.size());
+    
+    // Every polygon edge of every boundary face gets a slot; quad diagonals are not edges
+    std::vector<size_t> edgeOffsets(faces.size() + 1, 0);
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < faceCount; ++i) {
+        edgeOffsets[i] = faces[i].n;
+    }
+    const size_t totalEdges = Parallel::exclusiveScan(edgeOffsets);
+    if (totalEdges > UINT32_MAX) {
+        qWarning(meshProcessorLog) << "Too many boundary edges for 32-bit edge slots:" << totalEdges;
+        return;
+    }
+    
+    // Edge key: (min id, max id); the render vertices come from the face's own corners,
+    // which are shared in smooth mode and per-face in flat mode
+    std::vector<uint64_t> keys(totalEdges);
+    std::vector<uint32_t> slots(totalEdges);
+    std::vector<uint32_t> edgeVerts(totalEdges * 2);
+    std::vector<uint32_t> edgeFaces(totalEdges);
+    std::vector<float> faceNormals(faces.size() * 3);
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < faceCount; ++i) {
+        const Face& f = faces[i];
+        const size_t t = triOffsets[i];
+        // Corner k sits at 3t+k; the quad's 4th corner is the last corner of its second triangle
+        const uint32_t corners[4] = {
+            mesh.triangleIndices[t*3+0], mesh.triangleIndices[t*3+1], mesh.triangleIndices[t*3+2],
+            (f.n == 4) ? mesh.triangleIndices[t*3+5] : 0
+        };
+        
+        for (int k = 0; k < f.n; ++k) {
+            const int next = (k + 1 == f.n) ? 0 : k + 1;
+            const uint64_t a = f.orig[k], b = f.orig[next];
+            const size_t e = edgeOffsets[i] + k;
+            keys[e] = (std::min(a, b) << idBits) | std::max(a, b);
+            slots[e] = static_cast<uint32_t>(e);
+            edgeVerts[e*2+0] = corners[k];
+            edgeVerts[e*2+1] = corners[next];
+            edgeFaces[e] = static_cast<uint32_t>(i);
+        }
+        
+        float nx, ny, nz;
+        triangleNormal(positions.data(), f.orig[0], f.orig[1], f.orig[2], nx, ny, nz);
+        if (f.n == 4) {
+            float qx, qy, qz;
+            triangleNormal(positions.data(), f.orig[0], f.orig[2], f.orig[3], qx, qy, qz);
+            nx += qx; ny += qy; nz += qz;
+        }
+        normalizeOrUp(nx, ny, nz);
+        faceNormals[i*3+0] = nx;
+        faceNormals[i*3+1] = ny;
+        faceNormals[i*3+2] = nz;
+    }
+    
+    // Equal edges become adjacent; the stable sort keeps the first face's slot first
+    RadixSort::sortPairs(keys, slots, 2 * idBits);
+    const uint64_t* k = keys.data();
+    const std::vector<uint32_t> runStarts = Parallel::collect<uint32_t>(totalEdges,
+        [k](size_t i) { return i == 0 || k[i] != k[i - 1]; },
+        [](size_t i) { return static_cast<uint32_t>(i); });
+    const size_t uniqueEdges = runStarts.size();
+    const int64_t uniqueCount = static_cast<int64_t>(uniqueEdges);
+    
+    // Dihedral cosine of every unique edge. Edges without exactly two faces
+    // (open borders, non-manifold seams) get -1 and are always drawn.
+    std::vector<uint32_t> orderKeys(uniqueEdges);
+    std::vector<uint32_t> order(uniqueEdges);
+    std::vector<float> edgeCos(uniqueEdges);
+    #pragma omp parallel for schedule(static)
+    for (int64_t u = 0; u < uniqueCount; ++u) {
+        const size_t begin = runStarts[u];
+        const size_t end = (u + 1 < uniqueCount) ? runStarts[u + 1] : totalEdges;
+        float c = -1.0f;
+        if (end - begin == 2) {
+            const float* n0 = &faceNormals[edgeFaces[slots[begin]] * 3];
+            const float* n1 = &faceNormals[edgeFaces[slots[begin + 1]] * 3];
+            c = std::max(-1.0f, std::min(1.0f, n0[0]*n1[0] + n0[1]*n1[1] + n0[2]*n1[2]));
+        }
+        edgeCos[u] = c;
+        // Order-preserving float -> uint32 mapping, so sharp edges (small cosine) sort first
+        uint32_t bits;
+        std::memcpy(&bits, &c, sizeof(bits));
+        orderKeys[u] = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+        order[u] = static_cast<uint32_t>(u);
+    }
+    
+    // Sharpest edges first: any feature angle selects a prefix of the line buffer
+    RadixSort::sortPairs(orderKeys, order, 32, [](uint32_t key, int shift) {
+        return (key >> shift) & 0xFF;
+    });
+    
+    mesh.lineIndices.resize(uniqueEdges * 2);
+    mesh.lineFeatureCos.resize(uniqueEdges);
+    #pragma omp parallel for schedule(static)
+    for (int64_t j = 0; j < uniqueCount; ++j) {
+        const uint32_t u = order[j];
+        const uint32_t slot = slots[runStarts[u]];
+        mesh.lineIndices[j*2+0] = edgeVerts[slot*2+0];
+        mesh.lineIndices[j*2+1] = edgeVerts[slot*2+1];
+        mesh.lineFeatureCos[j] = edgeCos[u];
+    }
+}
+
+size_t MeshProcessor::featureLineCount(const GPUMeshData& mesh, float featureAngle)
+{
+    if (featureAngle <= 0.0f) return mesh.lineFeatureCos.size();
+    
+    // Draw edges whose faces meet at featureAngle degrees or more
+    const float threshold = std::cos(featureAngle * 3.14159265358979f / 180.0f);
+    return static_cast<size_t>(
+        std::upper_bound(mesh.lineFeatureCos.begin(), mesh.lineFeatureCos.end(), threshold) - mesh.lineFeatureCos.begin());
+}
+
+std::vector<float> MeshProcessor::arrayToFloat(const DataArray& array)
+{
+    std::vector<float> values;
+    ArrayValues::withData(array, [&values](const auto* data, size_t size) {
+        values.resize(size);
+        const int64_t count = static_cast<int64_t>(size);
+        #pragma omp parallel for schedule(static)
+        for (int64_t i = 0; i < count; ++i) {
+            values[i] = static_cast<float>(data[i]);
+        }
+    });
+    return values;
+}
+
+void MeshProcessor::updateArrayNames(const UnstructuredGrid& grid)
+{
+    m_pointDataNames.clear();
+    m_cellDataNames.clear();
+    for (const auto& pair : grid.point_data) {
+        m_pointDataNames.append(QString::fromStdString(pair.first));
+    }
+    for (const auto& pair : grid.cell_data) {
+        m_cellDataNames.append(QString::fromStdString(pair.first));
+    }
+}
+
+double MeshProcessor::arrayValue(const DataArray& array, size_t tuple, int component)
+{
+    const int numComp = std::max(1, static_cast<int>(array.num_components));
+    const int comp = ArrayValues::effectiveComponent(numComp, component);
+    double value = std::numeric_limits<double>::quiet_NaN();
+    ArrayValues::withData(array, [&](const auto* data, size_t size) {
+        if ((tuple + 1) * numComp <= size) value = ArrayValues::tupleValue(data, tuple, numComp, comp);
+    });
+    return value;
+}
+
+std::vector<float> MeshProcessor::tupleValues(const DataArray& array, int component)
+{
+    const int numComp = std::max(1, static_cast<int>(array.num_components));
+    const int comp = ArrayValues::effectiveComponent(numComp, component);
+    std::vector<float> values;
+    ArrayValues::withData(array, [&](const auto* data, size_t size) {
+        const size_t tuples = std::min(static_cast<size_t>(std::max<int64_t>(array.num_tuples, 0)), size / numComp);
+        values.resize(tuples);
+        computeTupleValues(data, tuples, numComp, comp, values.data());
+    });
+    return values;
+}
+
+void MeshProcessor::scalarRange(UnstructuredGrid& grid, const DataArray& array, int component,
+                                float& min, float& max) const
+{
+    const ArraySummary& stats = ArrayStatistics::of(grid).summary(array, component);
+    if (m_scalarRange == ScalarRange::Percentile) {
+        min = static_cast<float>(stats.percentile(0.01));
+        max = static_cast<float>(stats.percentile(0.99));
+    } else {
+        min = static_cast<float>(stats.min);
+        max = static_cast<float>(stats.max);
+    }
+}
+
 void MeshProcessor::updateScalars(GPUMeshData& meshData, 
                                   const std::shared_ptr<UnstructuredGrid>& grid,
                                   const std::string& arrayName, 
-                                  bool isPointData)
+                                  bool isPointData,
+                                  int component)
 {
-    if (!grid || meshData.vertexData.empty()) return;
+    if (!grid || meshData.vertexCount == 0) return;
     
     std::shared_ptr<DataArray> dataArray;
     
@@ -399,89 +1231,41 @@ void MeshProcessor::updateScalars(GPUMeshData& meshData,
     
     if (!dataArray) return;
     
-    const int numComp = static_cast<int>(dataArray->num_components);
-    
-    // Get scalar value at tuple index (handles vectors by computing magnitude)
-    auto getScalar = [&](size_t tupleIdx) -> float {
-        if (numComp == 1) {
-            // Scalar data: direct access
-            if (dataArray->data_type == "float" && tupleIdx < dataArray->data_float.size()) {
-                return dataArray->data_float[tupleIdx];
-            } else if (dataArray->data_type == "double" && tupleIdx < dataArray->data_double.size()) {
-                return static_cast<float>(dataArray->data_double[tupleIdx]);
-            } else if (dataArray->data_type == "int" && tupleIdx < dataArray->data_int32.size()) {
-                return static_cast<float>(dataArray->data_int32[tupleIdx]);
-            }
-        } else {
-            // Vector data: compute magnitude
-            size_t baseIdx = tupleIdx * numComp;
-            float sumSq = 0.0f;
-            
-            if (dataArray->data_type == "float") {
-                for (int c = 0; c < numComp && (baseIdx + c) < dataArray->data_float.size(); ++c) {
-                    float v = dataArray->data_float[baseIdx + c];
-                    sumSq += v * v;
-                }
-            } else if (dataArray->data_type == "double") {
-                for (int c = 0; c < numComp && (baseIdx + c) < dataArray->data_double.size(); ++c) {
-                    float v = static_cast<float>(dataArray->data_double[baseIdx + c]);
-                    sumSq += v * v;
-                }
-            } else if (dataArray->data_type == "int") {
-                for (int c = 0; c < numComp && (baseIdx + c) < dataArray->data_int32.size(); ++c) {
-                    float v = static_cast<float>(dataArray->data_int32[baseIdx + c]);
-                    sumSq += v * v;
-                }
-            }
-            return std::sqrt(sumSq);
-        }
-        return 0.0f;
-    };
-    
-    // Find min/max
-    size_t numTuples = static_cast<size_t>(dataArray->num_tuples);
-    float minVal = std::numeric_limits<float>::max();
-    float maxVal = std::numeric_limits<float>::lowest();
+    QElapsedTimer timer;
+    timer.start();
     
-    for (size_t i = 0; i < numTuples; ++i) {
-        float val = getScalar(i);
-        if (val < minVal) minVal = val;
-        if (val > maxVal) maxVal = val;
-    }
+    // One value per tuple (component or magnitude); the range comes from the statistics cache
+    const std::vector<float> values = tupleValues(*dataArray, component);
     
+    float minVal, maxVal;
+    scalarRange(*grid, *dataArray, component, minVal, maxVal);
     meshData.scalarMin = minVal;
     meshData.scalarMax = maxVal;
     
     float range = maxVal - minVal;
     if (range < 1e-10f) range = 1.0f;
+    const float invRange = 1.0f / range;
     
-    const size_t stride = 7;
-    const size_t numVerts = meshData.vertexCount;
+    // Gather through the render vertex -> point/cell mapping into the scalar stream
+    const std::vector<uint32_t>& mapping = isPointData ? meshData.vertexToPointIndex : meshData.vertexToCellIndex;
+    const uint32_t* map = mapping.empty() ? nullptr : mapping.data();
+    const float* v = values.data();
+    const size_t numValues = values.size();
+    const int64_t numVerts = static_cast<int64_t>(meshData.vertexCount);
     
-    if (isPointData && !meshData.vertexToPointIndex.empty()) {
-        // Use the mapping from render vertices to original point indices
-        for (size_t v = 0; v < numVerts; ++v) {
-            uint32_t origIdx = meshData.vertexToPointIndex[v];
-            float scalar = 0.5f;
-            if (origIdx < numTuples) {
-                scalar = (getScalar(origIdx) - minVal) / range;
-            }
-            meshData.vertexData[v * stride + 6] = scalar;
-        }
-    } else if (!isPointData && !meshData.vertexToCellIndex.empty()) {
-        // Cell data: use the mapping from render vertices to cell indices
-        for (size_t v = 0; v < numVerts; ++v) {
-            uint32_t cellIdx = meshData.vertexToCellIndex[v];
-            float scalar = 0.5f;
-            if (cellIdx < numTuples) {
-                scalar = (getScalar(cellIdx) - minVal) / range;
-            }
-            meshData.vertexData[v * stride + 6] = scalar;
+    auto gather = [&](auto* out, auto encode) {
+        #pragma omp parallel for schedule(static)
+        for (int64_t i = 0; i < numVerts; ++i) {
+            const uint32_t idx = map ? map[i] : UINT32_MAX;
+            out[i] = encode((idx < numValues) ? (v[idx] - minVal) * invRange : 0.5f);
         }
+    };
+    if (meshData.vertexFormat == VertexFormat::Compact) {
+        gather(meshData.compactScalars.data(), [](float s) { return quantizeUnit(s); });
     } else {
-        // Fallback: uniform scalar
-        for (size_t v = 0; v < numVerts; ++v) {
-            meshData.vertexData[v * stride + 6] = 0.5f;
-        }
+        gather(meshData.scalarData.data(), [](float s) { return s; });
     }
+    
+    qInfo(meshProcessorLog) << "Scalar mapping" << arrayName.c_str() << values.size() << "tuples to"
+                            << meshData.vertexCount << "verts in" << timer.elapsed() << "ms";
 }
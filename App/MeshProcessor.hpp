@@ -6,37 +6,80 @@
 #include <memory>
 #include <vector>
 #include "Loader.hpp"
+#include "CellTopology.hpp"
 
-// Optimized GPU-ready mesh data with flat shading support
+// Layout of the vertex buffer handed to the GPU
+enum class VertexFormat {
+    Full,    // 6 floats: position, normal (24 bytes) + float scalar
+    Compact  // CompactVertex (12 bytes) + unorm16 scalar
+};
+
+// Quantized vertex: position as unorm16 within the bounding box, normal as
+// octahedral snorm16 pair. Decoded in the vertex shaders.
+struct CompactVertex {
+    uint16_t position[3];
+    int16_t normal[2];
+    uint16_t padding;  // Keeps the stride a multiple of 4 bytes
+};
+static_assert(sizeof(CompactVertex) == 12, "CompactVertex must stay tightly packed");
+
+// Optimized GPU-ready mesh data, flat-shaded (one vertex per triangle corner)
+// or smooth-shaded (one vertex per boundary point, indexed triangles)
 struct GPUMeshData {
-    // Interleaved vertex data: position (3) + normal (3) + scalar (1) = 7 floats per vertex
+    // Interleaved vertex data: position (3) + normal (3) = 6 floats per vertex.
+    // Only one of vertexData / compactVertices is filled, depending on vertexFormat.
+    VertexFormat vertexFormat = VertexFormat::Full;
     std::vector<float> vertexData;
+    std::vector<CompactVertex> compactVertices;
+    
+    // Normalized per-vertex scalar, a separate stream so switching arrays leaves
+    // the geometry resident (scalarData for Full, compactScalars for Compact)
+    std::vector<float> scalarData;
+    std::vector<uint16_t> compactScalars;
     std::vector<uint32_t> triangleIndices;
-    std::vector<uint32_t> lineIndices;
+    std::vector<uint32_t> lineIndices;       // Each boundary edge once, sharpest edges first
     std::vector<uint32_t> pointIndices;
     
-    // Mapping from flat-shaded vertex index to original point index
+    // Vertex and line cells (no faces), drawn in every mode from vertices appended after
+    // the surface's: line segments as index pairs, and points
+    std::vector<uint32_t> cellLineIndices;
+    std::vector<uint32_t> cellPointIndices;
+    
+    // Mapping from render vertex index to original point index
     std::vector<uint32_t> vertexToPointIndex;
     
-    // Mapping from flat-shaded vertex index to cell index (for cell data)
+    // Mapping from render vertex index to cell index (for cell data)
     std::vector<uint32_t> vertexToCellIndex;
     
+    // Cell of each triangle in triangleIndices order (gl_PrimitiveID -> cell on the GPU)
+    std::vector<uint32_t> triangleToCellIndex;
+    
+    // Triangles of connected part p: [partOffsets[p], partOffsets[p + 1]); empty unless
+    // the processor splits parts
+    std::vector<uint32_t> partOffsets;
+    
+    // Cosine of the angle between the two faces of each line, ascending.
+    // Border and non-manifold edges store -1 so they are always drawn.
+    std::vector<float> lineFeatureCos;
+    
     QVector3D boundingBoxMin;
     QVector3D boundingBoxMax;
     
     size_t vertexCount = 0;
     size_t triangleCount = 0;
-    size_t lineCount = 0;
+    size_t lineCount = 0;  // Lines drawn under the current feature angle (a prefix of lineIndices)
     
     float scalarMin = 0.0f;
     float scalarMax = 1.0f;
     
-    // Flat shading: each triangle has its own vertices
+    // Flat shading: each triangle has its own vertices.
+    // Otherwise vertices are shared and carry area-weighted normals.
     bool useFlatShading = true;
 };
 
-// Face structure for sorting-based surface extraction
-// Uses sorted indices for comparison and original indices for rendering
+// Face of a cell with its canonical (sorted) and winding-order (orig) vertex ids.
+// Only built transiently: extraction packs it into a FaceKey right away, and full
+// Face records are materialized again just for the surviving boundary faces.
 struct Face {
     uint32_t sorted[4];  // Sorted indices for canonical representation
     uint32_t orig[4];    // Original indices for correct winding order
@@ -70,65 +113,225 @@ struct Face {
         if (sorted[1] > sorted[3]) std::swap(sorted[1], sorted[3]);
         if (sorted[1] > sorted[2]) std::swap(sorted[1], sorted[2]);
     }
+};
+
+// Face packed into a single comparable 128-bit integer: quad flag, then the sorted ids,
+// each id using just enough bits for the largest point index, so keys order by vertex
+// count and then ids. When 1 + 4 * bits <= 64 a plain uint64_t with the same layout is used.
+struct FaceKey {
+    uint64_t hi;
+    uint64_t lo;
     
-    // Comparison for std::sort
-    bool operator<(const Face& other) const {
-        if (n != other.n) return n < other.n;
-        for (int i = 0; i < n; ++i) {
-            if (sorted[i] != other.sorted[i]) 
-                return sorted[i] < other.sorted[i];
-        }
-        return false;
-    }
+    bool operator==(const FaceKey& other) const { return hi == other.hi && lo == other.lo; }
+    bool operator!=(const FaceKey& other) const { return !(*this == other); }
     
-    // Equality for duplicate detection
-    bool operator==(const Face& other) const {
-        if (n != other.n) return false;
-        for (int i = 0; i < n; ++i) {
-            if (sorted[i] != other.sorted[i]) return false;
-        }
-        return true;
+    // 8-bit digit starting at bit `shift` (a multiple of 8), for radix sorting
+    uint32_t digit(int shift) const {
+        return static_cast<uint32_t>(((shift < 64) ? (lo >> shift) : (hi >> (shift - 64))) & 0xFF);
     }
 };
 
 class MeshProcessor
 {
 public:
+    // How boundary faces (faces referenced by exactly one cell) are found
+    enum class BoundaryMethod {
+        Sort,  // Sort all faces, then scan for runs of length 1
+        Hash   // Concurrent hash table, expected O(F)
+    };
+    
+    // How boundary triangles are turned into render vertices
+    enum class ShadingMode {
+        Flat,   // Three vertices per triangle with the face normal
+        Smooth  // One vertex per boundary point with an area-weighted normal
+    };
+
     MeshProcessor() = default;
     
+    void setBoundaryMethod(BoundaryMethod method) { m_boundaryMethod = method; }
+    BoundaryMethod boundaryMethod() const { return m_boundaryMethod; }
+    
+    void setShadingMode(ShadingMode mode) { m_shadingMode = mode; }
+    ShadingMode shadingMode() const { return m_shadingMode; }
+    
+    void setVertexFormat(VertexFormat format) { m_vertexFormat = format; }
+    VertexFormat vertexFormat() const { return m_vertexFormat; }
+    
+    // How the color range is derived from an array's statistics
+    enum class ScalarRange {
+        MinMax,     // Full data range
+        Percentile  // 1st to 99th percentile, robust against outliers
+    };
+    
+    void setScalarRangeMode(ScalarRange range) { m_scalarRange = range; }
+    ScalarRange scalarRangeMode() const { return m_scalarRange; }
+    
+    // Reorder indexed (smooth-shaded) triangles and vertices for the vertex cache and early-Z
+    void setOptimizeIndices(bool enabled) { m_optimizeIndices = enabled; }
+    bool optimizeIndices() const { return m_optimizeIndices; }
+    
+    // Boundary faces of quadratic cells are split through their mid-edge (and mid-face)
+    // nodes, and quadratic lines drawn through their interior nodes
+    void setSubdivideCurved(bool enabled) { m_subdivideCurved = enabled; }
+    bool subdivideCurved() const { return m_subdivideCurved; }
+    
+    // How the surface's triangles are grouped into connected parts
+    enum class PartMode {
+        None,     // One range
+        Cells,    // Cells sharing a point are one part
+        Surface   // Triangles sharing a point are one part (a hollow body splits into its shells)
+    };
+    
+    void setPartMode(PartMode mode) { m_partMode = mode; }
+    PartMode partMode() const { return m_partMode; }
+    
+    // Wireframe shows only edges whose faces meet at this angle (degrees) or more; 0 shows all
+    void setFeatureAngle(float degrees) { m_featureAngle = degrees; }
+    float featureAngle() const { return m_featureAngle; }
+    
     GPUMeshData process(const std::shared_ptr<UnstructuredGrid>& grid);
     
+    // CPU color mapping: gathers the array into the mesh's scalar stream.
+    // component < 0 uses the magnitude of vector arrays.
     void updateScalars(GPUMeshData& meshData, 
                        const std::shared_ptr<UnstructuredGrid>& grid,
                        const std::string& arrayName, 
-                       bool isPointData);
+                       bool isPointData,
+                       int component = -1);
+    
+    // Raw array as floats, components interleaved (for GPU-side lookup)
+    static std::vector<float> arrayToFloat(const DataArray& array);
+
+    // One tuple of an array (a component, or the magnitude when component < 0); NaN if out of range
+    static double arrayValue(const DataArray& array, size_t tuple, int component);
+    // All tuples of an array that way, one float each
+    static std::vector<float> tupleValues(const DataArray& array, int component);
+    
+    // Color range of one component (or the magnitude when component < 0), from the
+    // grid's cached statistics and the current ScalarRange mode
+    void scalarRange(UnstructuredGrid& grid, const DataArray& array, int component,
+                     float& min, float& max) const;
+
+    // Number of leading lines that pass the feature angle filter
+    static size_t featureLineCount(const GPUMeshData& mesh, float featureAngle);
+
+    // Distinct faces of all cells, for filters that show the boundary of a cell subset.
+    // The k-th face CellTopology::visitCellFaces() reports for cell c is slot
+    // cellSlots[c] + k; slots of cells sharing a face map to the same face id, and
+    // faceSlots lists the slots of face f in [faceSlotOffsets[f], faceSlotOffsets[f + 1]).
+    struct FaceTopology {
+        std::vector<size_t> cellOffsets;         // Start of each cell's [n, ids...] record
+        std::vector<size_t> cellSlots;           // First face slot of each cell, plus the total
+        std::vector<uint32_t> slotFaces;         // Face id of every slot
+        std::vector<uint32_t> faceSlotOffsets;   // Per face, plus the total
+        std::vector<uint32_t> faceSlots;
+        
+        size_t faceCount() const { return faceSlotOffsets.empty() ? 0 : faceSlotOffsets.size() - 1; }
+    };
+    
+    // Uses the same packed keys and radix sort as the Sort boundary method.
+    // Fails if cells reference points past numPoints or there are too many face slots.
+    static bool buildFaceTopology(const UnstructuredGrid& grid, size_t numPoints, FaceTopology& topology);
 
+    // Re-reads the array names, after arrays were added to the grid
+    void updateArrayNames(const UnstructuredGrid& grid);
     QStringList getPointDataArrayNames() const { return m_pointDataNames; }
     QStringList getCellDataArrayNames() const { return m_cellDataNames; }
 
 private:
-    enum VTKCellType {
-        VTK_VERTEX = 1,
-        VTK_POLY_VERTEX = 2,
-        VTK_LINE = 3,
-        VTK_POLY_LINE = 4,
-        VTK_TRIANGLE = 5,
-        VTK_TRIANGLE_STRIP = 6,
-        VTK_POLYGON = 7,
-        VTK_QUAD = 9,
-        VTK_TETRA = 10,
-        VTK_VOXEL = 11,
-        VTK_HEXAHEDRON = 12,
-        VTK_WEDGE = 13,
-        VTK_PYRAMID = 14
-    };
-
     void computeBoundingBox(const std::vector<float>& positions,
                             size_t numPoints,
                             QVector3D& min, QVector3D& max);
 
+    // Flattened connectivity plus the per-cell offsets needed to address it in parallel.
+    // Face slot f belongs to the last cell c with faceOffsets[c] <= f. Cells are also
+    // grouped by type, so per-cell passes run one specialized loop per type.
+    struct CellFaceIndex {
+        const int32_t* cells = nullptr;
+        const uint8_t* types = nullptr;
+        size_t numTypes = 0;
+        std::vector<size_t> cellOffsets;  // Start of each cell's [n, ids...] record
+        std::vector<size_t> faceOffsets;  // First face slot of each cell, plus the total
+        std::vector<uint32_t> typeCells;  // Cell ids grouped by type, ascending within a type
+        std::vector<size_t> typeStarts;   // Start of each of the 256 types in typeCells, plus the total
+        
+        size_t cellCount() const { return cellOffsets.size(); }
+        size_t faceCount() const { return faceOffsets.back(); }
+        uint8_t typeAt(size_t cellIdx) const {
+            return (cellIdx < numTypes) ? types[cellIdx] : static_cast<uint8_t>(CellTopology::VTK_TRIANGLE);
+        }
+    };
+    
+    static CellFaceIndex buildCellFaceIndex(const UnstructuredGrid& grid);
+    
+    // Largest point id referenced by any cell
+    static uint32_t maxPointId(const CellFaceIndex& index);
+    
+    // Packed keys of every face slot, then the slots of faces that occur exactly once
+    template<typename Key>
+    static std::vector<Key> packFaceKeys(const CellFaceIndex& index, int idBits);
+    template<typename Key>
+    std::vector<uint32_t> findBoundarySlots(std::vector<Key>& keys, int keyBits) const;
+    
+    // Re-derives the winding-order face of each slot from the cell connectivity
+    static std::vector<Face> fetchFaces(const CellFaceIndex& index, const std::vector<uint32_t>& slots);
+    
+    // Replaces the faces of quadratic cells by their pieces through the mid-edge nodes
+    static std::vector<Face> subdivideFaces(const CellFaceIndex& index, const std::vector<uint32_t>& slots,
+                                            const std::vector<Face>& faces);
+    
+    // Appends render vertices for the vertex and line cells and fills cellLineIndices /
+    // cellPointIndices; cells referencing points past numPoints are skipped
+    static void appendCellPrimitives(GPUMeshData& mesh, const CellFaceIndex& index,
+                                     const std::vector<float>& positions, size_t numPoints, bool curved);
+    
+    // Sorts the slot keys and numbers each run of equal keys as one face
+    template<typename Key>
+    static void numberFaces(std::vector<Key>& keys, int keyBits, FaceTopology& topology);
+    
+    // Fill vertex data, indices and mappings from triangulated boundary faces
+    // (3 point ids per triangle in triPoints, owning cell in triCells)
+    static void buildFlatVertices(GPUMeshData& mesh, const std::vector<float>& positions,
+                                  const std::vector<uint32_t>& triPoints,
+                                  const std::vector<uint32_t>& triCells);
+    static void buildSmoothVertices(GPUMeshData& mesh, const std::vector<float>& positions, size_t numPoints,
+                                    const std::vector<uint32_t>& triPoints,
+                                    const std::vector<uint32_t>& triCells);
+    
+    // Reorders triangles: new triangle i is old triangle order[i]. Every per-triangle
+    // table (indices, triangleToCellIndex) goes through here so they stay aligned.
+    static void permuteTriangles(GPUMeshData& mesh, const std::vector<uint32_t>& order);
+    
+    // Renumbers vertices: new vertex i is old vertex order[i]. Permutes the per-vertex
+    // streams and mappings and remaps triangle, line and point indices.
+    static void permuteVertices(GPUMeshData& mesh, const std::vector<uint32_t>& order);
+    
+    // Vertex cache / overdraw triangle order, then first-use vertex order (Full format only)
+    static void optimizeIndexOrder(GPUMeshData& mesh);
+    
+    // Groups the triangles by connected part (after index optimization) and fills partOffsets
+    void splitParts(GPUMeshData& mesh, const CellFaceIndex& index, size_t numPoints) const;
+    
+    // Quantizes vertexData into compactVertices against the bounding box and frees vertexData
+    static void packCompactVertices(GPUMeshData& mesh);
+    
+    // Deduplicated polygon edges of the boundary faces (no quad diagonals), with the
+    // dihedral cosine of each. triOffsets holds each face's first triangle.
+    static void buildEdges(GPUMeshData& mesh, const std::vector<float>& positions,
+                           const std::vector<Face>& faces, const std::vector<size_t>& triOffsets,
+                           int idBits);
+
     QStringList m_pointDataNames;
     QStringList m_cellDataNames;
+    
+    BoundaryMethod m_boundaryMethod = BoundaryMethod::Hash;
+    ShadingMode m_shadingMode = ShadingMode::Flat;
+    float m_featureAngle = 0.0f;
+    VertexFormat m_vertexFormat = VertexFormat::Compact;
+    ScalarRange m_scalarRange = ScalarRange::MinMax;
+    bool m_optimizeIndices = true;
+    bool m_subdivideCurved = false;
+    PartMode m_partMode = PartMode::None;
 };
 
 #endif // MESHPROCESSOR_HPP
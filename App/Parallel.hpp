@@ -0,0 +1,119 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif
+
+// Thin helpers around OpenMP so callers compile (serially) without it.
+// Loops stay OpenMP 2.0 compatible (signed indices, no tasks) for MSVC.
+namespace Parallel {
+
+inline int maxThreads()
+{
+#ifdef USE_OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+inline int threadIndex()
+{
+#ifdef USE_OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+// Half-open [begin, end) range of chunk `chunk` when `count` items are split into `chunks` parts
+inline void chunkRange(size_t count, int chunks, int chunk, size_t& begin, size_t& end)
+{
+    const size_t base = count / static_cast<size_t>(chunks);
+    const size_t extra = count % static_cast<size_t>(chunks);
+    const size_t c = static_cast<size_t>(chunk);
+    begin = c * base + std::min(c, extra);
+    end = begin + base + (c < extra ? 1 : 0);
+}
+
+// In-place exclusive prefix sum; returns the total.
+// Two passes over per-thread blocks: local sums, then block-offset fix-up.
+template<typename T>
+T exclusiveScan(std::vector<T>& values)
+{
+    const size_t count = values.size();
+    const int chunks = std::max(1, std::min(maxThreads(), static_cast<int>(count / 65536) + 1));
+    std::vector<T> chunkTotals(chunks + 1, T(0));
+
+    #pragma omp parallel for schedule(static, 1) num_threads(chunks)
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        size_t begin, end;
+        chunkRange(count, chunks, chunk, begin, end);
+        T sum = T(0);
+        for (size_t i = begin; i < end; ++i) {
+            T v = values[i];
+            values[i] = sum;
+            sum += v;
+        }
+        chunkTotals[chunk + 1] = sum;
+    }
+
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        chunkTotals[chunk + 1] += chunkTotals[chunk];
+    }
+
+    #pragma omp parallel for schedule(static, 1) num_threads(chunks)
+    for (int chunk = 1; chunk < chunks; ++chunk) {
+        size_t begin, end;
+        chunkRange(count, chunks, chunk, begin, end);
+        const T offset = chunkTotals[chunk];
+        for (size_t i = begin; i < end; ++i) {
+            values[i] += offset;
+        }
+    }
+
+    return chunkTotals[chunks];
+}
+
+// Returns value(i) for every i in [0, count) with keep(i), in index order.
+// Count per chunk, scan, then fill, so the output does not depend on scheduling.
+template<typename T, typename KeepFn, typename ValueFn>
+std::vector<T> collect(size_t count, KeepFn keep, ValueFn value)
+{
+    const int chunks = std::max(1, std::min(maxThreads(), static_cast<int>(count / 65536) + 1));
+    std::vector<size_t> chunkOffsets(chunks + 1, 0);
+
+    #pragma omp parallel for schedule(static, 1) num_threads(chunks)
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        size_t begin, end;
+        chunkRange(count, chunks, chunk, begin, end);
+        size_t n = 0;
+        for (size_t i = begin; i < end; ++i) {
+            if (keep(i)) ++n;
+        }
+        chunkOffsets[chunk] = n;
+    }
+    const size_t total = exclusiveScan(chunkOffsets);
+
+    std::vector<T> result(total);
+    #pragma omp parallel for schedule(static, 1) num_threads(chunks)
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        size_t begin, end;
+        chunkRange(count, chunks, chunk, begin, end);
+        size_t out = chunkOffsets[chunk];
+        for (size_t i = begin; i < end; ++i) {
+            if (keep(i)) result[out++] = value(i);
+        }
+    }
+    return result;
+}
+
+} // namespace Parallel
+
+#endif // PARALLEL_HPP
@@ -0,0 +1,82 @@
+#include "PlaneClipper.hpp"
+#include "CellTopology.hpp"
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <algorithm>
+#include <limits>
+
+Q_LOGGING_CATEGORY(planeClipperLog, "VTKViewer.PlaneClipper")
+
+void PlaneClipper::reset()
+{
+    m_order.setKeys(std::vector<float>());
+    m_orderValid = false;
+    m_changedCount = 0;
+}
+
+void PlaneClipper::setNormal(const QVector3D& normal)
+{
+    const QVector3D n = normal.normalized();
+    if (n.isNull() || n == m_normal) return;
+    m_normal = n;
+    m_orderValid = false;
+}
+
+void PlaneClipper::offsetRange(float& min, float& max)
+{
+    buildOrder();
+    min = m_order.lowest();
+    max = m_order.highest();
+}
+
+void PlaneClipper::buildOrder()
+{
+    if (m_orderValid || !m_subset.prepare()) return;
+    QElapsedTimer timer;
+    timer.start();
+
+    // Lowest point of every cell along the normal; point ids outside the positions are
+    // skipped (cells without faces never went through maxPointId), and cells left without
+    // a point get NaN and are never kept
+    const std::vector<float>& positions = m_subset.positions();
+    const std::vector<size_t>& offsets = m_subset.cellOffsets();
+    const int32_t* cells = m_subset.grid()->cells.data();
+    const uint8_t* types = m_subset.grid()->cell_types.data();
+    const int64_t numTypes = static_cast<int64_t>(m_subset.grid()->cell_types.size());
+    const uint32_t numPoints = static_cast<uint32_t>(positions.size() / 3);
+    const float nx = m_normal.x(), ny = m_normal.y(), nz = m_normal.z();
+    const int64_t numCells = static_cast<int64_t>(offsets.size());
+    std::vector<float> lowest(offsets.size());
+    #pragma omp parallel for schedule(static)
+    for (int64_t c = 0; c < numCells; ++c) {
+        const int32_t* record = cells + offsets[c];
+        float lo = std::numeric_limits<float>::quiet_NaN();
+        CellTopology::visitPointSlots(c < numTypes ? types[c] : 0, record, [&](int32_t k) {
+            if (record[k] < 0 || static_cast<uint32_t>(record[k]) >= numPoints) return;
+            const float* p = &positions[static_cast<size_t>(record[k]) * 3];
+            const float d = nx * p[0] + ny * p[1] + nz * p[2];
+            if (!(d >= lo)) lo = d;
+        });
+        lowest[c] = lo;
+    }
+
+    m_subset.clearFilter(SubsetSurface::ClipFilter);
+    m_order.setKeys(lowest);
+    qInfo(planeClipperLog) << "Clip order" << m_order.size() << "cells in" << timer.elapsed() << "ms";
+    m_orderValid = true;
+}
+
+bool PlaneClipper::clip(float offset)
+{
+    buildOrder();
+    if (!m_orderValid) return false;
+    m_changedCount = m_order.select(-std::numeric_limits<float>::infinity(), offset, m_subset,
+                                    SubsetSurface::ClipFilter);
+    return true;
+}
+
+void PlaneClipper::release()
+{
+    m_changedCount = m_subset.clearFilter(SubsetSurface::ClipFilter);
+    m_order.reset();
+}
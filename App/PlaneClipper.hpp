@@ -0,0 +1,42 @@
+#ifndef PLANECLIPPER_HPP
+#define PLANECLIPPER_HPP
+
+#include <cstddef>
+#include <QVector3D>
+#include "SubsetSurface.hpp"
+
+// Crinkle clip: rejects the whole cells that lie entirely on the side dot(normal, p) > offset,
+// through the ClipFilter bit of a SubsetSurface. Cells are sorted once per normal by their
+// lowest point along it, so the kept cells are a prefix of that order and moving the
+// plane only drops or restores the cells between the old and the new offset.
+class PlaneClipper
+{
+public:
+    explicit PlaneClipper(SubsetSurface& subset) : m_subset(subset) {}
+
+    void reset();  // After the subset's grid changed
+    void setNormal(const QVector3D& normal);  // Normalized; re-sorts the cells on the next clip
+    QVector3D normal() const { return m_normal; }
+
+    // Range of offsets between keeping the lowest cells and keeping all (min > max without cells)
+    void offsetRange(float& min, float& max);
+
+    // Moves the plane; false if the grid's cells can't be used
+    bool clip(float offset);
+
+    // Stops rejecting cells
+    void release();
+
+    size_t changedCount() const { return m_changedCount; }  // Cells flipped by the last clip()
+
+private:
+    void buildOrder();
+
+    SubsetSurface& m_subset;
+    SortedCellRange m_order;
+    QVector3D m_normal{0.0f, 0.0f, 1.0f};
+    bool m_orderValid = false;
+    size_t m_changedCount = 0;
+};
+
+#endif // PLANECLIPPER_HPP
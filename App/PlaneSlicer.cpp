@@ -0,0 +1,73 @@
+#include "PlaneSlicer.hpp"
+#include "CellTopology.hpp"
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <algorithm>
+
+Q_LOGGING_CATEGORY(planeSlicerLog, "VTKViewer.PlaneSlicer")
+
+void PlaneSlicer::setGrid(const std::shared_ptr<UnstructuredGrid>& grid)
+{
+    m_grid = grid;
+    m_cellOffsets.clear();
+    m_positions.clear();
+    m_distances.clear();
+    m_index.clear();
+    m_indexValid = false;
+    m_candidateCount = 0;
+}
+
+void PlaneSlicer::setNormal(const QVector3D& normal)
+{
+    const QVector3D n = normal.normalized();
+    if (n.isNull() || n == m_normal) return;
+    m_normal = n;
+    m_indexValid = false;
+}
+
+void PlaneSlicer::offsetRange(float& min, float& max)
+{
+    buildIndex();
+    min = m_index.lowest();
+    max = m_index.highest();
+}
+
+void PlaneSlicer::buildIndex()
+{
+    if (m_indexValid || !m_grid || !m_grid->points) return;
+    QElapsedTimer timer;
+    timer.start();
+
+    // Geometry and cell addressing are kept across normals
+    if (m_positions.empty()) {
+        const size_t numPoints = static_cast<size_t>(std::max<int64_t>(m_grid->num_points, 0));
+        m_positions = CellTopology::pointPositions(*m_grid->points, numPoints);
+        m_cellOffsets = CellTopology::cellOffsets(*m_grid);
+    }
+
+    const int64_t numPoints = static_cast<int64_t>(m_positions.size() / 3);
+    const float nx = m_normal.x(), ny = m_normal.y(), nz = m_normal.z();
+    m_distances.resize(static_cast<size_t>(numPoints));
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < numPoints; ++i) {
+        m_distances[i] = nx * m_positions[i * 3] + ny * m_positions[i * 3 + 1] + nz * m_positions[i * 3 + 2];
+    }
+
+    // Extent of every 3D cell along the normal
+    std::vector<float> mins, maxs;
+    Contour::cellRanges(*m_grid, m_cellOffsets, m_distances.data(), m_distances.size(), mins, maxs);
+    m_index.build(mins, maxs);
+    m_indexValid = true;
+    qInfo(planeSlicerLog) << "Slice index" << m_index.size() << "cells in" << timer.elapsed() << "ms";
+}
+
+ContourSurface PlaneSlicer::slice(float offset, const float* pointScalars, const float* cellScalars)
+{
+    buildIndex();
+    if (!m_indexValid) return ContourSurface();
+
+    const std::vector<uint32_t> candidates = m_index.stab(offset);
+    m_candidateCount = candidates.size();
+    return Contour::contourCells(*m_grid, m_cellOffsets, m_positions, candidates,
+                                 m_distances.data(), offset, pointScalars, cellScalars);
+}
@@ -0,0 +1,46 @@
+#ifndef PLANESLICER_HPP
+#define PLANESLICER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <QVector3D>
+#include "Contour.hpp"
+#include "IntervalIndex.hpp"
+#include "Loader.hpp"
+
+// Cuts the 3D cells of a grid with the plane dot(normal, p) == offset.
+// Setting the normal computes every point's distance along it and indexes each
+// cell's [min, max] distance; moving the plane then only contours the cells whose
+// extent contains the new offset.
+class PlaneSlicer
+{
+public:
+    void setGrid(const std::shared_ptr<UnstructuredGrid>& grid);
+    void setNormal(const QVector3D& normal);  // Normalized; rebuilds the index on the next slice
+    QVector3D normal() const { return m_normal; }
+
+    // Range of offsets that cut the indexed cells (min > max without 3D cells)
+    void offsetRange(float& min, float& max);
+
+    // Triangles facing along the normal; colors as in Contour::contourCells
+    ContourSurface slice(float offset, const float* pointScalars, const float* cellScalars);
+
+    // Cells contoured by the last slice()
+    size_t candidateCount() const { return m_candidateCount; }
+
+private:
+    void buildIndex();
+
+    std::shared_ptr<UnstructuredGrid> m_grid;
+    std::vector<size_t> m_cellOffsets;
+    std::vector<float> m_positions;
+    QVector3D m_normal{0.0f, 0.0f, 1.0f};
+    std::vector<float> m_distances;  // Per point, along m_normal
+    IntervalIndex m_index;
+    bool m_indexValid = false;
+    size_t m_candidateCount = 0;
+};
+
+#endif // PLANESLICER_HPP
@@ -0,0 +1,130 @@
+#include "PointCells.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+#include "CellTopology.hpp"
+#include "Parallel.hpp"
+
+namespace {
+
+// Calls visit(point) for each distinct, valid point of a cell record
+template<typename Visit>
+inline void forEachPoint(uint8_t type, const int32_t* record, int64_t numPoints, Visit visit)
+{
+    CellTopology::visitPointSlots(type, record, [&](int32_t k) {
+        const int32_t p = record[k];
+        if (p < 0 || p >= numPoints) return;
+        // Polyhedron points repeat across faces, so earlier slots are found by walking the
+        // faces again; other records list their ids in slots 1..n
+        bool repeated = false;
+        if (type == CellTopology::VTK_POLYHEDRON) {
+            CellTopology::visitPointSlots(type, record, [&](int32_t j) { repeated = repeated || (j < k && record[j] == p); });
+        } else {
+            for (int32_t j = 1; j < k && !repeated; ++j) repeated = (record[j] == p);
+        }
+        if (!repeated) visit(static_cast<uint32_t>(p));
+    });
+}
+
+// Post-increment; a single chunk owns every counter and skips the locked add
+inline uint32_t bump(std::atomic<uint32_t>& counter, bool shared)
+{
+    if (shared) return counter.fetch_add(1, std::memory_order_relaxed);
+    const uint32_t value = counter.load(std::memory_order_relaxed);
+    counter.store(value + 1, std::memory_order_relaxed);
+    return value;
+}
+
+} // namespace
+
+const PointCells& PointCells::of(UnstructuredGrid& grid)
+{
+    if (!grid.point_cells) {
+        grid.point_cells = std::make_shared<PointCells>(build(grid));
+    }
+    return *grid.point_cells;
+}
+
+PointCells PointCells::build(const UnstructuredGrid& grid)
+{
+    PointCells result;
+    const int64_t numPoints = std::max<int64_t>(grid.num_points, 0);
+    const size_t numCells = static_cast<size_t>(std::max<int64_t>(grid.num_cells, 0));
+    const std::vector<int32_t>& cells = grid.cells;
+    const std::vector<uint8_t>& types = grid.cell_types;
+
+    // Record offset of each chunk's first cell; a serial walk, but only chunk starts are kept
+    const int chunks = std::max(1, std::min(Parallel::maxThreads(), static_cast<int>(numCells / 65536) + 1));
+    auto chunkBegin = [numCells, chunks](int chunk) {
+        size_t begin = numCells, end = numCells;
+        if (chunk < chunks) Parallel::chunkRange(numCells, chunks, chunk, begin, end);
+        return begin;
+    };
+    std::vector<size_t> chunkCells(chunks + 1), chunkOffsets(chunks + 1);
+    {
+        int chunk = 0;
+        size_t cell = 0, offset = 0;
+        for (; cell < numCells && offset < cells.size(); ++cell) {
+            const size_t next = offset + CellTopology::recordSize(cells, offset);
+            if (next > cells.size()) break;
+            while (chunk <= chunks && chunkBegin(chunk) == cell) {
+                chunkCells[chunk] = cell;
+                chunkOffsets[chunk++] = offset;
+            }
+            offset = next;
+        }
+        // Truncated connectivity ends every remaining chunk at the last complete record
+        for (; chunk <= chunks; ++chunk) {
+            chunkCells[chunk] = cell;
+            chunkOffsets[chunk] = offset;
+        }
+    }
+
+    // Pass 1: cells per point
+    const bool shared = chunks > 1;
+    std::vector<std::atomic<uint32_t>> counts(static_cast<size_t>(numPoints));
+    #pragma omp parallel for schedule(static)
+    for (int64_t p = 0; p < numPoints; ++p) counts[p].store(0, std::memory_order_relaxed);
+    #pragma omp parallel for schedule(static, 1) num_threads(chunks)
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        size_t offset = chunkOffsets[chunk];
+        for (size_t c = chunkCells[chunk]; c < chunkCells[chunk + 1]; ++c) {
+            const uint8_t type = c < types.size() ? types[c] : 0;
+            forEachPoint(type, &cells[offset], numPoints, [&counts, shared](uint32_t p) { bump(counts[p], shared); });
+            offset += CellTopology::recordSize(cells, offset);
+        }
+    }
+
+    // Offsets by an exclusive scan of the counts; counts become scatter cursors
+    result.m_offsets.resize(static_cast<size_t>(numPoints) + 1);
+    #pragma omp parallel for schedule(static)
+    for (int64_t p = 0; p < numPoints; ++p) {
+        result.m_offsets[p] = counts[p].load(std::memory_order_relaxed);
+        counts[p].store(0, std::memory_order_relaxed);
+    }
+    result.m_offsets[numPoints] = 0;
+    const uint64_t total = Parallel::exclusiveScan(result.m_offsets);
+
+    // Pass 2: scatter, then restore ascending cell order within points shared by chunks
+    result.m_cells.resize(static_cast<size_t>(total));
+    #pragma omp parallel for schedule(static, 1) num_threads(chunks)
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        size_t offset = chunkOffsets[chunk];
+        for (size_t c = chunkCells[chunk]; c < chunkCells[chunk + 1]; ++c) {
+            const uint8_t type = c < types.size() ? types[c] : 0;
+            forEachPoint(type, &cells[offset], numPoints, [&](uint32_t p) {
+                const uint32_t slot = bump(counts[p], shared);
+                result.m_cells[result.m_offsets[p] + slot] = static_cast<uint32_t>(c);
+            });
+            offset += CellTopology::recordSize(cells, offset);
+        }
+    }
+    if (!shared) return result;
+    #pragma omp parallel for schedule(dynamic, 4096)
+    for (int64_t p = 0; p < numPoints; ++p) {
+        std::sort(result.m_cells.begin() + result.m_offsets[p], result.m_cells.begin() + result.m_offsets[p + 1]);
+    }
+    return result;
+}
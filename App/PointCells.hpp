@@ -0,0 +1,39 @@
+#ifndef POINTCELLS_HPP
+#define POINTCELLS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Loader.hpp"
+
+// Cells using each point: the reverse of the grid's cell connectivity, in CSR form.
+// Built in parallel by counting sort, with every point's cells in ascending order.
+// A cell is listed once per distinct point; point ids outside the grid are skipped.
+class PointCells
+{
+public:
+    // The grid's adjacency, built on first use. Whoever renumbers points or cells resets
+    // grid.point_cells.
+    static const PointCells& of(UnstructuredGrid& grid);
+
+    // Uncached build: count cells per point, scan, then scatter and sort each point's list
+    static PointCells build(const UnstructuredGrid& grid);
+
+    size_t pointCount() const { return m_offsets.empty() ? 0 : m_offsets.size() - 1; }
+    size_t size() const { return m_cells.size(); }  // Point-cell incidences
+
+    size_t cellCount(size_t point) const { return static_cast<size_t>(m_offsets[point + 1] - m_offsets[point]); }
+    const uint32_t* cellsBegin(size_t point) const { return m_cells.data() + m_offsets[point]; }
+    const uint32_t* cellsEnd(size_t point) const { return m_cells.data() + m_offsets[point + 1]; }
+
+    // Cells of point p: cells()[offsets()[p], offsets()[p + 1])
+    const std::vector<uint64_t>& offsets() const { return m_offsets; }
+    const std::vector<uint32_t>& cells() const { return m_cells; }
+
+private:
+    std::vector<uint64_t> m_offsets;  // pointCount() + 1
+    std::vector<uint32_t> m_cells;
+};
+
+#endif //POINTCELLS_HPP
@@ -0,0 +1,331 @@
+#include "PointWeld.hpp"
+#include "CellTopology.hpp"
+#include "MeshParts.hpp"
+#include "Parallel.hpp"
+#include "RadixSort.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace {
+
+constexpr int kAxisBits = 21;
+constexpr int64_t kAxisCells = int64_t(1) << kAxisBits;
+constexpr uint64_t kNoCell = std::numeric_limits<uint64_t>::max();  // Non-finite points
+constexpr uint32_t kEmpty = std::numeric_limits<uint32_t>::max();
+
+inline uint64_t cellKey(int64_t x, int64_t y, int64_t z)
+{
+    return static_cast<uint64_t>(x) | (static_cast<uint64_t>(y) << kAxisBits) |
+           (static_cast<uint64_t>(z) << (2 * kAxisBits));
+}
+
+// Positions in double precision, so tolerances below float resolution still work
+std::vector<double> pointCoordinates(const DataArray& points, size_t numPoints)
+{
+    const size_t numComp = static_cast<size_t>(std::max<int64_t>(points.num_components, 1));
+    std::vector<double> coords;
+    const bool isFloat = (points.data_type == "float" && points.data_float.size() >= numPoints * numComp);
+    const bool isDouble = (points.data_type == "double" && points.data_double.size() >= numPoints * numComp);
+    if (!isFloat && !isDouble) return coords;
+
+    coords.resize(numPoints * 3);
+    const int64_t count = static_cast<int64_t>(numPoints);
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < count; ++i) {
+        for (size_t axis = 0; axis < 3; ++axis) {
+            const size_t src = static_cast<size_t>(i) * numComp + axis;
+            coords[i*3 + axis] = (axis >= numComp) ? 0.0
+                               : isFloat ? static_cast<double>(points.data_float[src]) : points.data_double[src];
+        }
+    }
+    return coords;
+}
+
+// Distinct grid cell keys -> their run of sorted points, by open addressing.
+// Keys are unique, so concurrent inserts only race for empty slots.
+class CellTable
+{
+public:
+    explicit CellTable(const std::vector<uint64_t>& runKeys)
+        : m_keys(runKeys)
+    {
+        size_t capacity = 16;
+        while (capacity < runKeys.size() * 2) capacity *= 2;
+        m_mask = capacity - 1;
+        m_slots = std::vector<std::atomic<uint32_t>>(capacity);
+        const int64_t slotCount = static_cast<int64_t>(capacity);
+        #pragma omp parallel for schedule(static)
+        for (int64_t s = 0; s < slotCount; ++s) {
+            m_slots[s].store(kEmpty, std::memory_order_relaxed);
+        }
+
+        const int64_t runCount = static_cast<int64_t>(runKeys.size());
+        #pragma omp parallel for schedule(static)
+        for (int64_t run = 0; run < runCount; ++run) {
+            if (runKeys[run] == kNoCell) continue;
+            for (size_t slot = hash(runKeys[run]);; slot = (slot + 1) & m_mask) {
+                uint32_t expected = kEmpty;
+                if (m_slots[slot].compare_exchange_strong(expected, static_cast<uint32_t>(run),
+                                                          std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+        }
+    }
+
+    // Run of the cell, or kEmpty
+    uint32_t find(uint64_t key) const
+    {
+        for (size_t slot = hash(key);; slot = (slot + 1) & m_mask) {
+            const uint32_t run = m_slots[slot].load(std::memory_order_relaxed);
+            if (run == kEmpty || m_keys[run] == key) return run;
+        }
+    }
+
+private:
+    size_t hash(uint64_t key) const
+    {
+        return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & m_mask;
+    }
+
+    const std::vector<uint64_t>& m_keys;
+    std::vector<std::atomic<uint32_t>> m_slots;
+    size_t m_mask = 0;
+};
+
+// One tuple per cluster: the first member's, or the mean over all members.
+// Values past the last tuple are kept.
+template<typename T>
+void mergeValues(std::vector<T>& values, size_t components, size_t numPoints,
+                 const std::vector<uint32_t>& members, const std::vector<uint32_t>& clusterStarts, bool average)
+{
+    if (values.size() < numPoints * components) return;
+    const size_t clusters = clusterStarts.size() - 1;
+    std::vector<T> merged(clusters * components + (values.size() - numPoints * components));
+
+    const int64_t count = static_cast<int64_t>(clusters);
+    #pragma omp parallel for schedule(static)
+    for (int64_t k = 0; k < count; ++k) {
+        const uint32_t begin = clusterStarts[k];
+        const uint32_t end = clusterStarts[k + 1];
+        T* out = &merged[static_cast<size_t>(k) * components];
+        const T* first = &values[static_cast<size_t>(members[begin]) * components];
+        if (!average || end - begin == 1) {
+            std::copy(first, first + components, out);
+            continue;
+        }
+        for (size_t comp = 0; comp < components; ++comp) {
+            double sum = 0.0;
+            for (uint32_t m = begin; m < end; ++m) {
+                sum += static_cast<double>(values[static_cast<size_t>(members[m]) * components + comp]);
+            }
+            out[comp] = static_cast<T>(sum / (end - begin));
+        }
+    }
+    std::copy(values.begin() + numPoints * components, values.end(), merged.begin() + clusters * components);
+    values.swap(merged);
+}
+
+void mergeArray(DataArray& array, size_t numPoints, const std::vector<uint32_t>& members,
+                const std::vector<uint32_t>& clusterStarts, bool average)
+{
+    if (array.num_tuples != static_cast<int64_t>(numPoints)) return;
+    const size_t components = static_cast<size_t>(std::max<int64_t>(array.num_components, 1));
+    if (!array.data_float.empty()) mergeValues(array.data_float, components, numPoints, members, clusterStarts, average);
+    if (!array.data_double.empty()) mergeValues(array.data_double, components, numPoints, members, clusterStarts, average);
+    if (!array.data_int32.empty()) mergeValues(array.data_int32, components, numPoints, members, clusterStarts, false);
+    if (!array.data_int64.empty()) mergeValues(array.data_int64, components, numPoints, members, clusterStarts, false);
+    array.num_tuples = static_cast<int64_t>(clusterStarts.size() - 1);
+}
+
+} // namespace
+
+namespace PointWeld {
+
+size_t weld(UnstructuredGrid& grid, double relativeTolerance)
+{
+    if (!grid.points || grid.num_points <= 1 || grid.points->num_tuples != grid.num_points ||
+        grid.num_points > static_cast<int64_t>(std::numeric_limits<uint32_t>::max()) || !(relativeTolerance >= 0.0)) {
+        return 0;
+    }
+    const size_t numPoints = static_cast<size_t>(grid.num_points);
+    const std::vector<double> coords = pointCoordinates(*grid.points, numPoints);
+    if (coords.empty()) return 0;
+    const int64_t count = static_cast<int64_t>(numPoints);
+
+    // Bounding box of the finite points, per-chunk partials
+    const int chunks = std::max(1, std::min(Parallel::maxThreads(), static_cast<int>(numPoints / 65536) + 1));
+    std::vector<double> chunkMin(static_cast<size_t>(chunks) * 3, std::numeric_limits<double>::max());
+    std::vector<double> chunkMax(static_cast<size_t>(chunks) * 3, std::numeric_limits<double>::lowest());
+    #pragma omp parallel for schedule(static, 1) num_threads(chunks)
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        size_t begin, end;
+        Parallel::chunkRange(numPoints, chunks, chunk, begin, end);
+        for (size_t i = begin; i < end; ++i) {
+            if (!std::isfinite(coords[i*3]) || !std::isfinite(coords[i*3 + 1]) || !std::isfinite(coords[i*3 + 2])) continue;
+            for (int axis = 0; axis < 3; ++axis) {
+                chunkMin[chunk*3 + axis] = std::min(chunkMin[chunk*3 + axis], coords[i*3 + axis]);
+                chunkMax[chunk*3 + axis] = std::max(chunkMax[chunk*3 + axis], coords[i*3 + axis]);
+            }
+        }
+    }
+    double boxMin[3], diagonal2 = 0.0, extent = 0.0;
+    bool anyFinite = true;
+    for (int axis = 0; axis < 3; ++axis) {
+        double lo = std::numeric_limits<double>::max();
+        double hi = std::numeric_limits<double>::lowest();
+        for (int chunk = 0; chunk < chunks; ++chunk) {
+            lo = std::min(lo, chunkMin[chunk*3 + axis]);
+            hi = std::max(hi, chunkMax[chunk*3 + axis]);
+        }
+        if (lo > hi) anyFinite = false;
+        boxMin[axis] = lo;
+        extent = std::max(extent, hi - lo);
+        diagonal2 += (hi - lo) * (hi - lo);
+    }
+    if (!anyFinite) return 0;
+
+    // Cells at least as wide as the tolerance, so close pairs are in neighbouring cells;
+    // wider when the box would need more than 2^21 cells per axis
+    const double tolerance = relativeTolerance * std::sqrt(diagonal2);
+    const double tolerance2 = tolerance * tolerance;
+    double cellSize = std::max(tolerance, extent / static_cast<double>(kAxisCells - 1));
+    if (!(cellSize > 0.0)) cellSize = 1.0;
+    const double invCell = 1.0 / cellSize;
+
+    std::vector<uint64_t> keys(numPoints);
+    std::vector<uint32_t> sorted(numPoints);
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < count; ++i) {
+        int64_t q[3];
+        bool finite = true;
+        for (int axis = 0; axis < 3; ++axis) {
+            const double t = (coords[i*3 + axis] - boxMin[axis]) * invCell;
+            finite = finite && std::isfinite(t);
+            q[axis] = finite ? std::min<int64_t>(std::max<int64_t>(static_cast<int64_t>(t), 0), kAxisCells - 1) : 0;
+        }
+        keys[i] = finite ? cellKey(q[0], q[1], q[2]) : kNoCell;
+        sorted[i] = static_cast<uint32_t>(i);
+    }
+    RadixSort::sortPairs(keys, sorted, 64);
+
+    // Runs of points sharing a cell
+    std::vector<uint32_t> runStarts = Parallel::collect<uint32_t>(
+        numPoints,
+        [&keys](size_t i) { return i == 0 || keys[i] != keys[i - 1]; },
+        [](size_t i) { return static_cast<uint32_t>(i); });
+    std::vector<uint64_t> runKeys(runStarts.size());
+    const int64_t runCount = static_cast<int64_t>(runStarts.size());
+    #pragma omp parallel for schedule(static)
+    for (int64_t run = 0; run < runCount; ++run) {
+        runKeys[run] = keys[runStarts[run]];
+    }
+    runStarts.push_back(static_cast<uint32_t>(numPoints));
+    const CellTable table(runKeys);
+
+    // Every close pair is joined once, from its lower point id; the point's own run is
+    // found again through the table since the sort moved it
+    MeshParts::PointForest forest(numPoints);
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (int64_t i = 0; i < count; ++i) {
+        const uint64_t key = keys[i];
+        if (key == kNoCell) continue;
+        const uint32_t p = sorted[i];
+        const int64_t cx = static_cast<int64_t>(key & (kAxisCells - 1));
+        const int64_t cy = static_cast<int64_t>((key >> kAxisBits) & (kAxisCells - 1));
+        const int64_t cz = static_cast<int64_t>(key >> (2 * kAxisBits));
+        for (int64_t z = std::max<int64_t>(cz - 1, 0); z <= std::min(cz + 1, kAxisCells - 1); ++z) {
+            for (int64_t y = std::max<int64_t>(cy - 1, 0); y <= std::min(cy + 1, kAxisCells - 1); ++y) {
+                for (int64_t x = std::max<int64_t>(cx - 1, 0); x <= std::min(cx + 1, kAxisCells - 1); ++x) {
+                    const uint32_t run = table.find(cellKey(x, y, z));
+                    if (run == kEmpty) continue;
+                    for (uint32_t j = runStarts[run]; j < runStarts[run + 1]; ++j) {
+                        const uint32_t q = sorted[j];
+                        if (q <= p) continue;
+                        const double dx = coords[q*3ull] - coords[p*3ull];
+                        const double dy = coords[q*3ull + 1] - coords[p*3ull + 1];
+                        const double dz = coords[q*3ull + 2] - coords[p*3ull + 2];
+                        if (dx*dx + dy*dy + dz*dz <= tolerance2) forest.unite(p, q);
+                    }
+                }
+            }
+        }
+    }
+
+    // Clusters are numbered by their lowest point, which is also their root
+    std::vector<uint32_t> roots(numPoints);
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < count; ++i) {
+        roots[i] = forest.find(static_cast<uint32_t>(i));
+    }
+    const std::vector<uint32_t> kept = Parallel::collect<uint32_t>(
+        numPoints,
+        [&roots](size_t i) { return roots[i] == i; },
+        [](size_t i) { return static_cast<uint32_t>(i); });
+    const size_t merged = numPoints - kept.size();
+    if (merged == 0) return 0;
+
+    std::vector<uint32_t> pointMap(numPoints);
+    const int64_t keptCount = static_cast<int64_t>(kept.size());
+    #pragma omp parallel for schedule(static)
+    for (int64_t k = 0; k < keptCount; ++k) {
+        pointMap[kept[k]] = static_cast<uint32_t>(k);
+    }
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < count; ++i) {
+        if (roots[i] != static_cast<uint32_t>(i)) pointMap[i] = pointMap[roots[i]];
+    }
+
+    // Members of each cluster in ascending id order, the root first
+    std::vector<uint32_t> clusterKeys = pointMap;
+    std::vector<uint32_t> members(numPoints);
+    std::iota(members.begin(), members.end(), 0u);
+    int clusterBits = 1;
+    while (clusterBits < 32 && ((kept.size() - 1) >> clusterBits) != 0) ++clusterBits;
+    RadixSort::sortPairs(clusterKeys, members, clusterBits,
+                         [](uint32_t key, int shift) { return (key >> shift) & 0xFFu; });
+    std::vector<uint32_t> clusterStarts = Parallel::collect<uint32_t>(
+        numPoints,
+        [&clusterKeys](size_t i) { return i == 0 || clusterKeys[i] != clusterKeys[i - 1]; },
+        [](size_t i) { return static_cast<uint32_t>(i); });
+    clusterStarts.push_back(static_cast<uint32_t>(numPoints));
+
+    // Ids outside [0, num_points) are left alone; MeshProcessor rejects them later
+    const std::vector<size_t> offsets = CellTopology::cellOffsets(grid);
+    const int64_t cellCount = static_cast<int64_t>(offsets.size());
+    int32_t* cells = grid.cells.data();
+    #pragma omp parallel for schedule(static)
+    for (int64_t cellIdx = 0; cellIdx < cellCount; ++cellIdx) {
+        int32_t* c = &cells[offsets[cellIdx]];
+        const uint8_t type = static_cast<size_t>(cellIdx) < grid.cell_types.size() ? grid.cell_types[cellIdx] : 0;
+        CellTopology::visitPointSlots(type, c, [c, count, &pointMap](int32_t k) {
+            if (c[k] >= 0 && c[k] < count) c[k] = static_cast<int32_t>(pointMap[c[k]]);
+        });
+    }
+
+    // Positions stay on the cluster's lowest point; the data is combined
+    mergeArray(*grid.points, numPoints, members, clusterStarts, false);
+    for (auto& pair : grid.point_data) {
+        if (pair.second) mergeArray(*pair.second, numPoints, members, clusterStarts, true);
+    }
+
+    if (grid.original_point_ids.size() == numPoints) {
+        std::vector<uint32_t> originalIds(kept.size());
+        #pragma omp parallel for schedule(static)
+        for (int64_t k = 0; k < keptCount; ++k) {
+            originalIds[k] = grid.original_point_ids[kept[k]];
+        }
+        grid.original_point_ids.swap(originalIds);
+    } else {
+        grid.original_point_ids = kept;
+    }
+    grid.num_points = static_cast<int64_t>(kept.size());
+    grid.statistics.reset();
+    grid.point_cells.reset();
+    return merged;
+}
+
+} // namespace PointWeld
@@ -0,0 +1,24 @@
+#ifndef POINTWELD_HPP
+#define POINTWELD_HPP
+
+#include <cstddef>
+#include "Loader.hpp"
+
+// Merges coincident points, for exporters that write the coordinates of shared points
+// once per element (which hides the shared faces from MeshProcessor's face matching).
+// Close pairs are found through a spatial hash whose cells are at least the tolerance
+// wide, and joined in a concurrent union-find, so a chain of close points becomes one.
+// Each cluster keeps the coordinates of its lowest point id; floating-point point arrays
+// are averaged over the cluster, integer arrays keep the lowest id's value.
+// Connectivity is remapped (cells that collapse are kept as they are), original point
+// ids are composed, and the cached statistics and point-cell adjacency are dropped.
+namespace PointWeld {
+
+// relativeTolerance is a fraction of the bounding box diagonal; 0 merges identical
+// coordinates only. Returns the number of points removed; the grid is left untouched
+// when nothing merges or it is inconsistent.
+size_t weld(UnstructuredGrid& grid, double relativeTolerance);
+
+} // namespace PointWeld
+
+#endif // POINTWELD_HPP
@@ -0,0 +1,93 @@
+#ifndef RADIXSORT_HPP
+#define RADIXSORT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "Parallel.hpp"
+
+// Parallel, stable LSD radix sort with 8-bit digits.
+// Every pass builds per-thread digit histograms, turns them into scatter offsets
+// (digit-major, thread-minor, which keeps the sort stable) and scatters in parallel.
+// Passes whose digit is identical for all keys are skipped.
+namespace RadixSort {
+
+// Sorts `keys` and permutes `values` alongside. Only the low `keyBits` bits are compared.
+// digitOf(key, shift) must return (key >> shift) & 0xFF for the packed key type.
+template<typename Key, typename Value, typename DigitFn>
+void sortPairs(std::vector<Key>& keys, std::vector<Value>& values, int keyBits, DigitFn digitOf)
+{
+    const size_t count = keys.size();
+    if (count < 2) return;
+
+    const int chunks = std::max(1, std::min(Parallel::maxThreads(), static_cast<int>(count / 65536) + 1));
+    std::vector<size_t> offsets(static_cast<size_t>(chunks) * 256);
+    std::vector<Key> keysTmp(count);
+    std::vector<Value> valuesTmp(count);
+
+    for (int shift = 0; shift < keyBits; shift += 8) {
+        #pragma omp parallel for schedule(static, 1) num_threads(chunks)
+        for (int chunk = 0; chunk < chunks; ++chunk) {
+            size_t begin, end;
+            Parallel::chunkRange(count, chunks, chunk, begin, end);
+            size_t* hist = &offsets[static_cast<size_t>(chunk) * 256];
+            for (int d = 0; d < 256; ++d) hist[d] = 0;
+            for (size_t i = begin; i < end; ++i) {
+                ++hist[digitOf(keys[i], shift)];
+            }
+        }
+
+        // Exclusive scan in digit-major order; detect passes that would not move anything
+        size_t running = 0;
+        bool trivial = false;
+        for (int d = 0; d < 256; ++d) {
+            size_t digitTotal = 0;
+            for (int chunk = 0; chunk < chunks; ++chunk) {
+                size_t& slot = offsets[static_cast<size_t>(chunk) * 256 + d];
+                const size_t n = slot;
+                slot = running;
+                running += n;
+                digitTotal += n;
+            }
+            if (digitTotal == count) trivial = true;
+        }
+        if (trivial) continue;
+
+        #pragma omp parallel for schedule(static, 1) num_threads(chunks)
+        for (int chunk = 0; chunk < chunks; ++chunk) {
+            size_t begin, end;
+            Parallel::chunkRange(count, chunks, chunk, begin, end);
+            size_t* cursor = &offsets[static_cast<size_t>(chunk) * 256];
+            for (size_t i = begin; i < end; ++i) {
+                const size_t pos = cursor[digitOf(keys[i], shift)]++;
+                keysTmp[pos] = keys[i];
+                valuesTmp[pos] = values[i];
+            }
+        }
+
+        keys.swap(keysTmp);
+        values.swap(valuesTmp);
+    }
+}
+
+// Maps a float to an unsigned key with the same order (negative values flipped)
+inline uint32_t floatKey(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+// Convenience overload for plain 64-bit keys
+template<typename Value>
+void sortPairs(std::vector<uint64_t>& keys, std::vector<Value>& values, int keyBits = 64)
+{
+    sortPairs(keys, values, keyBits, [](uint64_t key, int shift) {
+        return static_cast<uint32_t>((key >> shift) & 0xFF);
+    });
+}
+
+} // namespace RadixSort
+
+#endif // RADIXSORT_HPP
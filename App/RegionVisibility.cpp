@@ -0,0 +1,103 @@
+#include "RegionVisibility.hpp"
+#include "Parallel.hpp"
+#include "RadixSort.hpp"
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <algorithm>
+#include <cmath>
+
+Q_LOGGING_CATEGORY(regionVisibilityLog, "VTKViewer.RegionVisibility")
+
+namespace {
+
+// Rounded id; adding zero folds -0 into 0 so both land in one region
+float roundedId(float value)
+{
+    return std::nearbyint(value) + 0.0f;
+}
+
+} // namespace
+
+void RegionVisibility::reset()
+{
+    m_regions.clear();
+    m_offsets.assign(1, 0);
+    m_cells.clear();
+    m_visible.clear();
+    m_numCells = 0;
+    m_interfaces = false;
+    m_changedCount = 0;
+}
+
+void RegionVisibility::setIds(const std::vector<float>& values)
+{
+    QElapsedTimer timer;
+    timer.start();
+    release();
+
+    // Cells sorted by their rounded id; the sort is stable, so each region lists its
+    // cells in ascending order
+    m_numCells = values.size();
+    m_cells = Parallel::collect<uint32_t>(values.size(),
+        [&values](size_t c) { return !std::isnan(values[c]); },
+        [](size_t c) { return static_cast<uint32_t>(c); });
+    const int64_t count = static_cast<int64_t>(m_cells.size());
+    std::vector<uint32_t> keys(m_cells.size());
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < count; ++i) {
+        keys[i] = RadixSort::floatKey(roundedId(values[m_cells[i]]));
+    }
+    RadixSort::sortPairs(keys, m_cells, 32, [](uint32_t key, int shift) { return (key >> shift) & 0xFF; });
+
+    // One region per run of equal keys
+    m_offsets = Parallel::collect<size_t>(m_cells.size(),
+        [&keys](size_t i) { return i == 0 || keys[i] != keys[i - 1]; },
+        [](size_t i) { return i; });
+    m_regions.resize(m_offsets.size());
+    for (size_t r = 0; r < m_offsets.size(); ++r) {
+        m_regions[r] = roundedId(values[m_cells[m_offsets[r]]]);
+    }
+    m_offsets.push_back(m_cells.size());
+    m_visible.assign(m_regions.size(), 1);
+    qInfo(regionVisibilityLog) << m_regions.size() << "regions over" << m_cells.size() << "cells in"
+                               << timer.elapsed() << "ms";
+}
+
+bool RegionVisibility::setVisible(size_t region, bool visible)
+{
+    m_changedCount = 0;
+    if (region >= m_regions.size() || !m_subset.prepare()) return false;
+    if ((m_visible[region] != 0) == visible) return true;
+    m_visible[region] = visible ? 1 : 0;
+    m_changedCount = m_subset.setRejected(m_cells.data() + m_offsets[region], regionSize(region),
+                                          SubsetSurface::RegionFilter, !visible);
+    return true;
+}
+
+void RegionVisibility::setInterfaces(bool enabled)
+{
+    m_interfaces = enabled;
+    if (!enabled || m_regions.empty()) {
+        m_subset.setInterfaceLabels(std::vector<uint32_t>());
+        return;
+    }
+
+    // Cells outside every region share one label past the last region
+    std::vector<uint32_t> labels(m_numCells, static_cast<uint32_t>(m_regions.size()));
+    const int64_t regions = static_cast<int64_t>(m_regions.size());
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (int64_t r = 0; r < regions; ++r) {
+        for (size_t i = m_offsets[r]; i < m_offsets[r + 1]; ++i) {
+            labels[m_cells[i]] = static_cast<uint32_t>(r);
+        }
+    }
+    m_subset.setInterfaceLabels(std::move(labels));
+}
+
+void RegionVisibility::release()
+{
+    m_changedCount = m_subset.clearFilter(SubsetSurface::RegionFilter);
+    if (m_interfaces) m_subset.setInterfaceLabels(std::vector<uint32_t>());
+    m_interfaces = false;
+    std::fill(m_visible.begin(), m_visible.end(), 1);
+}
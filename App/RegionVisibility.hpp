@@ -0,0 +1,51 @@
+#ifndef REGIONVISIBILITY_HPP
+#define REGIONVISIBILITY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "SubsetSurface.hpp"
+
+// Shows or hides the regions (materials, blocks) named by an integer cell array, through
+// the RegionFilter bit of a SubsetSurface. Cells are grouped by id once per array, so
+// toggling a region only touches that region's cells and the faces around them.
+class RegionVisibility
+{
+public:
+    explicit RegionVisibility(SubsetSurface& subset) : m_subset(subset) {}
+
+    void reset();  // After the subset's grid changed; drops the regions
+
+    // One id per cell, rounded to an integer; NaN cells belong to no region and stay shown.
+    // Every region starts out visible.
+    void setIds(const std::vector<float>& values);
+
+    size_t regionCount() const { return m_regions.size(); }
+    float regionId(size_t region) const { return m_regions[region]; }
+    size_t regionSize(size_t region) const { return m_offsets[region + 1] - m_offsets[region]; }
+    bool isVisible(size_t region) const { return region < m_visible.size() && m_visible[region] != 0; }
+
+    // Returns false if the grid's cells can't be used
+    bool setVisible(size_t region, bool visible);
+
+    // Also shows the faces between visible cells of different regions
+    void setInterfaces(bool enabled);
+    bool interfaces() const { return m_interfaces; }
+
+    // Shows every region again and drops the interfaces
+    void release();
+
+    size_t changedCount() const { return m_changedCount; }  // Cells flipped by the last setVisible()
+
+private:
+    SubsetSurface& m_subset;
+    std::vector<float> m_regions;     // Sorted ids
+    std::vector<size_t> m_offsets;    // Cells of region r: m_cells[m_offsets[r], m_offsets[r + 1])
+    std::vector<uint32_t> m_cells;
+    std::vector<uint8_t> m_visible;
+    size_t m_numCells = 0;
+    bool m_interfaces = false;
+    size_t m_changedCount = 0;
+};
+
+#endif // REGIONVISIBILITY_HPP
@@ -0,0 +1,249 @@
+#include "SpatialReorder.hpp"
+#include "CellTopology.hpp"
+#include "Parallel.hpp"
+#include "RadixSort.hpp"
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace {
+
+constexpr int kAxisBits = 16;
+
+// Inserts two zero bits after each of the low 21 bits of v
+uint64_t spreadBits(uint64_t v)
+{
+    v &= 0x1FFFFF;
+    v = (v | (v << 32)) & 0x1F00000000FFFFull;
+    v = (v | (v << 16)) & 0x1F0000FF0000FFull;
+    v = (v | (v << 8)) & 0x100F00F00F00F00Full;
+    v = (v | (v << 4)) & 0x10C30C30C30C30C3ull;
+    v = (v | (v << 2)) & 0x1249249249249249ull;
+    return v;
+}
+
+// Quantizes positions into the bounding box and returns one Morton key per point
+std::vector<uint64_t> pointKeys(const std::vector<float>& positions, float boxMin[3], float scale[3])
+{
+    const int64_t count = static_cast<int64_t>(positions.size() / 3);
+    std::vector<uint64_t> keys(static_cast<size_t>(count));
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < count; ++i) {
+        uint32_t q[3];
+        for (int axis = 0; axis < 3; ++axis) {
+            const float t = (positions[i*3 + axis] - boxMin[axis]) * scale[axis];
+            q[axis] = static_cast<uint32_t>(std::min(std::max(t, 0.0f), 65535.0f));
+        }
+        keys[i] = SpatialReorder::mortonCode(q[0], q[1], q[2]);
+    }
+    return keys;
+}
+
+// Gathers tuples: new tuple i = old tuple order[i]. Values past the last tuple are kept.
+template<typename T>
+void permuteValues(std::vector<T>& values, size_t components, const std::vector<uint32_t>& order)
+{
+    if (values.size() < order.size() * components) return;
+
+    std::vector<T> permuted(values.size());
+    const int64_t count = static_cast<int64_t>(order.size());
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < count; ++i) {
+        const T* src = &values[static_cast<size_t>(order[i]) * components];
+        std::copy(src, src + components, &permuted[static_cast<size_t>(i) * components]);
+    }
+    std::copy(values.begin() + order.size() * components, values.end(),
+              permuted.begin() + order.size() * components);
+    values.swap(permuted);
+}
+
+void permuteArray(DataArray& array, const std::vector<uint32_t>& order)
+{
+    if (array.num_tuples != static_cast<int64_t>(order.size())) return;
+    const size_t components = static_cast<size_t>(std::max<int64_t>(array.num_components, 1));
+    if (!array.data_float.empty()) permuteValues(array.data_float, components, order);
+    if (!array.data_double.empty()) permuteValues(array.data_double, components, order);
+    if (!array.data_int32.empty()) permuteValues(array.data_int32, components, order);
+    if (!array.data_int64.empty()) permuteValues(array.data_int64, components, order);
+}
+
+// Keeps the mapping to the ids of the file when a grid is reordered more than once
+void composeOriginalIds(std::vector<uint32_t>& originalIds, const std::vector<uint32_t>& order)
+{
+    if (originalIds.size() != order.size()) {
+        originalIds = order;
+        return;
+    }
+    std::vector<uint32_t> composed(order.size());
+    const int64_t count = static_cast<int64_t>(order.size());
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < count; ++i) {
+        composed[i] = originalIds[order[i]];
+    }
+    originalIds.swap(composed);
+}
+
+void permuteGrid(UnstructuredGrid& grid, const std::vector<size_t>& offsets,
+                 const std::vector<uint32_t>& pointOrder, const std::vector<uint32_t>& cellOrder)
+{
+    const int64_t cellCount = static_cast<int64_t>(offsets.size());
+
+    if (!pointOrder.empty()) {
+        const int64_t numPoints = static_cast<int64_t>(pointOrder.size());
+        std::vector<uint32_t> oldToNew(pointOrder.size());
+        #pragma omp parallel for schedule(static)
+        for (int64_t i = 0; i < numPoints; ++i) {
+            oldToNew[pointOrder[i]] = static_cast<uint32_t>(i);
+        }
+
+        // Ids outside [0, num_points) are left alone; MeshProcessor rejects them later
+        // (polyhedron face counts and sizes are not ids and stay as they are)
+        int32_t* cells = grid.cells.data();
+        #pragma omp parallel for schedule(static)
+        for (int64_t cellIdx = 0; cellIdx < cellCount; ++cellIdx) {
+            int32_t* c = &cells[offsets[cellIdx]];
+            const uint8_t type = static_cast<size_t>(cellIdx) < grid.cell_types.size() ? grid.cell_types[cellIdx] : 0;
+            CellTopology::visitPointSlots(type, c, [c, numPoints, &oldToNew](int32_t k) {
+                if (c[k] >= 0 && c[k] < numPoints) c[k] = static_cast<int32_t>(oldToNew[c[k]]);
+            });
+        }
+
+        permuteArray(*grid.points, pointOrder);
+        for (auto& pair : grid.point_data) {
+            if (pair.second) permuteArray(*pair.second, pointOrder);
+        }
+        composeOriginalIds(grid.original_point_ids, pointOrder);
+    }
+
+    if (!cellOrder.empty()) {
+        // New record starts from the sizes of the cells in their new order
+        std::vector<size_t> newOffsets(offsets.size() + 1, 0);
+        #pragma omp parallel for schedule(static)
+        for (int64_t cellIdx = 0; cellIdx < cellCount; ++cellIdx) {
+            newOffsets[cellIdx] = CellTopology::recordSize(grid.cells, offsets[cellOrder[cellIdx]]);
+        }
+        const size_t total = Parallel::exclusiveScan(newOffsets);
+
+        const size_t tail = offsets.empty() ? 0 : offsets.back() + CellTopology::recordSize(grid.cells, offsets.back());
+        std::vector<int32_t> cells(total + (grid.cells.size() - tail));
+        #pragma omp parallel for schedule(static)
+        for (int64_t cellIdx = 0; cellIdx < cellCount; ++cellIdx) {
+            const int32_t* src = &grid.cells[offsets[cellOrder[cellIdx]]];
+            std::copy(src, src + (newOffsets[cellIdx + 1] - newOffsets[cellIdx]), &cells[newOffsets[cellIdx]]);
+        }
+        if (tail < grid.cells.size()) {
+            std::copy(grid.cells.begin() + tail, grid.cells.end(), cells.begin() + total);
+        }
+        grid.cells.swap(cells);
+
+        permuteValues(grid.cell_types, 1, cellOrder);
+        for (auto& pair : grid.cell_data) {
+            if (pair.second) permuteArray(*pair.second, cellOrder);
+        }
+        composeOriginalIds(grid.original_cell_ids, cellOrder);
+    }
+
+    // Summaries are keyed by array and would still be valid, but sampled quantiles depend on order
+    grid.statistics.reset();
+    grid.point_cells.reset();
+}
+
+} // namespace
+
+namespace SpatialReorder {
+
+uint64_t mortonCode(uint32_t x, uint32_t y, uint32_t z)
+{
+    return spreadBits(x) | (spreadBits(y) << 1) | (spreadBits(z) << 2);
+}
+
+bool reorder(UnstructuredGrid& grid)
+{
+    if (!grid.points || grid.num_points <= 0 || grid.points->num_tuples != grid.num_points ||
+        grid.num_points > static_cast<int64_t>(std::numeric_limits<uint32_t>::max())) {
+        return false;
+    }
+    const size_t numPoints = static_cast<size_t>(grid.num_points);
+    const std::vector<float> positions = CellTopology::pointPositions(*grid.points, numPoints);
+    if (positions.empty()) return false;
+
+    // Bounding box, per-chunk partials
+    const int chunks = std::max(1, std::min(Parallel::maxThreads(), static_cast<int>(numPoints / 65536) + 1));
+    std::vector<float> chunkMin(static_cast<size_t>(chunks) * 3, std::numeric_limits<float>::max());
+    std::vector<float> chunkMax(static_cast<size_t>(chunks) * 3, std::numeric_limits<float>::lowest());
+    #pragma omp parallel for schedule(static, 1) num_threads(chunks)
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        size_t begin, end;
+        Parallel::chunkRange(numPoints, chunks, chunk, begin, end);
+        for (size_t i = begin; i < end; ++i) {
+            for (int axis = 0; axis < 3; ++axis) {
+                chunkMin[chunk*3 + axis] = std::min(chunkMin[chunk*3 + axis], positions[i*3 + axis]);
+                chunkMax[chunk*3 + axis] = std::max(chunkMax[chunk*3 + axis], positions[i*3 + axis]);
+            }
+        }
+    }
+    float boxMin[3], scale[3];
+    for (int axis = 0; axis < 3; ++axis) {
+        float lo = std::numeric_limits<float>::max();
+        float hi = std::numeric_limits<float>::lowest();
+        for (int chunk = 0; chunk < chunks; ++chunk) {
+            lo = std::min(lo, chunkMin[chunk*3 + axis]);
+            hi = std::max(hi, chunkMax[chunk*3 + axis]);
+        }
+        boxMin[axis] = lo;
+        scale[axis] = (hi > lo) ? 65535.0f / (hi - lo) : 0.0f;
+    }
+
+    // Points along the curve
+    std::vector<uint64_t> keys = pointKeys(positions, boxMin, scale);
+    std::vector<uint32_t> pointOrder(numPoints);
+    std::iota(pointOrder.begin(), pointOrder.end(), 0u);
+    RadixSort::sortPairs(keys, pointOrder, 3 * kAxisBits);
+
+    // Cells along the curve by centroid, only if types and connectivity agree on the count
+    const std::vector<size_t> offsets = CellTopology::cellOffsets(grid);
+    std::vector<uint32_t> cellOrder;
+    const bool cellsConsistent = static_cast<int64_t>(offsets.size()) == grid.num_cells &&
+                                 (grid.cell_types.empty() || grid.cell_types.size() == offsets.size()) &&
+                                 offsets.size() <= std::numeric_limits<uint32_t>::max();
+    if (cellsConsistent && !offsets.empty()) {
+        const int64_t cellCount = static_cast<int64_t>(offsets.size());
+        std::vector<float> centroids(offsets.size() * 3);
+        #pragma omp parallel for schedule(static)
+        for (int64_t cellIdx = 0; cellIdx < cellCount; ++cellIdx) {
+            const int32_t* c = &grid.cells[offsets[cellIdx]];
+            float sum[3] = {0.0f, 0.0f, 0.0f};
+            int valid = 0;
+            const uint8_t type = grid.cell_types.empty() ? 0 : grid.cell_types[cellIdx];
+            CellTopology::visitPointSlots(type, c, [&](int32_t k) {
+                if (c[k] < 0 || static_cast<size_t>(c[k]) >= numPoints) return;
+                for (int axis = 0; axis < 3; ++axis) sum[axis] += positions[static_cast<size_t>(c[k])*3 + axis];
+                ++valid;
+            });
+            for (int axis = 0; axis < 3; ++axis) {
+                centroids[cellIdx*3 + axis] = valid ? sum[axis] / valid : boxMin[axis];
+            }
+        }
+
+        std::vector<uint64_t> cellKeys = pointKeys(centroids, boxMin, scale);
+        cellOrder.resize(offsets.size());
+        std::iota(cellOrder.begin(), cellOrder.end(), 0u);
+        RadixSort::sortPairs(cellKeys, cellOrder, 3 * kAxisBits);
+    }
+
+    permuteGrid(grid, offsets, pointOrder, cellOrder);
+    return true;
+}
+
+void applyPermutation(UnstructuredGrid& grid,
+                      const std::vector<uint32_t>& pointOrder,
+                      const std::vector<uint32_t>& cellOrder)
+{
+    const std::vector<size_t> offsets = CellTopology::cellOffsets(grid);
+    const bool pointsMatch = pointOrder.empty() || static_cast<int64_t>(pointOrder.size()) == grid.num_points;
+    const bool cellsMatch = cellOrder.empty() || cellOrder.size() == offsets.size();
+    if (!pointsMatch || !cellsMatch) return;
+    permuteGrid(grid, offsets, pointOrder, cellOrder);
+}
+
+} // namespace SpatialReorder
@@ -0,0 +1,30 @@
+#ifndef SPATIALREORDER_HPP
+#define SPATIALREORDER_HPP
+
+#include <cstdint>
+#include <vector>
+#include "Loader.hpp"
+
+// Renumbers points and cells along a Morton (Z-order) curve so that neighbours in
+// space are neighbours in memory, which keeps the position and scalar gathers of
+// MeshProcessor cache friendly for solver output with scattered numbering.
+// Connectivity, cell types and all point/cell arrays are permuted; the original ids
+// are kept in grid.original_point_ids / original_cell_ids.
+namespace SpatialReorder {
+
+// Morton code of a point quantized to 16 bits per axis (48-bit key)
+uint64_t mortonCode(uint32_t x, uint32_t y, uint32_t z);
+
+// Sorts points by position and cells by centroid. Returns false (and leaves the
+// grid untouched) if the grid is empty or inconsistent.
+bool reorder(UnstructuredGrid& grid);
+
+// Applies an explicit renumbering: new point i is old point pointOrder[i], new cell j
+// is old cell cellOrder[j]. Either order may be empty to keep that numbering.
+void applyPermutation(UnstructuredGrid& grid,
+                      const std::vector<uint32_t>& pointOrder,
+                      const std::vector<uint32_t>& cellOrder);
+
+} // namespace SpatialReorder
+
+#endif // SPATIALREORDER_HPP
@@ -0,0 +1,414 @@
+#include "SubsetSurface.hpp"
+#include "CellTopology.hpp"
+#include "Parallel.hpp"
+#include "RadixSort.hpp"
+#include "TriangleBvh.hpp"
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <algorithm>
+#include <cmath>
+
+Q_LOGGING_CATEGORY(subsetSurfaceLog, "VTKViewer.SubsetSurface")
+
+namespace {
+
+// Boundary face re-derived from its owning cell
+struct Polygon {
+    uint32_t points[4];
+    uint32_t cell;
+    uint8_t n;
+};
+
+// Picks the local face `wanted` out of a cell's faces
+struct PolygonSink {
+    uint32_t* points;
+    uint8_t n;
+    size_t wanted;
+    size_t current;
+    void tri(uint32_t a, uint32_t b, uint32_t c) {
+        if (current++ != wanted) return;
+        points[0] = a; points[1] = b; points[2] = c; points[3] = 0;
+        n = 3;
+    }
+    void quad(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+        if (current++ != wanted) return;
+        points[0] = a; points[1] = b; points[2] = c; points[3] = d;
+        n = 4;
+    }
+};
+
+} // namespace
+
+void SubsetSurface::setGrid(const std::shared_ptr<UnstructuredGrid>& grid)
+{
+    m_grid = grid;
+    m_prepared = false;
+    m_usable = false;
+    m_topology = MeshProcessor::FaceTopology();
+    m_positions.clear();
+    m_rejected.clear();
+    m_faceUse.clear();
+    m_labels.clear();
+    m_boundary.clear();
+    m_boundaryPos.clear();
+    m_changedEntries.clear();
+    m_listRebuilt = true;
+    m_keptCount = 0;
+}
+
+bool SubsetSurface::prepare()
+{
+    if (m_prepared) return m_usable;
+    m_prepared = true;
+    if (!m_grid || !m_grid->points) return false;
+
+    QElapsedTimer timer;
+    timer.start();
+    const size_t numPoints = static_cast<size_t>(std::max<int64_t>(m_grid->num_points, 0));
+    m_positions = CellTopology::pointPositions(*m_grid->points, numPoints);
+    if (m_positions.empty() || !MeshProcessor::buildFaceTopology(*m_grid, m_positions.size() / 3, m_topology)) {
+        qWarning(subsetSurfaceLog) << "Cells can't be used for subset surfaces";
+        m_positions.clear();
+        return false;
+    }
+
+    // Every cell starts out kept, so the boundary is that of the whole grid
+    const size_t faceCount = m_topology.faceCount();
+    m_rejected.assign(m_topology.cellOffsets.size(), 0);
+    m_keptCount = m_rejected.size();
+    m_faceUse = std::vector<std::atomic<uint32_t>>(faceCount);
+    const int64_t faces = static_cast<int64_t>(faceCount);
+    #pragma omp parallel for schedule(static)
+    for (int64_t f = 0; f < faces; ++f) {
+        m_faceUse[f].store(m_topology.faceSlotOffsets[f + 1] - m_topology.faceSlotOffsets[f], std::memory_order_relaxed);
+    }
+    m_usable = true;
+    collectShownFaces();
+    qInfo(subsetSurfaceLog) << "Face topology" << faceCount << "faces from" << m_topology.slotFaces.size()
+                            << "slots in" << timer.elapsed() << "ms";
+    return true;
+}
+
+size_t SubsetSurface::setRejected(const uint32_t* cells, size_t count, Filter filter, bool rejected)
+{
+    if (!prepare()) return 0;
+    const size_t numCells = m_rejected.size();
+
+    // Cells whose bit changes while no other filter rejects them enter or leave the subset
+    const std::vector<uint32_t> flips = Parallel::collect<uint32_t>(count,
+        [&](size_t i) {
+            const uint32_t cell = cells[i];
+            return cell < numCells && ((m_rejected[cell] & filter) != 0) != rejected
+                && (m_rejected[cell] & ~filter) == 0;
+        },
+        [&](size_t i) { return cells[i]; });
+
+    const int64_t n = static_cast<int64_t>(count);
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < n; ++i) {
+        const uint32_t cell = cells[i];
+        if (cell >= numCells) continue;
+        if (rejected) m_rejected[cell] |= filter;
+        else m_rejected[cell] &= static_cast<uint8_t>(~filter);
+    }
+
+    updateFaces(flips, !rejected);
+    return flips.size();
+}
+
+size_t SubsetSurface::clearFilter(Filter filter)
+{
+    if (!m_usable) return 0;
+    const std::vector<uint32_t> cells = Parallel::collect<uint32_t>(m_rejected.size(),
+        [&](size_t c) { return (m_rejected[c] & filter) != 0; },
+        [](size_t c) { return static_cast<uint32_t>(c); });
+    return setRejected(cells.data(), cells.size(), filter, false);
+}
+
+void SubsetSurface::setInterfaceLabels(std::vector<uint32_t> labels)
+{
+    m_labels = std::move(labels);
+    if (m_usable) collectShownFaces();
+}
+
+size_t SubsetSurface::cellOfSlot(size_t slot) const
+{
+    // Cells without faces share their slot offset with the next cell; upper_bound skips them
+    return static_cast<size_t>(std::upper_bound(m_topology.cellSlots.begin(), m_topology.cellSlots.end(), slot)
+                               - m_topology.cellSlots.begin()) - 1;
+}
+
+bool SubsetSurface::isShown(uint32_t face) const
+{
+    const uint32_t use = m_faceUse[face].load(std::memory_order_relaxed);
+    if (use == 1) return true;
+    if (use < 2 || m_labels.empty()) return false;
+
+    // Interface: two kept cells on this face with different labels
+    uint32_t first = kNotListed;
+    for (uint32_t k = m_topology.faceSlotOffsets[face]; k < m_topology.faceSlotOffsets[face + 1]; ++k) {
+        const size_t cell = cellOfSlot(m_topology.faceSlots[k]);
+        if (m_rejected[cell] != 0) continue;
+        const uint32_t label = cell < m_labels.size() ? m_labels[cell] : kNotListed;
+        if (first == kNotListed) first = label;
+        else if (label != first) return true;
+    }
+    return false;
+}
+
+void SubsetSurface::collectShownFaces()
+{
+    // Flags first: collect() tests every face twice, and interfaces look up their cells
+    const size_t faceCount = m_topology.faceCount();
+    const int64_t faces = static_cast<int64_t>(faceCount);
+    std::vector<uint8_t> shown(faceCount);
+    #pragma omp parallel for schedule(static)
+    for (int64_t f = 0; f < faces; ++f) {
+        shown[f] = isShown(static_cast<uint32_t>(f)) ? 1 : 0;
+    }
+    m_boundary = Parallel::collect<uint32_t>(faceCount,
+        [&shown](size_t f) { return shown[f] != 0; },
+        [](size_t f) { return static_cast<uint32_t>(f); });
+    m_boundaryPos.assign(faceCount, kNotListed);
+    m_changedEntries.clear();
+    m_listRebuilt = true;
+    const int64_t listed = static_cast<int64_t>(m_boundary.size());
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < listed; ++i) {
+        m_boundaryPos[m_boundary[i]] = static_cast<uint32_t>(i);
+    }
+}
+
+void SubsetSurface::updateFaces(const std::vector<uint32_t>& cells, bool kept)
+{
+    // Face use counts first; several cells may share a face
+    const int64_t count = static_cast<int64_t>(cells.size());
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < count; ++i) {
+        const uint32_t cell = cells[i];
+        for (size_t s = m_topology.cellSlots[cell]; s < m_topology.cellSlots[cell + 1]; ++s) {
+            std::atomic<uint32_t>& use = m_faceUse[m_topology.slotFaces[s]];
+            if (kept) use.fetch_add(1, std::memory_order_relaxed);
+            else use.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Then the shown list; a face reached a second time is already consistent
+    for (int64_t i = 0; i < count; ++i) {
+        const uint32_t cell = cells[i];
+        for (size_t s = m_topology.cellSlots[cell]; s < m_topology.cellSlots[cell + 1]; ++s) {
+            const uint32_t face = m_topology.slotFaces[s];
+            const bool boundary = isShown(face);
+            const uint32_t pos = m_boundaryPos[face];
+            if (boundary && pos == kNotListed) {
+                m_boundaryPos[face] = static_cast<uint32_t>(m_boundary.size());
+                m_changedEntries.push_back(static_cast<uint32_t>(m_boundary.size()));
+                m_boundary.push_back(face);
+            } else if (!boundary && pos != kNotListed) {
+                const uint32_t last = m_boundary.back();
+                m_boundary[pos] = last;
+                m_boundaryPos[last] = pos;
+                m_boundary.pop_back();
+                m_boundaryPos[face] = kNotListed;
+                m_changedEntries.push_back(pos);
+            }
+        }
+    }
+
+    // Past half the list, rewriting it whole is about as cheap as patching it
+    if (m_changedEntries.size() > m_boundary.size() / 2) {
+        m_changedEntries.clear();
+        m_listRebuilt = true;
+    }
+
+    if (kept) m_keptCount += cells.size();
+    else m_keptCount -= cells.size();
+}
+
+uint8_t SubsetSurface::shownPolygon(uint32_t face, uint32_t points[4], uint32_t& cell) const
+{
+    size_t owner = 0, slot = 0;
+    for (uint32_t k = m_topology.faceSlotOffsets[face]; k < m_topology.faceSlotOffsets[face + 1]; ++k) {
+        slot = m_topology.faceSlots[k];
+        owner = cellOfSlot(slot);
+        if (m_rejected[owner] == 0) break;
+    }
+    const int32_t* record = &m_grid->cells[m_topology.cellOffsets[owner]];
+    const uint8_t type = owner < m_grid->cell_types.size() ? m_grid->cell_types[owner]
+                                                           : static_cast<uint8_t>(CellTopology::VTK_TRIANGLE);
+    PolygonSink sink{points, 0, slot - m_topology.cellSlots[owner], 0};
+    CellTopology::visitCellFaces(type, record[0], record + 1, sink);
+    cell = static_cast<uint32_t>(owner);
+    return sink.n;
+}
+
+ContourSurface SubsetSurface::faceTriangles(const uint32_t* entries, size_t count,
+                                            const float* pointScalars, const float* cellScalars) const
+{
+    ContourSurface surface;
+    if (!m_usable) return surface;
+
+    // Winding-order polygon of each listed face
+    const int64_t faceCount = static_cast<int64_t>(count);
+    std::vector<Polygon> polygons(count);
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < faceCount; ++i) {
+        const uint32_t face = m_boundary[entries ? entries[i] : static_cast<size_t>(i)];
+        polygons[i].n = shownPolygon(face, polygons[i].points, polygons[i].cell);
+    }
+
+    // Quads split 0-1-2 / 0-2-3 like the boundary surface; a triangle's second one is 0-2-2
+    const size_t triangles = count * 2;
+    surface.vertexData.resize(triangles * 18);
+    surface.scalars.resize((pointScalars || cellScalars) ? triangles * 3 : 0);
+    surface.triangleCells.resize(triangles);
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < faceCount; ++i) {
+        const Polygon& polygon = polygons[i];
+        float n[3] = {0.0f, 0.0f, 1.0f};
+        for (int part = 0; part < 2; ++part) {
+            const size_t t = static_cast<size_t>(i) * 2 + part;
+            const uint32_t corners[3] = {polygon.points[0], polygon.points[part + 1],
+                                         polygon.points[polygon.n == 4 ? part + 2 : 2]};
+            if (part == 0) {
+                const float* p0 = &m_positions[corners[0] * 3];
+                const float* p1 = &m_positions[corners[1] * 3];
+                const float* p2 = &m_positions[corners[2] * 3];
+                const float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+                const float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+                const float c[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2],
+                                    e1[0] * e2[1] - e1[1] * e2[0]};
+                const float length = std::sqrt(c[0] * c[0] + c[1] * c[1] + c[2] * c[2]);
+                if (length > 0.0f) {
+                    for (int a = 0; a < 3; ++a) n[a] = c[a] / length;
+                }
+            }
+
+            for (int k = 0; k < 3; ++k) {
+                float* v = &surface.vertexData[(t * 3 + k) * 6];
+                v[0] = m_positions[corners[k] * 3 + 0];
+                v[1] = m_positions[corners[k] * 3 + 1];
+                v[2] = m_positions[corners[k] * 3 + 2];
+                v[3] = n[0];
+                v[4] = n[1];
+                v[5] = n[2];
+                if (pointScalars) surface.scalars[t * 3 + k] = pointScalars[corners[k]];
+                else if (cellScalars) surface.scalars[t * 3 + k] = cellScalars[polygon.cell];
+            }
+            surface.triangleCells[t] = polygon.cell;
+        }
+    }
+    return surface;
+}
+
+ContourSurface SubsetSurface::surface(const float* pointScalars, const float* cellScalars) const
+{
+    return faceTriangles(nullptr, m_boundary.size(), pointScalars, cellScalars);
+}
+
+bool SubsetSurface::pick(const float origin[3], const float direction[3], float& distance,
+                         uint32_t& cell, uint32_t& point) const
+{
+    if (!m_usable) return false;
+
+    // Triangle t is part t % 2 of entry t / 2, as laid out by faceTriangles()
+    auto corners = [&](size_t t, float* p0, float* p1, float* p2) {
+        uint32_t points[4] = {0, 0, 0, 0};
+        uint32_t owner;
+        const uint8_t n = shownPolygon(m_boundary[t / 2], points, owner);
+        const size_t part = t % 2;
+        if (part + 3 > n) return false;
+        for (int a = 0; a < 3; ++a) {
+            p0[a] = m_positions[points[0] * 3 + a];
+            p1[a] = m_positions[points[part + 1] * 3 + a];
+            p2[a] = m_positions[points[part + 2] * 3 + a];
+        }
+        return true;
+    };
+    const TriangleBvh::Hit hit = TriangleBvh::intersectEach(m_boundary.size() * 2, corners, origin, direction);
+    if (!hit.valid()) return false;
+
+    uint32_t points[4] = {0, 0, 0, 0};
+    shownPolygon(m_boundary[hit.triangle / 2], points, cell);
+    const size_t part = hit.triangle % 2;
+    const uint32_t triangle[3] = {points[0], points[part + 1], points[part + 2]};
+    const float weights[3] = {1.0f - hit.u - hit.v, hit.u, hit.v};
+    point = triangle[std::max_element(weights, weights + 3) - weights];
+    distance = hit.distance;
+    return true;
+}
+
+bool SubsetSurface::takeChangedEntries(std::vector<uint32_t>& entries)
+{
+    entries.clear();
+    if (m_listRebuilt) {
+        m_listRebuilt = false;
+        m_changedEntries.clear();
+        return false;
+    }
+
+    // An entry may be rewritten several times, or dropped again with the list's tail
+    entries.swap(m_changedEntries);
+    std::sort(entries.begin(), entries.end());
+    entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+    entries.erase(std::lower_bound(entries.begin(), entries.end(), static_cast<uint32_t>(m_boundary.size())),
+                  entries.end());
+    return true;
+}
+
+void SortedCellRange::setKeys(const std::vector<float>& keys)
+{
+    m_cells = Parallel::collect<uint32_t>(keys.size(),
+        [&keys](size_t c) { return !std::isnan(keys[c]); },
+        [](size_t c) { return static_cast<uint32_t>(c); });
+
+    const int64_t count = static_cast<int64_t>(m_cells.size());
+    std::vector<uint32_t> sortKeys(m_cells.size());
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < count; ++i) {
+        sortKeys[i] = RadixSort::floatKey(keys[m_cells[i]]);
+    }
+    RadixSort::sortPairs(sortKeys, m_cells, 32, [](uint32_t key, int shift) { return (key >> shift) & 0xFF; });
+
+    m_keys.resize(m_cells.size());
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < count; ++i) {
+        m_keys[i] = keys[m_cells[i]];
+    }
+
+    // NaN cells trail the order, outside every run a range can select
+    const std::vector<uint32_t> unkeyed = Parallel::collect<uint32_t>(keys.size(),
+        [&keys](size_t c) { return std::isnan(keys[c]); },
+        [](size_t c) { return static_cast<uint32_t>(c); });
+    m_cells.insert(m_cells.end(), unkeyed.begin(), unkeyed.end());
+    reset();
+}
+
+void SortedCellRange::reset()
+{
+    m_begin = 0;
+    m_end = m_cells.size();
+}
+
+size_t SortedCellRange::select(float low, float high, SubsetSurface& surface, SubsetSurface::Filter filter)
+{
+    size_t begin = static_cast<size_t>(std::lower_bound(m_keys.begin(), m_keys.end(), low) - m_keys.begin());
+    size_t end = static_cast<size_t>(std::upper_bound(m_keys.begin(), m_keys.end(), high) - m_keys.begin());
+    if (begin >= end) begin = end = 0;
+
+    // Only the symmetric difference of the old and the new run flips
+    const uint32_t* cells = m_cells.data();
+    size_t changed = 0;
+    if (end <= m_begin || begin >= m_end) {
+        changed += surface.setRejected(cells + m_begin, m_end - m_begin, filter, true);
+        changed += surface.setRejected(cells + begin, end - begin, filter, false);
+    } else {
+        if (m_begin < begin) changed += surface.setRejected(cells + m_begin, begin - m_begin, filter, true);
+        if (end < m_end) changed += surface.setRejected(cells + end, m_end - end, filter, true);
+        if (begin < m_begin) changed += surface.setRejected(cells + begin, m_begin - begin, filter, false);
+        if (m_end < end) changed += surface.setRejected(cells + m_end, end - m_end, filter, false);
+    }
+    m_begin = begin;
+    m_end = end;
+    return changed;
+}
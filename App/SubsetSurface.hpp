@@ -0,0 +1,140 @@
+#ifndef SUBSETSURFACE_HPP
+#define SUBSETSURFACE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Contour.hpp"
+#include "Loader.hpp"
+#include "MeshProcessor.hpp"
+
+// Boundary of a changing subset of cells: the faces used by exactly one kept cell, and
+// optionally the interfaces between kept cells of different labels (regions).
+// Filters reject cells through their own bit, and a cell is kept while no filter
+// rejects it, so several filters combine without knowing of each other. Every distinct
+// face counts the kept cells using it; a cell that comes or goes only touches its own
+// faces, and the shown face list is patched for those faces alone.
+class SubsetSurface
+{
+public:
+    enum Filter : uint8_t {
+        ClipFilter = 1 << 0,
+        ThresholdFilter = 1 << 1,
+        RegionFilter = 1 << 2
+    };
+
+    // Drops the face topology and all rejections
+    void setGrid(const std::shared_ptr<UnstructuredGrid>& grid);
+    const std::shared_ptr<UnstructuredGrid>& grid() const { return m_grid; }
+
+    // Builds the face topology with every cell kept on first use; false if the grid's
+    // cells can't be used
+    bool prepare();
+
+    // Sets or clears one filter's rejection of the listed (distinct) cells.
+    // Returns the number of cells that were dropped or kept again as a result.
+    size_t setRejected(const uint32_t* cells, size_t count, Filter filter, bool rejected);
+
+    // Clears a filter's rejection of every cell
+    size_t clearFilter(Filter filter);
+
+    // One label per cell: faces between kept cells of different labels are shown as
+    // well. Empty shows the boundary only.
+    void setInterfaceLabels(std::vector<uint32_t> labels);
+
+    bool isKept(uint32_t cell) const { return cell < m_rejected.size() && m_rejected[cell] == 0; }
+    size_t cellCount() const { return m_rejected.size(); }
+    size_t keptCount() const { return m_keptCount; }
+    size_t boundaryFaceCount() const { return m_boundary.size(); }
+
+    // Every shown face takes kFaceVertices vertices: two triangles, the second one
+    // degenerate for a triangle face. Entry i of the shown list thus always lies at
+    // vertices [i * kFaceVertices, (i + 1) * kFaceVertices) of a buffer that mirrors it.
+    static constexpr size_t kFaceVertices = 6;
+
+    // Flat-shaded triangles of the listed entries of the shown list, in that order, wound
+    // as in their (first) kept cell and colored as in Contour::contourCells
+    ContourSurface faceTriangles(const uint32_t* entries, size_t count,
+                                 const float* pointScalars, const float* cellScalars) const;
+
+    // The same for the whole shown list
+    ContourSurface surface(const float* pointScalars, const float* cellScalars) const;
+
+    // Shown face hit first by origin + t * direction (t >= 0), testing every face: its
+    // distance along the ray, its kept cell and the face corner nearest to the hit
+    bool pick(const float origin[3], const float direction[3], float& distance,
+              uint32_t& cell, uint32_t& point) const;
+
+    // Entries of the shown list that hold another face since the last call, ascending and
+    // below boundaryFaceCount(). Returns false instead when the list was rebuilt, or
+    // changed so much that it is cheaper to take it whole.
+    bool takeChangedEntries(std::vector<uint32_t>& entries);
+
+    // Geometry and cell addressing, valid after prepare()
+    const std::vector<float>& positions() const { return m_positions; }
+    const std::vector<size_t>& cellOffsets() const { return m_topology.cellOffsets; }
+
+private:
+    static constexpr uint32_t kNotListed = UINT32_MAX;
+
+    // Moves the listed cells in or out of the subset and patches the boundary
+    void updateFaces(const std::vector<uint32_t>& cells, bool kept);
+
+    // Boundary face, or an interface when labels are set
+    bool isShown(uint32_t face) const;
+    size_t cellOfSlot(size_t slot) const;
+
+    // Corners of a shown face in winding order, from its first kept cell; returns their
+    // number (3 or 4)
+    uint8_t shownPolygon(uint32_t face, uint32_t points[4], uint32_t& cell) const;
+
+    // Rebuilds the shown face list from scratch
+    void collectShownFaces();
+
+    std::shared_ptr<UnstructuredGrid> m_grid;
+    bool m_prepared = false;
+    bool m_usable = false;
+    MeshProcessor::FaceTopology m_topology;
+    std::vector<float> m_positions;
+
+    std::vector<uint8_t> m_rejected;                 // Filter bits per cell; kept when 0
+    std::vector<std::atomic<uint32_t>> m_faceUse;    // Kept cells using each face
+    std::vector<uint32_t> m_labels;                  // Per cell, or empty
+    std::vector<uint32_t> m_boundary;                // Shown faces, unordered
+    std::vector<uint32_t> m_boundaryPos;             // Position of each face in m_boundary
+    std::vector<uint32_t> m_changedEntries;          // Positions rewritten since the last take, unsorted
+    bool m_listRebuilt = true;
+    size_t m_keptCount = 0;
+};
+
+// Cells ordered by a per-cell key, with one filter of a SubsetSurface rejecting the
+// cells whose key lies outside [low, high]. Kept cells are a contiguous run of the
+// order, so moving the bounds only flips the cells between the old and the new bounds.
+class SortedCellRange
+{
+public:
+    // Cells with a NaN key are rejected by any range. The run starts out covering every
+    // cell, matching a filter that rejects nothing.
+    void setKeys(const std::vector<float>& keys);
+
+    // Every cell counts as kept again, after the filter was cleared on the surface
+    void reset();
+
+    // Returns the number of cells that were dropped or kept again
+    size_t select(float low, float high, SubsetSurface& surface, SubsetSurface::Filter filter);
+
+    bool empty() const { return m_keys.empty(); }
+    size_t size() const { return m_keys.size(); }
+    float lowest() const { return m_keys.empty() ? 1.0f : m_keys.front(); }
+    float highest() const { return m_keys.empty() ? 0.0f : m_keys.back(); }
+
+private:
+    std::vector<float> m_keys;       // Sorted, without NaN
+    std::vector<uint32_t> m_cells;   // Cell of each key, then the cells with a NaN key
+    size_t m_begin = 0;              // Kept run [m_begin, m_end)
+    size_t m_end = 0;
+};
+
+#endif // SUBSETSURFACE_HPP
@@ -0,0 +1,379 @@
+#include "TriangleBvh.hpp"
+#include "Parallel.hpp"
+#include "VertexReader.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+constexpr float kInf = std::numeric_limits<float>::infinity();
+constexpr float kTraversalCost = 1.0f;  // Relative to one triangle test
+constexpr int kBins = TriangleBvh::kBins;
+
+struct Box {
+    float lo[3] = {kInf, kInf, kInf};
+    float hi[3] = {-kInf, -kInf, -kInf};
+
+    void grow(const float* l, const float* h)
+    {
+        for (int a = 0; a < 3; ++a) {
+            lo[a] = std::min(lo[a], l[a]);
+            hi[a] = std::max(hi[a], h[a]);
+        }
+    }
+    void grow(const Box& b) { grow(b.lo, b.hi); }
+
+    float area() const
+    {
+        if (lo[0] > hi[0]) return 0.0f;
+        const float dx = hi[0] - lo[0], dy = hi[1] - lo[1], dz = hi[2] - lo[2];
+        return 2.0f * (dx * dy + dy * dz + dz * dx);
+    }
+};
+
+struct Bin {
+    Box box;
+    uint32_t count = 0;
+};
+
+// Node of the current level: m_nodes[node] covers triangles [begin, end)
+struct Task {
+    uint32_t node;
+    uint32_t begin;
+    uint32_t end;
+};
+
+struct Split {
+    bool leaf = true;
+    uint32_t mid = 0;
+    Box left, right;
+};
+
+// Bounds of one triangle. The build partitions these in place rather than triangle
+// ids, so the passes over a node read memory sequentially.
+struct PrimRef {
+    float lo[3];
+    uint32_t triangle;
+    float hi[3];
+
+    float centroid(int axis) const { return 0.5f * (lo[axis] + hi[axis]); }
+};
+
+// SAH split of triangles [begin, end). With `parallel` the passes over the range are
+// chunked over all threads (for the few large nodes near the root).
+Split splitNode(PrimRef* refs, uint32_t begin, uint32_t end,
+                const Box& nodeBox, bool parallel)
+{
+    Split split;
+    const uint32_t n = end - begin;
+    if (n <= 1) return split;
+    const int chunks = parallel
+        ? std::max(1, std::min(Parallel::maxThreads(), static_cast<int>(n / 65536) + 1)) : 1;
+
+    auto growCentroids = [&](size_t first, size_t last, Box& box) {
+        for (size_t i = begin + first; i < begin + last; ++i) {
+            const float c[3] = {refs[i].centroid(0), refs[i].centroid(1), refs[i].centroid(2)};
+            box.grow(c, c);
+        }
+    };
+    float scale[3];
+    Box centroids;
+    auto binOf = [&](const PrimRef& ref, int a) {
+        const int bin = static_cast<int>((ref.centroid(a) - centroids.lo[a]) * scale[a]);
+        return std::min(kBins - 1, std::max(0, bin));
+    };
+    // Bins of all three axes in one pass
+    auto growBins = [&](size_t first, size_t last, Bin* bins) {
+        for (size_t i = begin + first; i < begin + last; ++i) {
+            const PrimRef& ref = refs[i];
+            for (int a = 0; a < 3; ++a) {
+                if (scale[a] == 0.0f) continue;
+                Bin& bin = bins[a * kBins + binOf(ref, a)];
+                bin.box.grow(ref.lo, ref.hi);
+                ++bin.count;
+            }
+        }
+    };
+
+    // Small nodes take the serial path without scratch allocations
+    Bin bins[3 * kBins];
+    if (chunks == 1) {
+        growCentroids(0, n, centroids);
+    } else {
+        std::vector<Box> chunkCentroids(chunks);
+        #pragma omp parallel for schedule(static, 1) num_threads(chunks)
+        for (int chunk = 0; chunk < chunks; ++chunk) {
+            size_t first, last;
+            Parallel::chunkRange(n, chunks, chunk, first, last);
+            growCentroids(first, last, chunkCentroids[chunk]);
+        }
+        for (const Box& box : chunkCentroids) centroids.grow(box);
+    }
+    for (int a = 0; a < 3; ++a) {
+        const float extent = centroids.hi[a] - centroids.lo[a];
+        scale[a] = extent > 0.0f ? kBins / extent : 0.0f;
+    }
+    if (chunks == 1) {
+        growBins(0, n, bins);
+    } else {
+        std::vector<Bin> chunkBins(static_cast<size_t>(chunks) * 3 * kBins);
+        #pragma omp parallel for schedule(static, 1) num_threads(chunks)
+        for (int chunk = 0; chunk < chunks; ++chunk) {
+            size_t first, last;
+            Parallel::chunkRange(n, chunks, chunk, first, last);
+            growBins(first, last, &chunkBins[static_cast<size_t>(chunk) * 3 * kBins]);
+        }
+        for (int chunk = 0; chunk < chunks; ++chunk) {
+            for (int b = 0; b < 3 * kBins; ++b) {
+                const Bin& in = chunkBins[static_cast<size_t>(chunk) * 3 * kBins + b];
+                bins[b].box.grow(in.box);
+                bins[b].count += in.count;
+            }
+        }
+    }
+
+    // Sweep: cost of splitting before bin i is area(left) * n(left) + area(right) * n(right)
+    int bestAxis = -1, bestBin = 0;
+    float bestCost = kInf;
+    for (int a = 0; a < 3; ++a) {
+        if (scale[a] == 0.0f) continue;
+        const Bin* axisBins = &bins[a * kBins];
+        float rightCost[kBins];
+        Box right;
+        uint32_t rightCount = 0;
+        for (int i = kBins - 1; i > 0; --i) {
+            right.grow(axisBins[i].box);
+            rightCount += axisBins[i].count;
+            rightCost[i] = rightCount > 0 ? right.area() * rightCount : kInf;
+        }
+        Box left;
+        uint32_t leftCount = 0;
+        for (int i = 1; i < kBins; ++i) {
+            left.grow(axisBins[i - 1].box);
+            leftCount += axisBins[i - 1].count;
+            if (leftCount == 0 || leftCount == n) continue;
+            const float cost = left.area() * leftCount + rightCost[i];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = a;
+                bestBin = i;
+            }
+        }
+    }
+
+    if (bestAxis < 0) {
+        // All centroids coincide: halve the range so leaves stay small
+        if (n <= TriangleBvh::kMaxLeafTriangles) return split;
+        split.leaf = false;
+        split.mid = begin + n / 2;
+        for (uint32_t i = begin; i < end; ++i) {
+            Box& side = i < split.mid ? split.left : split.right;
+            side.grow(refs[i].lo, refs[i].hi);
+        }
+        return split;
+    }
+
+    const float nodeArea = std::max(nodeBox.area(), std::numeric_limits<float>::min());
+    const float splitCost = kTraversalCost + bestCost / nodeArea;
+    if (n <= TriangleBvh::kMaxLeafTriangles && static_cast<float>(n) <= splitCost) return split;
+
+    auto isLeft = [&](const PrimRef& ref) { return binOf(ref, bestAxis) < bestBin; };
+    if (chunks == 1) {
+        split.mid = static_cast<uint32_t>(std::partition(refs + begin, refs + end, isLeft) - refs);
+    } else {
+        const std::vector<PrimRef> left = Parallel::collect<PrimRef>(n,
+            [&](size_t i) { return isLeft(refs[begin + i]); }, [&](size_t i) { return refs[begin + i]; });
+        const std::vector<PrimRef> right = Parallel::collect<PrimRef>(n,
+            [&](size_t i) { return !isLeft(refs[begin + i]); }, [&](size_t i) { return refs[begin + i]; });
+        std::copy(left.begin(), left.end(), refs + begin);
+        std::copy(right.begin(), right.end(), refs + begin + left.size());
+        split.mid = begin + static_cast<uint32_t>(left.size());
+    }
+    split.leaf = false;
+    for (int i = 0; i < kBins; ++i) {
+        (i < bestBin ? split.left : split.right).grow(bins[bestAxis * kBins + i].box);
+    }
+    return split;
+}
+
+} // namespace
+
+bool TriangleBvh::build(const GPUMeshData& mesh, const std::atomic<bool>* cancel)
+{
+    m_nodes.clear();
+    m_triangles.clear();
+    const size_t triCount = mesh.triangleIndices.size() / 3;
+    if (triCount == 0) return true;
+    const VertexReader reader(mesh);
+
+    // Triangle bounds
+    std::vector<PrimRef> refs(triCount);
+    const int64_t count = static_cast<int64_t>(triCount);
+    #pragma omp parallel for schedule(static)
+    for (int64_t t = 0; t < count; ++t) {
+        float p[3][3];
+        for (int k = 0; k < 3; ++k) reader.position(mesh.triangleIndices[t * 3 + k], p[k]);
+        for (int a = 0; a < 3; ++a) {
+            refs[t].lo[a] = std::min(p[0][a], std::min(p[1][a], p[2][a]));
+            refs[t].hi[a] = std::max(p[0][a], std::max(p[1][a], p[2][a]));
+        }
+        refs[t].triangle = static_cast<uint32_t>(t);
+    }
+
+    const int chunks = std::max(1, std::min(Parallel::maxThreads(), static_cast<int>(triCount / 65536) + 1));
+    std::vector<Box> chunkBoxes(chunks);
+    #pragma omp parallel for schedule(static, 1) num_threads(chunks)
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        size_t begin, end;
+        Parallel::chunkRange(triCount, chunks, chunk, begin, end);
+        for (size_t t = begin; t < end; ++t) chunkBoxes[chunk].grow(refs[t].lo, refs[t].hi);
+    }
+    Box rootBox;
+    for (const Box& box : chunkBoxes) rootBox.grow(box);
+
+    auto makeNode = [](const Box& box) {
+        Node node;
+        std::copy(box.lo, box.lo + 3, node.lo);
+        std::copy(box.hi, box.hi + 3, node.hi);
+        node.first = 0;
+        node.count = 0;
+        return node;
+    };
+    m_nodes.reserve(2 * (triCount / 2 + 1));
+    m_nodes.push_back(makeNode(rootBox));
+
+    // Breadth first, one level per iteration
+    std::vector<Task> frontier{{0, 0, static_cast<uint32_t>(triCount)}};
+    while (!frontier.empty()) {
+        if (cancel && *cancel) {
+            m_nodes.clear();
+            return false;
+        }
+
+        std::vector<Split> splits(frontier.size());
+        auto nodeBox = [](const Node& node) {
+            Box box;
+            box.grow(node.lo, node.hi);
+            return box;
+        };
+        if (static_cast<int>(frontier.size()) < Parallel::maxThreads()) {
+            for (size_t i = 0; i < frontier.size(); ++i) {
+                const Task& task = frontier[i];
+                splits[i] = splitNode(refs.data(), task.begin, task.end,
+                                      nodeBox(m_nodes[task.node]), true);
+            }
+        } else {
+            const int64_t taskCount = static_cast<int64_t>(frontier.size());
+            #pragma omp parallel for schedule(dynamic, 1)
+            for (int64_t i = 0; i < taskCount; ++i) {
+                const Task& task = frontier[i];
+                splits[i] = splitNode(refs.data(), task.begin, task.end,
+                                      nodeBox(m_nodes[task.node]), false);
+            }
+        }
+
+        std::vector<Task> next;
+        next.reserve(frontier.size() * 2);
+        for (size_t i = 0; i < frontier.size(); ++i) {
+            const Task& task = frontier[i];
+            const Split& split = splits[i];
+            if (split.leaf) {
+                m_nodes[task.node].first = task.begin;
+                m_nodes[task.node].count = task.end - task.begin;
+                continue;
+            }
+            const uint32_t children = static_cast<uint32_t>(m_nodes.size());
+            m_nodes[task.node].first = children;
+            m_nodes[task.node].count = 0;
+            m_nodes.push_back(makeNode(split.left));
+            m_nodes.push_back(makeNode(split.right));
+            next.push_back({children, task.begin, split.mid});
+            next.push_back({children + 1, split.mid, task.end});
+        }
+        frontier.swap(next);
+    }
+
+    m_triangles.resize(triCount);
+    #pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < count; ++i) {
+        m_triangles[i] = refs[i].triangle;
+    }
+    return true;
+}
+
+TriangleBvh::Hit TriangleBvh::intersect(const GPUMeshData& mesh, const float origin[3],
+                                        const float direction[3], const std::vector<uint8_t>& partHidden) const
+{
+    Hit hit;
+    if (m_nodes.empty()) return hit;
+    const VertexReader reader(mesh);
+
+    // Part of a triangle by its range; only looked up while some part is hidden
+    const std::vector<uint32_t>& parts = mesh.partOffsets;
+    const bool anyHidden = parts.size() == partHidden.size() + 1
+                        && std::find(partHidden.begin(), partHidden.end(), 1) != partHidden.end();
+    auto hidden = [&](uint32_t t) {
+        const size_t part = static_cast<size_t>(std::upper_bound(parts.begin(), parts.end(), t) - parts.begin()) - 1;
+        return part < partHidden.size() && partHidden[part] != 0;
+    };
+
+    float invDir[3];
+    for (int a = 0; a < 3; ++a) {
+        const float d = std::fabs(direction[a]) > 1e-30f ? direction[a] : std::copysign(1e-30f, direction[a]);
+        invDir[a] = 1.0f / d;
+    }
+    float best = kInf;
+
+    // Entry distance of the ray into a node, or infinity if it misses or lies beyond `best`
+    auto entry = [&](const Node& node) {
+        float tNear = 0.0f, tFar = best;
+        for (int a = 0; a < 3; ++a) {
+            float t0 = (node.lo[a] - origin[a]) * invDir[a];
+            float t1 = (node.hi[a] - origin[a]) * invDir[a];
+            if (t0 > t1) std::swap(t0, t1);
+            tNear = std::max(tNear, t0);
+            tFar = std::min(tFar, t1);
+        }
+        return tNear <= tFar ? tNear : kInf;
+    };
+
+    std::vector<uint32_t> stack;
+    stack.reserve(64);
+    stack.push_back(0);
+    while (!stack.empty()) {
+        const Node& node = m_nodes[stack.back()];
+        stack.pop_back();
+        if (entry(node) == kInf) continue;
+
+        if (node.count == 0) {
+            // Nearer child is popped first
+            uint32_t nearChild = node.first, farChild = node.first + 1;
+            float tNear = entry(m_nodes[nearChild]), tFar = entry(m_nodes[farChild]);
+            if (tFar < tNear) {
+                std::swap(nearChild, farChild);
+                std::swap(tNear, tFar);
+            }
+            if (tFar != kInf) stack.push_back(farChild);
+            if (tNear != kInf) stack.push_back(nearChild);
+            continue;
+        }
+
+        for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+            const uint32_t t = m_triangles[i];
+            if (anyHidden && hidden(t)) continue;
+            float p0[3], p1[3], p2[3], distance, u, v;
+            reader.position(mesh.triangleIndices[t * 3 + 0], p0);
+            reader.position(mesh.triangleIndices[t * 3 + 1], p1);
+            reader.position(mesh.triangleIndices[t * 3 + 2], p2);
+            if (intersectTriangle(origin, direction, p0, p1, p2, distance, u, v) && distance < best) {
+                best = distance;
+                hit.triangle = t;
+                hit.distance = distance;
+                hit.u = u;
+                hit.v = v;
+            }
+        }
+    }
+    return hit;
+}
@@ -0,0 +1,115 @@
+#ifndef TRIANGLEBVH_HPP
+#define TRIANGLEBVH_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "MeshProcessor.hpp"
+#include "Parallel.hpp"
+
+// Bounding volume hierarchy over the boundary triangles of a GPUMeshData, for picking.
+// Splits are chosen with the surface area heuristic over binned centroids. The tree
+// is built breadth first: large nodes near the root bin and partition with all threads,
+// deeper levels split many nodes in parallel. Only triangle ids are stored; positions
+// are read from the mesh at query time, so the mesh must outlive the tree unchanged.
+class TriangleBvh
+{
+public:
+    static constexpr uint32_t kNoHit = UINT32_MAX;
+    static constexpr int kBins = 16;
+    static constexpr uint32_t kMaxLeafTriangles = 8;
+
+    struct Hit {
+        uint32_t triangle = kNoHit;
+        float distance = 0.0f;  // Along the ray, in units of the direction's length
+        float u = 0.0f;         // Barycentric weights of corners 1 and 2
+        float v = 0.0f;
+
+        bool valid() const { return triangle != kNoHit; }
+    };
+
+    // Returns false (and leaves the tree empty) when `cancel` is set during the build
+    bool build(const GPUMeshData& mesh, const std::atomic<bool>* cancel = nullptr);
+
+    // Closest triangle hit by origin + t * direction, t >= 0. Both faces are hit.
+    // Triangles of the parts flagged in partHidden (numbered as mesh.partOffsets) are passed through.
+    Hit intersect(const GPUMeshData& mesh, const float origin[3], const float direction[3],
+                  const std::vector<uint8_t>& partHidden = std::vector<uint8_t>()) const;
+
+    // Möller-Trumbore: distance along the ray and barycentric u, v of a hit with t >= 0
+    static bool intersectTriangle(const float origin[3], const float direction[3], const float p0[3],
+                                  const float p1[3], const float p2[3], float& distance, float& u, float& v)
+    {
+        const float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+        const float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+        const float pv[3] = {direction[1] * e2[2] - direction[2] * e2[1],
+                             direction[2] * e2[0] - direction[0] * e2[2],
+                             direction[0] * e2[1] - direction[1] * e2[0]};
+        const float det = e1[0] * pv[0] + e1[1] * pv[1] + e1[2] * pv[2];
+        if (det == 0.0f) return false;
+        const float invDet = 1.0f / det;
+        const float tv[3] = {origin[0] - p0[0], origin[1] - p0[1], origin[2] - p0[2]};
+        u = (tv[0] * pv[0] + tv[1] * pv[1] + tv[2] * pv[2]) * invDet;
+        if (u < 0.0f || u > 1.0f) return false;
+        const float qv[3] = {tv[1] * e1[2] - tv[2] * e1[1],
+                             tv[2] * e1[0] - tv[0] * e1[2],
+                             tv[0] * e1[1] - tv[1] * e1[0]};
+        v = (direction[0] * qv[0] + direction[1] * qv[1] + direction[2] * qv[2]) * invDet;
+        if (v < 0.0f || u + v > 1.0f) return false;
+        distance = (e2[0] * qv[0] + e2[1] * qv[1] + e2[2] * qv[2]) * invDet;
+        return distance >= 0.0f;
+    }
+
+    // Closest of `count` triangles without a tree, for overlays that change too often to
+    // build one: chunks are tested in parallel and the first of equally near hits wins.
+    // corners(t, p0, p1, p2) fills triangle t's corners, or returns false to skip it.
+    template<typename Corners>
+    static Hit intersectEach(size_t count, Corners corners, const float origin[3], const float direction[3])
+    {
+        const int chunks = std::max(1, std::min(Parallel::maxThreads(), static_cast<int>(count / 4096) + 1));
+        std::vector<Hit> hits(chunks);
+        #pragma omp parallel for schedule(static, 1) num_threads(chunks)
+        for (int chunk = 0; chunk < chunks; ++chunk) {
+            size_t begin, end;
+            Parallel::chunkRange(count, chunks, chunk, begin, end);
+            Hit best;
+            best.distance = std::numeric_limits<float>::infinity();
+            for (size_t t = begin; t < end; ++t) {
+                float p0[3], p1[3], p2[3], distance, u, v;
+                if (!corners(t, p0, p1, p2)) continue;
+                if (intersectTriangle(origin, direction, p0, p1, p2, distance, u, v) && distance < best.distance) {
+                    best.triangle = static_cast<uint32_t>(t);
+                    best.distance = distance;
+                    best.u = u;
+                    best.v = v;
+                }
+            }
+            hits[chunk] = best;
+        }
+        Hit hit;
+        for (const Hit& h : hits) {
+            if (h.valid() && (!hit.valid() || h.distance < hit.distance)) hit = h;
+        }
+        return hit;
+    }
+
+    bool empty() const { return m_nodes.empty(); }
+    size_t nodeCount() const { return m_nodes.size(); }
+
+private:
+    // Interior nodes have count 0 and children first, first + 1;
+    // leaves hold m_triangles[first, first + count)
+    struct Node {
+        float lo[3];
+        uint32_t first;
+        float hi[3];
+        uint32_t count;
+    };
+
+    std::vector<Node> m_nodes;
+    std::vector<uint32_t> m_triangles;
+};
+
+#endif // TRIANGLEBVH_HPP
@@ -0,0 +1,64 @@
+#ifndef VERTEXREADER_HPP
+#define VERTEXREADER_HPP
+
+#include <algorithm>
+#include <cmath>
+#include "MeshProcessor.hpp"
+
+// Reads position and normal of a render vertex in either vertex format
+class VertexReader
+{
+public:
+    explicit VertexReader(const GPUMeshData& mesh)
+        : m_mesh(mesh)
+        , m_compact(mesh.vertexFormat == VertexFormat::Compact)
+    {
+        m_origin[0] = mesh.boundingBoxMin.x();
+        m_origin[1] = mesh.boundingBoxMin.y();
+        m_origin[2] = mesh.boundingBoxMin.z();
+        m_extent[0] = mesh.boundingBoxMax.x() - m_origin[0];
+        m_extent[1] = mesh.boundingBoxMax.y() - m_origin[1];
+        m_extent[2] = mesh.boundingBoxMax.z() - m_origin[2];
+    }
+
+    void position(size_t v, float out[3]) const
+    {
+        if (m_compact) {
+            const CompactVertex& c = m_mesh.compactVertices[v];
+            for (int i = 0; i < 3; ++i) out[i] = m_origin[i] + c.position[i] * (1.0f / 65535.0f) * m_extent[i];
+        } else {
+            const float* in = &m_mesh.vertexData[v * 6];
+            out[0] = in[0]; out[1] = in[1]; out[2] = in[2];
+        }
+    }
+
+    // Unit normal (octahedral decode for compact vertices, as in mesh.vert)
+    void normal(size_t v, float out[3]) const
+    {
+        if (m_compact) {
+            const CompactVertex& c = m_mesh.compactVertices[v];
+            const float u = std::max(-1.0f, c.normal[0] / 32767.0f);
+            const float w = std::max(-1.0f, c.normal[1] / 32767.0f);
+            float n[3] = {u, w, 1.0f - std::fabs(u) - std::fabs(w)};
+            if (n[2] < 0.0f) {
+                const float fu = (1.0f - std::fabs(w)) * (u >= 0.0f ? 1.0f : -1.0f);
+                const float fw = (1.0f - std::fabs(u)) * (w >= 0.0f ? 1.0f : -1.0f);
+                n[0] = fu;
+                n[1] = fw;
+            }
+            const float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            for (int i = 0; i < 3; ++i) out[i] = n[i] / length;
+        } else {
+            const float* in = &m_mesh.vertexData[v * 6 + 3];
+            out[0] = in[0]; out[1] = in[1]; out[2] = in[2];
+        }
+    }
+
+private:
+    const GPUMeshData& m_mesh;
+    bool m_compact;
+    float m_origin[3];
+    float m_extent[3];
+};
+
+#endif // VERTEXREADER_HPP
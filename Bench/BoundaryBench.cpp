@@ -0,0 +1,53 @@
+// Compares sort-based and hash-based boundary face detection in MeshProcessor::process.
+// Usage: BoundaryBench [cubes per axis = 64] [repetitions = 3]
+// Fails if a method does not find exactly the 12 n^2 triangles of the block's sides.
+// Set QT_LOGGING_RULES="VTKViewer.*=true" to also see the per-stage timings.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include "MeshProcessor.hpp"
+#include "SyntheticMeshes.hpp"
+
+int main(int argc, char* argv[])
+{
+    const int n = (argc > 1) ? std::atoi(argv[1]) : 64;
+    const int repetitions = (argc > 2) ? std::atoi(argv[2]) : 3;
+
+    const SyntheticMeshes::CellMix mixes[] = {
+        SyntheticMeshes::CellMix::Tet, SyntheticMeshes::CellMix::Hex, SyntheticMeshes::CellMix::Mixed
+    };
+
+    const size_t expected = 12 * static_cast<size_t>(n) * static_cast<size_t>(n);
+    bool allCorrect = true;
+    std::printf("%-6s %12s %12s %12s %12s\n", "mesh", "cells", "sort [ms]", "hash [ms]", "triangles");
+    for (auto mix : mixes) {
+        auto grid = SyntheticMeshes::makeBlock(n, mix);
+
+        double best[2] = {1e30, 1e30};
+        size_t triangles[2] = {0, 0};
+        for (int method = 0; method < 2; ++method) {
+            MeshProcessor processor;
+            processor.setBoundaryMethod(method == 0 ? MeshProcessor::BoundaryMethod::Sort
+                                                    : MeshProcessor::BoundaryMethod::Hash);
+            for (int r = 0; r < repetitions; ++r) {
+                auto start = std::chrono::steady_clock::now();
+                GPUMeshData mesh = processor.process(grid);
+                std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+                if (elapsed.count() < best[method]) best[method] = elapsed.count();
+                triangles[method] = mesh.triangleCount;
+            }
+        }
+
+        const bool correct = (triangles[0] == expected && triangles[1] == expected);
+        allCorrect = allCorrect && correct;
+        std::printf("%-6s %12lld %12.1f %12.1f %12zu%s\n", SyntheticMeshes::cellMixName(mix),
+                    static_cast<long long>(grid->num_cells), best[0], best[1], triangles[1],
+                    correct ? "" : "  WRONG BOUNDARY");
+        if (!correct) {
+            std::fprintf(stderr, "%s: sort found %zu, hash %zu triangles, expected %zu\n",
+                         SyntheticMeshes::cellMixName(mix), triangles[0], triangles[1], expected);
+        }
+    }
+    return allCorrect ? EXIT_SUCCESS : EXIT_FAILURE;
+}
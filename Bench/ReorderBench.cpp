@@ -0,0 +1,82 @@
+// Effect of SpatialReorder on MeshProcessor::process and updateScalars.
+// The synthetic blocks are numbered lexicographically, so they are first scrambled with a
+// random permutation to mimic solver output, then timed before and after reordering.
+// Usage: ReorderBench [cubes per axis = 64] [repetitions = 3]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include "MeshProcessor.hpp"
+#include "SpatialReorder.hpp"
+#include "SyntheticMeshes.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double millisecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+std::vector<uint32_t> shuffledOrder(size_t count, uint32_t seed)
+{
+    std::vector<uint32_t> order(count);
+    std::iota(order.begin(), order.end(), 0u);
+    std::shuffle(order.begin(), order.end(), std::mt19937(seed));
+    return order;
+}
+
+// Best-of-n timings of a full process() and a scalar update of the "distance" field
+void timeProcessing(const std::shared_ptr<UnstructuredGrid>& grid, int repetitions,
+                    double& processMs, double& scalarsMs)
+{
+    MeshProcessor processor;
+    processMs = scalarsMs = 1e30;
+    for (int r = 0; r < repetitions; ++r) {
+        auto start = Clock::now();
+        GPUMeshData mesh = processor.process(grid);
+        processMs = std::min(processMs, millisecondsSince(start));
+
+        start = Clock::now();
+        processor.updateScalars(mesh, grid, "distance", true);
+        scalarsMs = std::min(scalarsMs, millisecondsSince(start));
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const int n = (argc > 1) ? std::atoi(argv[1]) : 64;
+    const int repetitions = (argc > 2) ? std::atoi(argv[2]) : 3;
+
+    const SyntheticMeshes::CellMix mixes[] = {
+        SyntheticMeshes::CellMix::Tet, SyntheticMeshes::CellMix::Hex, SyntheticMeshes::CellMix::Mixed
+    };
+
+    std::printf("%-6s %10s %12s %12s %12s %12s %12s\n", "mesh", "cells", "reorder[ms]",
+                "process[ms]", "(reordered)", "scalars[ms]", "(reordered)");
+    for (auto mix : mixes) {
+        auto grid = SyntheticMeshes::makeBlock(n, mix);
+        SpatialReorder::applyPermutation(*grid, shuffledOrder(static_cast<size_t>(grid->num_points), 1),
+                                         shuffledOrder(static_cast<size_t>(grid->num_cells), 2));
+
+        double process[2], scalars[2];
+        timeProcessing(grid, repetitions, process[0], scalars[0]);
+
+        auto start = Clock::now();
+        SpatialReorder::reorder(*grid);
+        const double reorderMs = millisecondsSince(start);
+
+        timeProcessing(grid, repetitions, process[1], scalars[1]);
+
+        std::printf("%-6s %10lld %12.1f %12.1f %12.1f %12.2f %12.2f\n", SyntheticMeshes::cellMixName(mix),
+                    static_cast<long long>(grid->num_cells), reorderMs,
+                    process[0], process[1], scalars[0], scalars[1]);
+    }
+    return 0;
+}
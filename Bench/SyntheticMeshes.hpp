@@ -0,0 +1,102 @@
+#ifndef SYNTHETICMESHES_HPP
+#define SYNTHETICMESHES_HPP
+
+#include <cmath>
+#include <memory>
+#include "Loader.hpp"
+
+// Procedural unstructured grids for the benchmarks: an n x n x n block of unit cubes,
+// each stored as one hexahedron or split into six tetrahedra around its 0-6 diagonal.
+// Every mix is conforming, so the boundary is always the 12 n^2 triangles of the block's
+// six sides.
+namespace SyntheticMeshes {
+
+enum class CellMix {
+    Hex,    // All hexahedra
+    Tet,    // Six conforming tetrahedra per cube
+    Mixed   // Hexahedra below the middle layer, tetrahedra above it; the middle layer joins
+            // them with a pyramid on each cube's bottom quad plus four tetrahedra
+};
+
+inline const char* cellMixName(CellMix mix)
+{
+    switch (mix) {
+        case CellMix::Hex: return "hex";
+        case CellMix::Tet: return "tet";
+        case CellMix::Mixed: return "mixed";
+    }
+    return "?";
+}
+
+inline std::shared_ptr<UnstructuredGrid> makeBlock(int n, CellMix mix)
+{
+    auto grid = std::make_shared<UnstructuredGrid>();
+    const int64_t p = n + 1;
+    grid->num_points = p * p * p;
+
+    grid->points = std::make_shared<DataArray>();
+    grid->points->name = "Points";
+    grid->points->data_type = "float";
+    grid->points->num_components = 3;
+    grid->points->num_tuples = grid->num_points;
+    grid->points->data_float.resize(static_cast<size_t>(grid->num_points) * 3);
+    float* xyz = grid->points->data_float.data();
+    for (int64_t k = 0; k < p; ++k)
+        for (int64_t j = 0; j < p; ++j)
+            for (int64_t i = 0; i < p; ++i) {
+                *xyz++ = static_cast<float>(i);
+                *xyz++ = static_cast<float>(j);
+                *xyz++ = static_cast<float>(k);
+            }
+
+    auto id = [p](int64_t i, int64_t j, int64_t k) { return static_cast<int32_t>(i + p * (j + p * k)); };
+    static const int tets[6][4] = {{0,1,2,6}, {0,2,3,6}, {0,3,7,6}, {0,7,4,6}, {0,4,5,6}, {0,5,1,6}};
+    // The first two tetrahedra together are the pyramid 0-1-2-3 with apex 6
+    static const int pyramid[5] = {0, 1, 2, 3, 6};
+
+    for (int64_t k = 0; k < n; ++k)
+        for (int64_t j = 0; j < n; ++j)
+            for (int64_t i = 0; i < n; ++i) {
+                const int32_t v[8] = {id(i,j,k), id(i+1,j,k), id(i+1,j+1,k), id(i,j+1,k),
+                                      id(i,j,k+1), id(i+1,j,k+1), id(i+1,j+1,k+1), id(i,j+1,k+1)};
+                const bool hex = (mix == CellMix::Hex) || (mix == CellMix::Mixed && k < n / 2);
+                const bool transition = (mix == CellMix::Mixed && k == n / 2);
+                if (hex) {
+                    grid->cells.push_back(8);
+                    grid->cells.insert(grid->cells.end(), v, v + 8);
+                    grid->cell_types.push_back(12);  // VTK_HEXAHEDRON
+                    continue;
+                }
+                if (transition) {
+                    // Quad bottom matches the hexahedron below, the rest the tetrahedra
+                    grid->cells.push_back(5);
+                    for (int c = 0; c < 5; ++c) grid->cells.push_back(v[pyramid[c]]);
+                    grid->cell_types.push_back(14);  // VTK_PYRAMID
+                }
+                for (int t = transition ? 2 : 0; t < 6; ++t) {
+                    grid->cells.push_back(4);
+                    for (int c = 0; c < 4; ++c) grid->cells.push_back(v[tets[t][c]]);
+                    grid->cell_types.push_back(10);  // VTK_TETRA
+                }
+            }
+    grid->num_cells = static_cast<int64_t>(grid->cell_types.size());
+
+    // One smooth point field so scalar paths have something to map
+    auto field = std::make_shared<DataArray>();
+    field->name = "distance";
+    field->data_type = "float";
+    field->num_components = 1;
+    field->num_tuples = grid->num_points;
+    field->data_float.resize(static_cast<size_t>(grid->num_points));
+    const float* pts = grid->points->data_float.data();
+    for (size_t q = 0; q < field->data_float.size(); ++q) {
+        field->data_float[q] = std::sqrt(pts[q*3] * pts[q*3] + pts[q*3+1] * pts[q*3+1] + pts[q*3+2] * pts[q*3+2]);
+    }
+    grid->point_data[field->name] = field;
+
+    return grid;
+}
+
+} // namespace SyntheticMeshes
+
+#endif // SYNTHETICMESHES_HPP
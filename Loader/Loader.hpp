@@ -12,6 +12,9 @@
 #include <cstdint>
 #include <memory>
 
+class ArrayStatistics;
+class PointCells;
+
 // Generic container for data arrays (Scalars, Vectors, Fields)
 struct DataArray {
     std::string name;
@@ -45,6 +48,16 @@ struct UnstructuredGrid {
     // Attributes
     std::map<std::string, std::shared_ptr<DataArray>> point_data;
     std::map<std::string, std::shared_ptr<DataArray>> cell_data;
+
+    // Filled when points/cells were renumbered after loading: id in the file of each point/cell
+    std::vector<uint32_t> original_point_ids;
+    std::vector<uint32_t> original_cell_ids;
+
+    // Per-array statistics cache, created on first use by ArrayStatistics::of()
+    std::shared_ptr<ArrayStatistics> statistics;
+
+    // Point-to-cell adjacency, created on first use by PointCells::of()
+    std::shared_ptr<PointCells> point_cells;
 };
 
 class Loader
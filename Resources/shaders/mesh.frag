@@ -11,7 +11,38 @@ uniform int colorMode;
 uniform float scalarMin;
 uniform float scalarMax;
 uniform int twoSidedLighting; // 0: 单面, 1: 双面
-uniform int renderPoints;     // 0: 三角形, 1: 点渲染
+uniform int renderPoints;     // 0: 三角形, 1: 点渲染, 2: 线单元
+uniform int primitiveOffset = 0;  // 分部件绘制时本次绘制的首个三角形
+
+layout(std430, binding = 1) readonly buffer TriangleCells { uint triangleCells[]; };
+
+// GPU标量查找: 原始数组以SSBO上传, 在着色器中选择分量或计算模长
+layout(std430, binding = 0) readonly buffer ArrayValues { float arrayValues[]; };
+uniform int scalarLookup = 0;     // 0: 使用aScalar (CPU映射), 1: 点数据, 2: 单元数据
+uniform int arrayComponents = 1;
+uniform int arrayComponent = -1;  // -1: 模长
+uniform uint arrayTuples = 0u;
+
+float lookupScalar(uint tuple)
+{
+    if (tuple >= arrayTuples) return 0.5;
+    uint base = tuple * uint(arrayComponents);
+    float value;
+    if (arrayComponents == 1) {
+        value = arrayValues[base];
+    } else if (arrayComponent >= 0) {
+        value = arrayValues[base + uint(arrayComponent)];
+    } else {
+        float sumSq = 0.0;
+        for (int c = 0; c < arrayComponents; ++c) {
+            float v = arrayValues[base + uint(c)];
+            sumSq += v * v;
+        }
+        value = sqrt(sumSq);
+    }
+    float range = scalarMax - scalarMin;
+    return (value - scalarMin) / (range < 1e-10 ? 1.0 : range);
+}
 
 out vec4 fragColor;
 
@@ -79,15 +110,19 @@ vec3 rainbow(float t) {
 
 void main()
 {
-    // 圆形点渲染：丢弃圆形外的像素
-    if (renderPoints == 1) {
-        vec2 coord = gl_PointCoord * 2.0 - 1.0;  // 转换到 [-1, 1] 范围
-        float dist = dot(coord, coord);
-        if (dist > 1.0) {
-            discard;  // 丢弃圆形外的像素
+    // 点与线单元不参与光照
+    if (renderPoints >= 1) {
+        float alpha = 1.0;
+        // 圆形点渲染：丢弃圆形外的像素
+        if (renderPoints == 1) {
+            vec2 coord = gl_PointCoord * 2.0 - 1.0;  // 转换到 [-1, 1] 范围
+            float dist = dot(coord, coord);
+            if (dist > 1.0) {
+                discard;  // 丢弃圆形外的像素
+            }
+            // 可选：添加边缘抗锯齿
+            alpha = 1.0 - smoothstep(0.8, 1.0, dist);
         }
-        // 可选：添加边缘抗锯齿
-        float alpha = 1.0 - smoothstep(0.8, 1.0, dist);
         
         vec3 baseColor;
         if (physicalData == 0) {
@@ -111,6 +146,12 @@ void main()
         return;
     }
     
+    // 单元数据按三角形查找, 每个三角形颜色一致
+    float scalar = vScalar;
+    if (scalarLookup == 2) {
+        scalar = lookupScalar(triangleCells[primitiveOffset + gl_PrimitiveID]);
+    }
+    
     vec3 N = normalize(vNormal);
     vec3 L = normalize(lightDir);
     
@@ -136,13 +177,13 @@ void main()
     } else if (physicalData == 1 || physicalData == 2) {
         // 使用更鲜明的colormap
         if(colorMode==0)
-        {baseColor = viridis(vScalar);}
+        {baseColor = viridis(scalar);}
         else if(colorMode==1)
-        {baseColor = jet(vScalar);}
+        {baseColor = jet(scalar);}
         else if(colorMode==2)
-        {baseColor = rainbow(vScalar);}
+        {baseColor = rainbow(scalar);}
         else
-        {baseColor = viridis(vScalar);}
+        {baseColor = viridis(scalar);}
         // baseColor=viridis(vScalar);
     } else if (physicalData == 3) {
         baseColor = abs(N) * 0.5 + 0.5;
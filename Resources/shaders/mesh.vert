@@ -3,23 +3,87 @@
 layout(location = 0) in vec3 aPosition;
 layout(location = 1) in vec3 aNormal;
 layout(location = 2) in float aScalar;
+layout(location = 3) in uint aPointIndex;
 
 uniform mat4 mvp;
 uniform mat4 modelView;
 uniform mat3 normalMatrix;
 uniform float pointSize = 5.0;
 
+// 切片时裁剪平面前方的表面 (仅在启用GL_CLIP_DISTANCE0时生效)
+uniform vec4 clipPlane = vec4(0.0, 0.0, 0.0, 1.0);
+
+// 压缩顶点格式: 位置为包围盒内的unorm16, 法向为八面体编码的snorm16
+uniform int compactVertices = 0;
+uniform vec3 positionOrigin;
+uniform vec3 positionExtent;
+
+layout(std430, binding = 2) readonly buffer VertexCells { uint vertexCells[]; };
+uniform int renderPoints;
+
+// GPU标量查找: 原始数组以SSBO上传, 在着色器中选择分量或计算模长
+layout(std430, binding = 0) readonly buffer ArrayValues { float arrayValues[]; };
+uniform int scalarLookup = 0;     // 0: 使用aScalar (CPU映射), 1: 点数据, 2: 单元数据
+uniform int arrayComponents = 1;
+uniform int arrayComponent = -1;  // -1: 模长
+uniform uint arrayTuples = 0u;
+uniform float scalarMin;
+uniform float scalarMax;
+
+float lookupScalar(uint tuple)
+{
+    if (tuple >= arrayTuples) return 0.5;
+    uint base = tuple * uint(arrayComponents);
+    float value;
+    if (arrayComponents == 1) {
+        value = arrayValues[base];
+    } else if (arrayComponent >= 0) {
+        value = arrayValues[base + uint(arrayComponent)];
+    } else {
+        float sumSq = 0.0;
+        for (int c = 0; c < arrayComponents; ++c) {
+            float v = arrayValues[base + uint(c)];
+            sumSq += v * v;
+        }
+        value = sqrt(sumSq);
+    }
+    float range = scalarMax - scalarMin;
+    return (value - scalarMin) / (range < 1e-10 ? 1.0 : range);
+}
+
 out vec3 vNormal;
 out vec3 vPosition;
 out float vScalar;
 
+vec3 octDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0) {
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(n);
+}
+
 void main()
 {
-    vec4 viewPos = modelView * vec4(aPosition, 1.0);
+    vec3 position = aPosition;
+    vec3 normal = aNormal;
+    if (compactVertices == 1) {
+        position = positionOrigin + aPosition * positionExtent;
+        normal = octDecode(aNormal.xy);
+    }
+    
+    vec4 viewPos = modelView * vec4(position, 1.0);
     vPosition = viewPos.xyz;
-    vNormal = normalize(normalMatrix * aNormal);
+    vNormal = normalize(normalMatrix * normal);
     vScalar = aScalar;
+    if (scalarLookup == 1) {
+        vScalar = lookupScalar(aPointIndex);
+    } else if (scalarLookup == 2 && renderPoints >= 1) {
+        vScalar = lookupScalar(vertexCells[gl_VertexID]);
+    }
     
-    gl_Position = mvp * vec4(aPosition, 1.0);
+    gl_Position = mvp * vec4(position, 1.0);
+    gl_ClipDistance[0] = dot(vec4(position, 1.0), clipPlane);
     gl_PointSize = pointSize;
 }
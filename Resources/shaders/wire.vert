@@ -6,7 +6,20 @@ layout(location = 2) in float aScalar;
 
 uniform mat4 mvp;
 
+// 切片裁剪平面 (见mesh.vert)
+uniform vec4 clipPlane = vec4(0.0, 0.0, 0.0, 1.0);
+
+// 压缩顶点格式 (见mesh.vert)
+uniform int compactVertices = 0;
+uniform vec3 positionOrigin;
+uniform vec3 positionExtent;
+
 void main()
 {
-    gl_Position = mvp * vec4(aPosition, 1.0);
+    vec3 position = aPosition;
+    if (compactVertices == 1) {
+        position = positionOrigin + aPosition * positionExtent;
+    }
+    gl_Position = mvp * vec4(position, 1.0);
+    gl_ClipDistance[0] = dot(vec4(position, 1.0), clipPlane);
 }